@@ -0,0 +1,44 @@
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+#include <string>
+
+#include "app_config.h"
+
+namespace {
+
+    nlohmann::json make_config(std::size_t metrics) {
+        nlohmann::json jsn = {
+            {"client_id", "pi-sim-01"},
+            {"broker", {{"host", "localhost"}, {"port", 1883}}},
+            {"interval_ms", 100},
+            {"metrics", nlohmann::json::array()}
+        };
+        for (std::size_t i = 0; i < metrics; ++i) {
+            const auto name = "metric_" + std::to_string(i);
+            jsn["metrics"].push_back({{"name", name}, {"unit", "C"}, {"start", 20.0}, {"step", 0.25}, {"topic_suffix", name}});
+        }
+        return jsn;
+    }
+
+} // namespace
+
+static void BM_ParseConfig(benchmark::State& state) {
+    const auto jsn = make_config(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        auto cfg = parse_config_or_throw(jsn);
+        benchmark::DoNotOptimize(cfg.metrics.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ParseConfig)->Arg(10)->Arg(1000)->Arg(10000);
+
+// text -> AppConfig, as load_config_or_throw does after reading the file
+static void BM_ParseConfigText(benchmark::State& state) {
+    const auto text = make_config(static_cast<std::size_t>(state.range(0))).dump();
+    for (auto _ : state) {
+        auto cfg = parse_config_or_throw(nlohmann::json::parse(text));
+        benchmark::DoNotOptimize(cfg.metrics.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(text.size()));
+}
+BENCHMARK(BM_ParseConfigText)->Arg(10)->Arg(1000)->Arg(10000);
@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+namespace {
+
+    // log lines go to stderr; keep them off the terminal while measuring
+    class StderrToDevNull {
+        public:
+            StderrToDevNull() : saved_(::dup(STDERR_FILENO)) {
+                std::fflush(stderr);
+                const int null_fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+                ::dup2(null_fd, STDERR_FILENO);
+                ::close(null_fd);
+            }
+            ~StderrToDevNull() {
+                std::fflush(stderr);
+                ::dup2(saved_, STDERR_FILENO);
+                ::close(saved_);
+            }
+
+            StderrToDevNull(const StderrToDevNull&) = delete;
+            StderrToDevNull& operator = (const StderrToDevNull&) = delete;
+
+        private:
+            int saved_;
+    };
+
+} // namespace
+
+// below the runtime level: one relaxed load, the message is never built
+static void BM_LogDisabledLevel(benchmark::State& state) {
+    logger::set_level(logger::Level::Info);
+    std::uint64_t seq = 0;
+    for (auto _ : state) {
+        LOG_DEBUG("published seq=" + std::to_string(seq++));
+    }
+}
+BENCHMARK(BM_LogDisabledLevel);
+
+static void BM_LogWriteSync(benchmark::State& state) {
+    StderrToDevNull quiet;
+    logger::set_level(logger::Level::Info);
+    for (auto _ : state) {
+        logger::write(logger::Level::Info, __FILE__, __LINE__, "published telemetry message");
+    }
+}
+BENCHMARK(BM_LogWriteSync);
+
+// caller-side cost with the background writer. Writes come in batches that fit the per-thread
+// buffer, drained with the timer paused, so each one is a buffered record rather than a drop.
+static void BM_LogWriteAsync(benchmark::State& state) {
+    StderrToDevNull quiet;
+    logger::set_level(logger::Level::Info);
+    logger::start_async();
+    logger::flush();
+    const auto dropped_before = logger::dropped();
+    std::size_t batched = 0;
+    for (auto _ : state) {
+        if (batched == logger::thread_buffer_records) {
+            state.PauseTiming();
+            logger::flush();
+            batched = 0;
+            state.ResumeTiming();
+        }
+        logger::write(logger::Level::Info, __FILE__, __LINE__, "published telemetry message");
+        ++batched;
+    }
+    state.counters["dropped"] = static_cast<double>(logger::dropped() - dropped_before);
+    logger::stop_async();
+}
+BENCHMARK(BM_LogWriteAsync);
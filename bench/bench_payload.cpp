@@ -0,0 +1,50 @@
+#include <benchmark/benchmark.h>
+#include <string>
+
+#include "payload_format.h"
+#include "payload_writer.h"
+#include "telemetry_payload.h"
+#include "topic_builder.h"
+
+static void BM_MakePayloadV1Dump(benchmark::State& state) {
+    std::uint64_t seq = 0;
+    for (auto _ : state) {
+        const auto payload = make_payload_v1("pi-sim-01", "temperature", "C", 21.5, seq++, 1700000000).dump();
+        benchmark::DoNotOptimize(payload.data());
+    }
+}
+BENCHMARK(BM_MakePayloadV1Dump);
+
+// the preformatted writer the publisher uses for the same JSON v1 bytes
+static void BM_TelemetryPayloadWriter(benchmark::State& state) {
+    TelemetryPayloadWriter writer("pi-sim-01", "temperature", "C");
+    std::uint64_t seq = 0;
+    for (auto _ : state) {
+        const auto payload = writer.write(21.5, seq++, 1700000000);
+        benchmark::DoNotOptimize(payload.data());
+    }
+}
+BENCHMARK(BM_TelemetryPayloadWriter);
+
+// encode_payload for each payload_format (argument: index into payload_format_table)
+static void BM_EncodePayload(benchmark::State& state) {
+    const auto& entry = payload_format_table[static_cast<std::size_t>(state.range(0))];
+    const auto payload = make_payload_v1("pi-sim-01", "temperature", "C", 21.75, 17, 1771375779);
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        const auto encoded = encode_payload(payload, entry.fmt);
+        bytes = encoded.size();
+        benchmark::DoNotOptimize(encoded.data());
+    }
+    state.SetLabel(std::string(entry.name));
+    state.counters["bytes"] = static_cast<double>(bytes);
+}
+BENCHMARK(BM_EncodePayload)->DenseRange(0, static_cast<int>(payload_format_table.size()) - 1);
+
+static void BM_MakeTopic(benchmark::State& state) {
+    for (auto _ : state) {
+        const auto topic = make_topic("pi-sim-01", "temperature");
+        benchmark::DoNotOptimize(topic.data());
+    }
+}
+BENCHMARK(BM_MakeTopic);
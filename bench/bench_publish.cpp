@@ -0,0 +1,199 @@
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <mosquitto.h>
+
+#include "latency_histogram.h"
+#include "logger.h"
+#include "mqtt_client.h"
+#include "payload_writer.h"
+#include "topic_builder.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+    // process CPU time, so mosquitto's network thread is included
+    double process_cpu_us() {
+        timespec ts{};
+        ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return static_cast<double>(ts.tv_sec) * 1e6 + static_cast<double>(ts.tv_nsec) / 1e3;
+    }
+
+    std::string env_or(const char* name, const char* fallback) {
+        const char* value = std::getenv(name);
+        return value && *value ? value : fallback;
+    }
+
+    // TELEMETRY_TEST_BROKER=host:port (as the broker tests), else BENCH_MQTT_HOST / BENCH_MQTT_PORT
+    std::pair<std::string, int> bench_broker() {
+        std::string host = env_or("TELEMETRY_TEST_BROKER", "");
+        if (host.empty()) return {env_or("BENCH_MQTT_HOST", "localhost"), std::atoi(env_or("BENCH_MQTT_PORT", "1883").c_str())};
+        int port = 1883;
+        if (const auto colon = host.rfind(':'); colon != std::string::npos) {
+            port = std::atoi(host.c_str() + colon + 1);
+            host.resize(colon);
+        }
+        return {host, port};
+    }
+
+} // namespace
+
+// End to end through MqttClient to a broker (bench_broker(), default localhost:1883); skipped
+// when none is reachable. Each iteration is one publish, retried while
+// the in-flight window is full. msg_per_s and cpu_us_per_msg cover delivery of every message.
+static void BM_PublishEndToEnd(benchmark::State& state) {
+    const int qos = static_cast<int>(state.range(0));
+    const auto [host, port] = bench_broker();
+
+    logger::set_level(logger::Level::Error);
+    mosquitto_lib_init();
+    {
+        MqttClient mqtt(host, port, "telemetry-bench-qos" + std::to_string(qos), qos);
+        mqtt.set_max_inflight(100);
+        if (mqtt.connect(10)) {
+            for (int i = 0; i < 50 && !mqtt.connected(); ++i) std::this_thread::sleep_for(100ms);
+        }
+        if (!mqtt.connected()) {
+            state.SkipWithError(("no broker at " + host + ":" + std::to_string(port)).c_str());
+            mqtt.stop();
+            mosquitto_lib_cleanup();
+            return;
+        }
+
+        const auto topic = make_topic("telemetry-bench", "temperature");
+        TelemetryPayloadWriter writer("telemetry-bench", "temperature", "C");
+        std::uint64_t seq = 0;
+        LatencyWindow ack_window;
+        ack_window.update(mqtt.ack_latency());
+        const auto delivered_before = mqtt.delivered();
+        const double cpu_before = process_cpu_us();
+        const auto wall_before = std::chrono::steady_clock::now();
+
+        bool lost = false;
+        for (auto _ : state) {
+            const auto payload = writer.write(21.5, seq, 1700000000);
+            while (!mqtt.publish(topic, payload, qos)) {
+                if ((lost = !mqtt.connected())) break;
+                std::this_thread::yield();
+            }
+            // the state loop must not go on after SkipWithError
+            if (lost) {
+                state.SkipWithError("broker connection lost");
+                break;
+            }
+            ++seq;
+        }
+        if (lost) {
+            mqtt.stop();
+            mosquitto_lib_cleanup();
+            return;
+        }
+        mqtt.drain(5s);
+        // QoS 0 completes once written; wait for the network thread to flush the tail
+        for (int i = 0; i < 500 && mqtt.delivered() - delivered_before < seq; ++i) std::this_thread::sleep_for(1ms);
+
+        // delivered messages over wall time including the drain, not just the publish calls
+        const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_before).count();
+        const double cpu_us = process_cpu_us() - cpu_before;
+        const auto messages = static_cast<double>(mqtt.delivered() - delivered_before);
+        state.counters["msg_per_s"] = wall_s > 0.0 ? messages / wall_s : 0.0;
+        state.counters["cpu_us_per_msg"] = messages > 0 ? cpu_us / messages : 0.0;
+        if (qos > 0) state.counters["ack_p99_us"] = static_cast<double>(ack_window.update(mqtt.ack_latency()).p99);
+        mqtt.stop();
+    }
+    mosquitto_lib_cleanup();
+}
+BENCHMARK(BM_PublishEndToEnd)->Arg(0)->Arg(1)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+// broker.connections = range(0): QoS 1 telemetry of 16 topics hashed over the sessions with
+// topic_shard(), as TelemetryPublisher routes it, from one publishing thread. Each iteration is
+// one publish to the next topic, retried while that session's window is full. Batch mode sends
+// everything to one topic, so it stays on one session and gains nothing from sharding.
+static void BM_PublishSharded(benchmark::State& state) {
+    const auto connections = static_cast<std::size_t>(state.range(0));
+    const auto [host, port] = bench_broker();
+
+    logger::set_level(logger::Level::Error);
+    mosquitto_lib_init();
+    {
+        std::vector<std::unique_ptr<MqttClient>> sessions;
+        for (std::size_t i = 0; i < connections; ++i) {
+            const std::string client_id = i == 0 ? "telemetry-bench" : make_shard_client_id("telemetry-bench", i);
+            auto mqtt = std::make_unique<MqttClient>(host, port, client_id, 1);
+            if (i != 0) mqtt->disable_status();
+            mqtt->set_max_inflight(100);
+            (void)mqtt->connect(10);
+            sessions.push_back(std::move(mqtt));
+        }
+        const auto all_connected = [&] {
+            for (const auto& mqtt : sessions) {
+                if (!mqtt->connected()) return false;
+            }
+            return true;
+        };
+        for (int i = 0; i < 50 && !all_connected(); ++i) std::this_thread::sleep_for(100ms);
+        if (!all_connected()) {
+            state.SkipWithError(("no broker at " + host + ":" + std::to_string(port)).c_str());
+            for (auto& mqtt : sessions) mqtt->stop();
+            sessions.clear();
+            mosquitto_lib_cleanup();
+            return;
+        }
+
+        constexpr std::size_t topic_count = 16;
+        std::vector<std::string> topics;
+        std::vector<MqttClient*> route;
+        for (std::size_t i = 0; i < topic_count; ++i) {
+            topics.push_back(make_topic("telemetry-bench", "m" + std::to_string(i)));
+            route.push_back(sessions[topic_shard(topics.back(), connections)].get());
+        }
+
+        TelemetryPayloadWriter writer("telemetry-bench", "temperature", "C");
+        std::uint64_t seq = 0;
+        std::uint64_t delivered_before = 0;
+        for (const auto& mqtt : sessions) delivered_before += mqtt->delivered();
+        const double cpu_before = process_cpu_us();
+        const auto wall_before = std::chrono::steady_clock::now();
+
+        bool lost = false;
+        for (auto _ : state) {
+            const auto payload = writer.write(21.5, seq, 1700000000);
+            auto& mqtt = *route[seq % topic_count];
+            while (!mqtt.publish(topics[seq % topic_count], payload, 1)) {
+                if ((lost = !mqtt.connected())) break;
+                std::this_thread::yield();
+            }
+            if (lost) {
+                state.SkipWithError("broker connection lost");
+                break;
+            }
+            ++seq;
+        }
+        if (lost) {
+            for (auto& mqtt : sessions) mqtt->stop();
+            sessions.clear();
+            mosquitto_lib_cleanup();
+            return;
+        }
+        for (auto& mqtt : sessions) mqtt->drain(5s);
+
+        const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_before).count();
+        const double cpu_us = process_cpu_us() - cpu_before;
+        std::uint64_t delivered = 0;
+        for (const auto& mqtt : sessions) delivered += mqtt->delivered();
+        const auto messages = static_cast<double>(delivered - delivered_before);
+        state.counters["msg_per_s"] = wall_s > 0.0 ? messages / wall_s : 0.0;
+        state.counters["cpu_us_per_msg"] = messages > 0 ? cpu_us / messages : 0.0;
+        for (auto& mqtt : sessions) mqtt->stop();
+    }
+    mosquitto_lib_cleanup();
+}
+BENCHMARK(BM_PublishSharded)->RangeMultiplier(2)->Range(1, 8)->UseRealTime()->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,24 @@
+#include <benchmark/benchmark.h>
+
+#include "simulated_sensor.h"
+
+static void BM_SimulatedSensorSample(benchmark::State& state) {
+    SimulatedSensor sensor("temperature", "C", 20.0, 0.25);
+    sensor.init();
+    for (auto _ : state) {
+        auto reading = sensor.sample();
+        benchmark::DoNotOptimize(reading);
+    }
+}
+BENCHMARK(BM_SimulatedSensorSample);
+
+// the allocation-free path used by SensorGroup
+static void BM_SimulatedSensorRead(benchmark::State& state) {
+    SimulatedSensor sensor("temperature", "C", 20.0, 0.25);
+    sensor.init();
+    for (auto _ : state) {
+        auto value = sensor.read();
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK(BM_SimulatedSensorRead);
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+// Measures publish -> PUBACK/PUBCOMP round trips by message id without locks.
+//
+// Each mid hashes to one slot holding (mid, flag, time) packed into a 64-bit atomic.
+// publish() records the send time once mosquitto has assigned the mid. The network thread's
+// on_publish callback may run before that (fast broker); it then leaves its ack time in the
+// slot with the flag set, and the sender completes the measurement instead. A slot reused by
+// a newer mid simply loses the older sample, so the slots only need to cover the messages in
+// flight at once.
+class AckTimer {
+    public:
+        using Clock     = std::chrono::steady_clock;
+        using TimePoint = Clock::time_point;
+
+        static constexpr std::size_t k_default_slots = 1024;
+
+        explicit AckTimer(std::size_t slots = k_default_slots) { resize(slots); }
+
+        // not thread-safe; call before the first message is sent
+        void resize(std::size_t slots) {
+            slot_count_ = slots > 0 ? slots : 1;
+            slots_ = std::make_unique<std::atomic<std::uint64_t>[]>(slot_count_);
+        }
+        std::size_t slots() const noexcept { return slot_count_; }
+
+        // sender side; returns the round trip if the ack already arrived
+        std::optional<Clock::duration> on_sent(int mid, TimePoint sent_at) noexcept {
+            auto& slot = slots_[slot_of_(mid)];
+            const std::uint64_t sent = pack_(mid, false, sent_at);
+            const std::uint64_t old = slot.exchange(sent, std::memory_order_acq_rel);
+            if (mid_of_(old) != mid_bits_(mid) || !acked_(old)) return std::nullopt;
+            // an ack older than this send is left over from a previous use of the mid (e.g. QoS 0)
+            if (time_of_(old) < time_of_(sent)) return std::nullopt;
+
+            std::uint64_t expected = sent;
+            slot.compare_exchange_strong(expected, 0, std::memory_order_acq_rel);
+            return time_of_(old) - time_of_(sent);
+        }
+
+        // callback side; returns the round trip if the send was already recorded
+        std::optional<Clock::duration> on_acked(int mid, TimePoint acked_at) noexcept {
+            auto& slot = slots_[slot_of_(mid)];
+            std::uint64_t cur = slot.load(std::memory_order_acquire);
+            for (;;) {
+                if (mid_of_(cur) == mid_bits_(mid) && !acked_(cur)) {
+                    if (slot.compare_exchange_weak(cur, 0, std::memory_order_acq_rel)) {
+                        return acked_at - time_of_(cur);
+                    }
+                    continue;
+                }
+                if (slot.compare_exchange_weak(cur, pack_(mid, true, acked_at), std::memory_order_acq_rel)) {
+                    return std::nullopt;
+                }
+            }
+        }
+
+    private:
+        // layout: mid (16) | acked flag (1) | microseconds since epoch_ (47, ~4.4 years)
+        static constexpr int k_time_bits = 47;
+        static constexpr std::uint64_t k_time_mask = (std::uint64_t{1} << k_time_bits) - 1;
+        static constexpr std::uint64_t k_acked_bit = std::uint64_t{1} << k_time_bits;
+
+        std::size_t slot_of_(int mid) const noexcept { return static_cast<std::size_t>(mid_bits_(mid)) % slot_count_; }
+        static std::uint64_t mid_bits_(int mid) noexcept { return static_cast<std::uint64_t>(mid) & 0xFFFF; }
+        static std::uint64_t mid_of_(std::uint64_t packed) noexcept { return packed >> (k_time_bits + 1); }
+        static bool acked_(std::uint64_t packed) noexcept { return (packed & k_acked_bit) != 0; }
+
+        std::uint64_t pack_(int mid, bool acked, TimePoint at) const noexcept {
+            const auto us = std::chrono::duration_cast<std::chrono::microseconds>(at - epoch_).count();
+            const std::uint64_t time = us < 0 ? 0 : static_cast<std::uint64_t>(us) & k_time_mask;
+            return (mid_bits_(mid) << (k_time_bits + 1)) | (acked ? k_acked_bit : 0) | time;
+        }
+
+        TimePoint time_of_(std::uint64_t packed) const noexcept {
+            return epoch_ + std::chrono::microseconds(packed & k_time_mask);
+        }
+
+        const TimePoint epoch_ = Clock::now();
+        std::unique_ptr<std::atomic<std::uint64_t>[]> slots_;
+        std::size_t slot_count_ = 0;
+};
@@ -1,53 +1,350 @@
 #pragma once
 
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <charconv>
 #include <fstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "broker_selector.h"
+#include "payload_format.h"
+#include "ring_buffer.h"
+
+// publish windowed statistics instead of every sample
+struct AggregateConfig {
+    int window_ms = 0;          // 0 = publish every sample
+    int slide_ms = 0;           // 0 = tumbling window; otherwise a summary every slide_ms over the last window_ms
+    bool percentiles = false;   // add approximate p50/p90/p99
+    int max_samples = 1024;     // percentile samples kept per window; faster rates are decimated
+
+    bool operator == (const AggregateConfig&) const = default;
+};
+
 struct MetricConfig {
     std::string name;
     std::string unit;
     double start = 0.0;
     double step = 0.0;
     std::string topic_suffix;
+    int interval_ms = 0; // 0 = use AppConfig::interval_ms
+
+    // report-by-exception; all 0 = publish every sample
+    double deadband_abs = 0.0; // publish when the value moves more than this...
+    double deadband_pct = 0.0; // ...or this percentage of the last published value, whichever is larger
+    int max_silence_ms = 0;    // republish an unchanged value after this long; 0 = never
+
+    AggregateConfig aggregate;
 
     std::string type = "simulated";
     int bus = 1; // for i2c
     std::string address = "0x76"; // for i2c
+
+    // system sensors (cpu, meminfo, netdev, thermal, hwmon)
+    std::string source;  // cpu line ("cpu", "cpu2"), meminfo key, interface, thermal zone or hwmon input path
+    std::string field;   // netdev counter, e.g. rx_bytes
+    double scale = 0.0;  // multiplier for the raw value; 0 = the type's default
+
+    bool operator == (const MetricConfig&) const = default;
+};
+
+struct BatchConfig {
+    bool enabled = false;
+    int max_ticks = 1;            // flush after this many scheduler ticks
+    int max_bytes = 16384;        // or once the payload would exceed this size
+    bool per_metric_topics = false; // keep publishing devices/<client_id>/<topic_suffix> as well
+
+    bool operator == (const BatchConfig&) const = default;
+};
+
+// readings that could not be published are kept in memory and replayed after reconnect
+struct StoreForwardConfig {
+    int capacity = 1024;         // readings; 0 disables buffering
+    OverflowPolicy policy = OverflowPolicy::DropOldest;
+    int replay_per_s = 100;      // replay rate limit so a backlog doesn't flood the broker
+
+    bool operator == (const StoreForwardConfig&) const = default;
+};
+
+// on-disk spool for long outages; replaces the in-memory buffer when enabled
+struct SpoolConfig {
+    bool enabled = false;
+    std::string dir = "/var/lib/telemetry-daemon/spool";
+    int max_mb = 64;             // oldest segments are deleted beyond this
+    int max_age_h = 168;         // older records are discarded instead of sent
+    int segment_kb = 1024;
+    int flush_records = 64;      // write + fdatasync after this many records
+    int flush_interval_ms = 1000; // or after this long
+
+    bool operator == (const SpoolConfig&) const = default;
+};
+
+// zlib compression of telemetry payloads (health and status stay uncompressed)
+struct CompressionConfig {
+    bool enabled = false;
+    int min_bytes = 256;         // smaller payloads are sent as-is
+    int level = 6;               // zlib 1..9
+    std::string dictionary;      // preset dictionary file; empty = none
+
+    bool operator == (const CompressionConfig&) const = default;
+};
+
+// local OpenMetrics scrape endpoint; listen is "unix:<path>" or "127.0.0.1:<port>" (loopback only)
+struct MetricsEndpointConfig {
+    bool enabled = false;
+    std::string listen = "127.0.0.1:9464";
+    std::string unix_path; // parsed from listen; empty = TCP on 127.0.0.1
+    int port = 9464;
+
+    bool operator == (const MetricsEndpointConfig&) const = default;
+};
+
+// broker.failover; only used with more than one entry in brokers
+struct FailoverConfig {
+    FailoverPolicy policy = FailoverPolicy::Priority;
+    int failback_after_s = 30;  // connected to a fallback this long before trying a preferred broker again
+    int connect_timeout_s = 5;  // attempts without CONNACK by then count as failed
+
+    bool operator == (const FailoverConfig&) const = default;
+};
+
+// --fleet load-generator mode
+struct FleetConfig {
+    int threads = 4;            // event-loop threads shared by all simulated devices
+    int ramp_per_s = 100;       // new connections per second at start-up
+    int phase_spread_ms = 0;    // first publishes spread over this span; 0 = the whole interval_ms
+    int report_interval_s = 10; // aggregate msg/s and latency log period
 };
 
 struct AppConfig {
     std::string log_level = "info";
-    std::string host = "localhost";
+    std::string host = "localhost"; // the preferred entry of brokers
     int port = 1883;
+    std::vector<BrokerEndpoint> brokers; // broker.host/port when the config has no brokers list
+    FailoverConfig failover;
     int keepalive_s = 60;
+    bool mqtt5 = false;          // broker.protocol: "mqtt311" or "mqtt5"
+    bool topic_aliases = true;   // MQTT 5 only
+    int message_expiry_s = 0;    // MQTT 5 only; 0 = messages never expire
+    int max_inflight = 20;       // unacked QoS 1/2 messages before publishing backs off; 0 = unbounded
+    int drain_timeout_ms = 5000; // shutdown waits this long for acks (keep below systemd TimeoutStopSec)
+    int connections = 1;         // MQTT sessions telemetry topics are hashed across (threads event loop only)
 
     std::string client_id = "pi-sim-01";
     int interval_ms = 100;
+    int health_interval_ms = 10000; // health heartbeat period, independent of interval_ms
 
     int qos = 1;
     bool retain = false;
 
+    bool epoll_loop = false;     // event_loop: "threads" (sampler + mosquitto network threads) or "epoll"
+
+    PayloadFormat payload_format = PayloadFormat::JsonV1;
+    int schema_version = 1;      // telemetry payload schema; 2 adds timestamp_ms
+    BatchConfig batch;
+    StoreForwardConfig store_forward;
+    SpoolConfig spool;
+    CompressionConfig compression;
+    MetricsEndpointConfig metrics_endpoint;
+    FleetConfig fleet;
+
     std::vector<MetricConfig> metrics;
 };
 
+inline int effective_interval_ms(const AppConfig& cfg, const MetricConfig& metric) {
+    return metric.interval_ms > 0 ? metric.interval_ms : cfg.interval_ms;
+}
+
+inline void validate_aggregate(const AppConfig& cfg, MetricConfig& metric) {
+    auto& agg = metric.aggregate;
+    if (agg.window_ms < 0) throw std::runtime_error("aggregate.window_ms must be >= 0");
+    if (agg.window_ms == 0) return;
+
+    if (agg.slide_ms == 0) agg.slide_ms = agg.window_ms;
+    if (agg.slide_ms < 0 || agg.window_ms % agg.slide_ms != 0) {
+        throw std::runtime_error("aggregate.slide_ms must divide aggregate.window_ms");
+    }
+    if (agg.window_ms / agg.slide_ms > 64) throw std::runtime_error("aggregate.window_ms may span at most 64 slides");
+    if (agg.slide_ms < effective_interval_ms(cfg, metric)) {
+        throw std::runtime_error("aggregate.slide_ms must be >= the metric's interval_ms");
+    }
+    if (agg.max_samples <= 0) throw std::runtime_error("aggregate.max_samples must be > 0");
+    if (metric.deadband_abs > 0.0 || metric.deadband_pct > 0.0 || metric.max_silence_ms > 0) {
+        throw std::runtime_error("metric " + metric.name + " cannot use both aggregate and deadband settings");
+    }
+}
+
 inline AppConfig parse_config_or_throw(const nlohmann::json& jsn) {
     AppConfig cfg;
 
     cfg.log_level = jsn.value("log_level", cfg.log_level);
+
+    const std::string event_loop = jsn.value("event_loop", std::string("threads"));
+    if (event_loop == "epoll") cfg.epoll_loop = true;
+    else if (event_loop != "threads") throw std::runtime_error("event_loop must be threads or epoll");
     if (jsn.contains("broker")) {
         const auto& broker = jsn.at("broker");
         cfg.host = broker.value("host", cfg.host);
         cfg.port = broker.value("port", cfg.port);
         cfg.keepalive_s = broker.value("keepalive_s", cfg.keepalive_s);
+
+        const std::string protocol = broker.value("protocol", std::string("mqtt311"));
+        if (protocol == "mqtt5") cfg.mqtt5 = true;
+        else if (protocol != "mqtt311") throw std::runtime_error("broker.protocol must be mqtt311 or mqtt5");
+        cfg.topic_aliases = broker.value("topic_aliases", cfg.topic_aliases);
+        cfg.message_expiry_s = broker.value("message_expiry_s", cfg.message_expiry_s);
+        if (cfg.message_expiry_s < 0) throw std::runtime_error("broker.message_expiry_s must be >= 0");
+        cfg.max_inflight = broker.value("max_inflight", cfg.max_inflight);
+        cfg.drain_timeout_ms = broker.value("drain_timeout_ms", cfg.drain_timeout_ms);
+        if (cfg.max_inflight < 0) throw std::runtime_error("broker.max_inflight must be >= 0");
+        if (cfg.drain_timeout_ms < 0 || cfg.drain_timeout_ms > 9000) {
+            throw std::runtime_error("broker.drain_timeout_ms must be between 0 and 9000 (systemd stops the unit after 10s)");
+        }
+
+        cfg.connections = broker.value("connections", cfg.connections);
+        if (cfg.connections < 1 || cfg.connections > 64) throw std::runtime_error("broker.connections must be between 1 and 64");
+        if (cfg.connections > 1 && cfg.epoll_loop) throw std::runtime_error("broker.connections > 1 needs event_loop threads");
+
+        if (broker.contains("failover")) {
+            const auto& failover = broker.at("failover");
+            const std::string policy = failover.value("policy", std::string(failover_policy_name(cfg.failover.policy)));
+            if (!try_parse_failover_policy(policy, cfg.failover.policy)) {
+                throw std::runtime_error("broker.failover.policy must be priority or sticky");
+            }
+            cfg.failover.failback_after_s = failover.value("failback_after_s", cfg.failover.failback_after_s);
+            cfg.failover.connect_timeout_s = failover.value("connect_timeout_s", cfg.failover.connect_timeout_s);
+            if (cfg.failover.failback_after_s <= 0) throw std::runtime_error("broker.failover.failback_after_s must be > 0");
+            if (cfg.failover.connect_timeout_s <= 0) throw std::runtime_error("broker.failover.connect_timeout_s must be > 0");
+        }
+    }
+
+    if (jsn.contains("brokers")) {
+        const auto& brokers = jsn.at("brokers");
+        if (!brokers.is_array() || brokers.empty()) throw std::runtime_error("brokers must be a non-empty array");
+        for (const auto& entry : brokers) {
+            BrokerEndpoint endpoint;
+            endpoint.host = entry.value("host", std::string{});
+            endpoint.port = entry.value("port", endpoint.port);
+            endpoint.priority = entry.value("priority", endpoint.priority);
+            if (endpoint.host.empty()) throw std::runtime_error("brokers[].host is required");
+            if (endpoint.port < 1 || endpoint.port > 65535) throw std::runtime_error("brokers[].port must be 1-65535");
+            cfg.brokers.push_back(std::move(endpoint));
+        }
+        const auto preferred = std::min_element(cfg.brokers.begin(), cfg.brokers.end(),
+            [](const BrokerEndpoint& a, const BrokerEndpoint& b) { return a.priority < b.priority; });
+        cfg.host = preferred->host;
+        cfg.port = preferred->port;
+    } else {
+        cfg.brokers.push_back(BrokerEndpoint{cfg.host, cfg.port, 0});
     }
     cfg.client_id = jsn.value("client_id", cfg.client_id);
     cfg.interval_ms = jsn.value("interval_ms", cfg.interval_ms);
+    cfg.health_interval_ms = jsn.value("health_interval_ms", cfg.health_interval_ms);
     cfg.qos = jsn.value("qos", cfg.qos);
     cfg.retain = jsn.value("retain", cfg.retain);
+
+    cfg.schema_version = jsn.value("schema_version", cfg.schema_version);
+    if (cfg.schema_version != 1 && cfg.schema_version != 2) throw std::runtime_error("schema_version must be 1 or 2");
+
+    const std::string payload_format = jsn.value("payload_format", std::string(payload_format_name(cfg.payload_format)));
+    if (!try_parse_payload_format(payload_format, cfg.payload_format)) {
+        throw std::runtime_error("payload_format must be json_v1, cbor, or msgpack");
+    }
     
+    if (jsn.contains("batch")) {
+        const auto& batch = jsn.at("batch");
+        cfg.batch.enabled = batch.value("enabled", cfg.batch.enabled);
+        cfg.batch.max_ticks = batch.value("max_ticks", cfg.batch.max_ticks);
+        cfg.batch.max_bytes = batch.value("max_bytes", cfg.batch.max_bytes);
+        cfg.batch.per_metric_topics = batch.value("per_metric_topics", cfg.batch.per_metric_topics);
+
+        if (cfg.batch.max_ticks <= 0) throw std::runtime_error("batch.max_ticks must be > 0");
+        if (cfg.batch.max_bytes <= 0) throw std::runtime_error("batch.max_bytes must be > 0");
+    }
+
+    if (jsn.contains("store_forward")) {
+        const auto& sf = jsn.at("store_forward");
+        cfg.store_forward.capacity = sf.value("capacity", cfg.store_forward.capacity);
+        cfg.store_forward.replay_per_s = sf.value("replay_per_s", cfg.store_forward.replay_per_s);
+
+        const std::string policy = sf.value("policy", std::string(overflow_policy_name(cfg.store_forward.policy)));
+        if (!try_parse_overflow_policy(policy, cfg.store_forward.policy)) {
+            throw std::runtime_error("store_forward.policy must be drop_oldest or drop_newest");
+        }
+        if (cfg.store_forward.capacity < 0) throw std::runtime_error("store_forward.capacity must be >= 0");
+        if (cfg.store_forward.replay_per_s <= 0) throw std::runtime_error("store_forward.replay_per_s must be > 0");
+    }
+
+    if (jsn.contains("spool")) {
+        const auto& spool = jsn.at("spool");
+        cfg.spool.enabled = spool.value("enabled", cfg.spool.enabled);
+        cfg.spool.dir = spool.value("dir", cfg.spool.dir);
+        cfg.spool.max_mb = spool.value("max_mb", cfg.spool.max_mb);
+        cfg.spool.max_age_h = spool.value("max_age_h", cfg.spool.max_age_h);
+        cfg.spool.segment_kb = spool.value("segment_kb", cfg.spool.segment_kb);
+        cfg.spool.flush_records = spool.value("flush_records", cfg.spool.flush_records);
+        cfg.spool.flush_interval_ms = spool.value("flush_interval_ms", cfg.spool.flush_interval_ms);
+
+        if (cfg.spool.dir.empty()) throw std::runtime_error("spool.dir must not be empty");
+        if (cfg.spool.max_mb <= 0) throw std::runtime_error("spool.max_mb must be > 0");
+        if (cfg.spool.max_age_h < 0) throw std::runtime_error("spool.max_age_h must be >= 0");
+        if (cfg.spool.segment_kb <= 0 || cfg.spool.segment_kb * 2 > cfg.spool.max_mb * 1024) {
+            throw std::runtime_error("spool.segment_kb must be > 0 and at most half of spool.max_mb");
+        }
+        if (cfg.spool.flush_records <= 0) throw std::runtime_error("spool.flush_records must be > 0");
+        if (cfg.spool.flush_interval_ms <= 0) throw std::runtime_error("spool.flush_interval_ms must be > 0");
+    }
+
+    if (jsn.contains("compression")) {
+        const auto& comp = jsn.at("compression");
+        cfg.compression.enabled = comp.value("enabled", cfg.compression.enabled);
+        cfg.compression.min_bytes = comp.value("min_bytes", cfg.compression.min_bytes);
+        cfg.compression.level = comp.value("level", cfg.compression.level);
+        cfg.compression.dictionary = comp.value("dictionary", cfg.compression.dictionary);
+
+        if (cfg.compression.min_bytes < 0) throw std::runtime_error("compression.min_bytes must be >= 0");
+        if (cfg.compression.level < 1 || cfg.compression.level > 9) throw std::runtime_error("compression.level must be 1..9");
+    }
+
+    if (jsn.contains("metrics_endpoint")) {
+        const auto& endpoint = jsn.at("metrics_endpoint");
+        auto& out = cfg.metrics_endpoint;
+        out.enabled = endpoint.value("enabled", out.enabled);
+        out.listen = endpoint.value("listen", out.listen);
+
+        const std::string_view listen = out.listen;
+        if (listen.starts_with("unix:")) {
+            out.unix_path = out.listen.substr(5);
+            if (out.unix_path.empty()) throw std::runtime_error("metrics_endpoint.listen needs a socket path after unix:");
+        } else {
+            const std::size_t colon = listen.rfind(':');
+            const auto host = colon == std::string_view::npos ? std::string_view{} : listen.substr(0, colon);
+            if (host != "127.0.0.1" && host != "localhost") {
+                throw std::runtime_error("metrics_endpoint.listen must be unix:<path> or 127.0.0.1:<port>");
+            }
+            const auto port = listen.substr(colon + 1);
+            const auto res = std::from_chars(port.data(), port.data() + port.size(), out.port);
+            if (res.ec != std::errc{} || res.ptr != port.data() + port.size() || out.port < 1 || out.port > 65535) {
+                throw std::runtime_error("metrics_endpoint.listen has an invalid port");
+            }
+        }
+    }
+
+    if (jsn.contains("fleet")) {
+        const auto& fleet = jsn.at("fleet");
+        cfg.fleet.threads = fleet.value("threads", cfg.fleet.threads);
+        cfg.fleet.ramp_per_s = fleet.value("ramp_per_s", cfg.fleet.ramp_per_s);
+        cfg.fleet.phase_spread_ms = fleet.value("phase_spread_ms", cfg.fleet.phase_spread_ms);
+        cfg.fleet.report_interval_s = fleet.value("report_interval_s", cfg.fleet.report_interval_s);
+
+        if (cfg.fleet.threads < 1 || cfg.fleet.threads > 256) throw std::runtime_error("fleet.threads must be 1..256");
+        if (cfg.fleet.ramp_per_s <= 0) throw std::runtime_error("fleet.ramp_per_s must be > 0");
+        if (cfg.fleet.phase_spread_ms < 0) throw std::runtime_error("fleet.phase_spread_ms must be >= 0");
+        if (cfg.fleet.report_interval_s <= 0) throw std::runtime_error("fleet.report_interval_s must be > 0");
+    }
+
     if (!jsn.contains("metrics") || !jsn.at("metrics").is_array() || jsn.at("metrics").empty()) {
         throw std::runtime_error("Config must contain non-empty metrics array");
     }
@@ -56,6 +353,7 @@ inline AppConfig parse_config_or_throw(const nlohmann::json& jsn) {
     // cfg.log_level is checked in main to avoid intertwining app_config.h and logger.h
     if (cfg.client_id.empty()) throw std::runtime_error("client_id must not be empty");
     if (cfg.interval_ms <= 0) throw std::runtime_error("interval_ms must be > 0");
+    if (cfg.health_interval_ms < 1000) throw std::runtime_error("health_interval_ms must be >= 1000");
     if (cfg.qos < 0 || cfg.qos > 2) throw std::runtime_error("qos must be 0, 1, or 2");
 
     for (const auto& metric : jsn.at("metrics")) {
@@ -66,14 +364,33 @@ inline AppConfig parse_config_or_throw(const nlohmann::json& jsn) {
         metric_cfg.start = metric.value("start", 0.0);
         metric_cfg.step = metric.value("step", 0.0);
         metric_cfg.topic_suffix = metric.at("topic_suffix").get<std::string>();
+        metric_cfg.interval_ms = metric.value("interval_ms", 0);
+        metric_cfg.deadband_abs = metric.value("deadband_abs", 0.0);
+        metric_cfg.deadband_pct = metric.value("deadband_pct", 0.0);
+        metric_cfg.max_silence_ms = metric.value("max_silence_ms", 0);
+        if (metric.contains("aggregate")) {
+            const auto& agg = metric.at("aggregate");
+            metric_cfg.aggregate.window_ms = agg.value("window_ms", 0);
+            metric_cfg.aggregate.slide_ms = agg.value("slide_ms", 0);
+            metric_cfg.aggregate.percentiles = agg.value("percentiles", false);
+            metric_cfg.aggregate.max_samples = agg.value("max_samples", metric_cfg.aggregate.max_samples);
+        }
         
         metric_cfg.type = metric.value("type", "simulated");
         metric_cfg.bus = metric.value("bus", 1);
         metric_cfg.address = metric.value("address", "0x76");
+        metric_cfg.source = metric.value("source", "");
+        metric_cfg.field = metric.value("field", "");
+        metric_cfg.scale = metric.value("scale", 0.0);
 
         // validate metric
         if (metric_cfg.name.empty()) throw std::runtime_error("metric name must not be empty");
         if (metric_cfg.topic_suffix.empty()) throw std::runtime_error("topic_suffix must not be empty");
+        if (metric_cfg.interval_ms < 0) throw std::runtime_error("metric interval_ms must be >= 0");
+        if (!(metric_cfg.deadband_abs >= 0.0)) throw std::runtime_error("metric deadband_abs must be >= 0");
+        if (!(metric_cfg.deadband_pct >= 0.0)) throw std::runtime_error("metric deadband_pct must be >= 0");
+        if (metric_cfg.max_silence_ms < 0) throw std::runtime_error("metric max_silence_ms must be >= 0");
+        validate_aggregate(cfg, metric_cfg);
 
         cfg.metrics.push_back(std::move(metric_cfg));
     }
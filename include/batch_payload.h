@@ -0,0 +1,129 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "payload_writer.h"
+
+// Batch payload v1: every reading from one or more ticks in a single message.
+// {"device":{"client_id":...},"readings":[{"name","seq","timestamp_s","unit","value"},...],"schema_version":1}
+// v2 adds "timestamp_ms" to every reading.
+
+struct BatchReading {
+    std::string_view metric_name;
+    std::string_view unit;
+    double value;
+    std::uint64_t seq;
+    std::int64_t timestamp_s;
+    std::int64_t timestamp_ms = 0; // v2 only
+};
+
+inline nlohmann::json make_batch_payload_v1(std::string_view client_id, const std::vector<BatchReading>& readings) {
+    nlohmann::json items = nlohmann::json::array();
+    for (const auto& reading : readings) {
+        items.push_back({
+            {"name", reading.metric_name},
+            {"unit", reading.unit},
+            {"value", reading.value},
+            {"seq", reading.seq},
+            {"timestamp_s", reading.timestamp_s}
+        });
+    }
+    return {
+        {"schema_version", 1},
+        {"device", {{"client_id", client_id}}},
+        {"readings", std::move(items)}
+    };
+}
+
+inline nlohmann::json make_batch_payload_v2(std::string_view client_id, const std::vector<BatchReading>& readings) {
+    auto payload = make_batch_payload_v1(client_id, readings);
+    for (std::size_t i = 0; i < readings.size(); ++i) payload["readings"][i]["timestamp_ms"] = readings[i].timestamp_ms;
+    payload["schema_version"] = 2;
+    return payload;
+}
+
+// Allocation-free writer for batch payload v1, byte-identical to make_batch_payload_v1(...).dump()
+// (make_batch_payload_v2 with schema_version 2).
+// Metrics are registered once; append() then only formats the numbers.
+class BatchPayloadWriter {
+    public:
+        explicit BatchPayloadWriter(std::string_view client_id, int schema_version = 1)
+            : head_("{\"device\":{\"client_id\":" + payload_detail::quoted(client_id) + "},\"readings\":["),
+              tail_(schema_version >= 2 ? "],\"schema_version\":2}" : "],\"schema_version\":1}"),
+              with_ms_(schema_version >= 2) {
+            clear();
+        }
+
+        // returns the metric index to pass to append()
+        std::size_t add_metric(std::string_view metric_name, std::string_view unit) {
+            metrics_.push_back(MetricFragments{
+                "{\"name\":" + payload_detail::quoted(metric_name) + ",\"seq\":",
+                ",\"unit\":" + payload_detail::quoted(unit) + ",\"value\":"
+            });
+            return metrics_.size() - 1;
+        }
+
+        void reserve(std::size_t bytes) { buf_.reserve(bytes); }
+
+        // timestamp_ms is written by schema 2 only
+        void append(std::size_t metric, double value, std::uint64_t seq, std::int64_t timestamp_s, std::int64_t timestamp_ms = 0) {
+            const auto& frag = metrics_[metric];
+            if (count_ > 0) buf_.push_back(',');
+            buf_.append(frag.head);
+            payload_detail::append_int(buf_, seq);
+            if (with_ms_) {
+                buf_.append(",\"timestamp_ms\":");
+                payload_detail::append_int(buf_, timestamp_ms);
+            }
+            buf_.append(",\"timestamp_s\":");
+            payload_detail::append_int(buf_, timestamp_s);
+            buf_.append(frag.unit);
+            payload_detail::append_double(buf_, value);
+            buf_.push_back('}');
+            ++count_;
+        }
+
+        // upper bound on the bytes append(metric, ...) adds
+        std::size_t reading_size_bound(std::size_t metric) const noexcept {
+            const auto& frag = metrics_[metric];
+            return 1 + frag.head.size() + frag.unit.size() + k_numbers_bound + (with_ms_ ? k_ms_bound : 0);
+        }
+
+        std::size_t count() const noexcept { return count_; }
+        bool empty() const noexcept { return count_ == 0; }
+
+        // size of the payload finish() would return
+        std::size_t size_bytes() const noexcept { return buf_.size() + tail_.size(); }
+
+        // closes the array; the returned view is valid until the next clear()/append()
+        std::string_view finish() {
+            buf_.append(tail_);
+            return buf_;
+        }
+
+        void clear() {
+            buf_.assign(head_);
+            count_ = 0;
+        }
+
+    private:
+        // seq + timestamp_s (20 digits each), the double (<= 25 chars) and the fixed keys
+        static constexpr std::size_t k_numbers_bound = 20 + 20 + 25 + 16;
+        static constexpr std::size_t k_ms_bound = 20 + 16; // ,"timestamp_ms":
+
+        struct MetricFragments {
+            std::string head; // {"name":...,"seq":
+            std::string unit; // ,"unit":...,"value":
+        };
+
+        std::string head_;
+        std::string_view tail_;
+        bool with_ms_;
+        std::vector<MetricFragments> metrics_;
+        std::string buf_;
+        std::size_t count_ = 0;
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// broker.failover.policy
+enum class FailoverPolicy : std::uint8_t {
+    Priority, // always prefer the lowest priority value; fail back once a preferred broker recovers
+    Sticky    // stay on whichever broker works until it fails
+};
+
+inline bool try_parse_failover_policy(std::string_view str, FailoverPolicy& out) {
+    if (str == "priority") { out = FailoverPolicy::Priority; return true; }
+    if (str == "sticky") { out = FailoverPolicy::Sticky; return true; }
+    return false;
+}
+
+inline std::string_view failover_policy_name(FailoverPolicy policy) {
+    return policy == FailoverPolicy::Sticky ? "sticky" : "priority";
+}
+
+struct BrokerEndpoint {
+    std::string host;
+    int port = 1883;
+    int priority = 0; // lower is preferred
+
+    bool operator == (const BrokerEndpoint&) const = default;
+};
+
+struct FailoverOptions {
+    FailoverPolicy policy = FailoverPolicy::Priority;
+    std::chrono::seconds failback_after{30};  // connected this long before retrying a preferred broker
+    std::chrono::seconds connect_timeout{5};  // an attempt without CONNACK by then counts as failed
+};
+
+// Decides which broker the next connection attempt goes to. Every endpoint keeps a health score:
+// consecutive failures put it on an exponential cooldown (1 s doubling to 60 s) and it is skipped
+// while cooling down, and among endpoints of equal priority the one with the lower smoothed
+// connect latency wins. Not thread-safe; MqttClient guards it with a mutex.
+class BrokerSelector {
+    public:
+        using Clock     = std::chrono::steady_clock;
+        using TimePoint = Clock::time_point;
+
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        BrokerSelector(std::vector<BrokerEndpoint> endpoints, FailoverOptions opts)
+            : endpoints_(std::move(endpoints)), opts_(opts), health_(endpoints_.size()) {}
+
+        std::size_t size() const noexcept { return endpoints_.size(); }
+        const BrokerEndpoint& endpoint(std::size_t i) const { return endpoints_[i]; }
+        const FailoverOptions& options() const noexcept { return opts_; }
+
+        // where the next attempt should go: an endpoint out of cooldown if any (the one that
+        // recovers first otherwise)
+        std::size_t pick(TimePoint now) const {
+            if (opts_.policy == FailoverPolicy::Sticky && last_connected_ != npos && ready(last_connected_, now)) {
+                return last_connected_;
+            }
+            std::size_t best = npos;
+            for (std::size_t i = 0; i < endpoints_.size(); ++i) {
+                if (ready(i, now) && (best == npos || better_(i, best))) best = i;
+            }
+            if (best != npos) return best;
+            for (std::size_t i = 0; i < endpoints_.size(); ++i) {
+                if (best == npos || health_[i].retry_at < health_[best].retry_at) best = i;
+            }
+            return best;
+        }
+
+        bool ready(std::size_t i, TimePoint now) const noexcept { return now >= health_[i].retry_at; }
+        TimePoint retry_at(std::size_t i) const noexcept { return health_[i].retry_at; }
+
+        void on_connected(std::size_t i, std::chrono::microseconds latency) {
+            auto& h = health_[i];
+            h.failures = 0;
+            h.retry_at = {};
+            const double ms = static_cast<double>(latency.count()) / 1000.0;
+            h.latency_ms = h.connected_once ? h.latency_ms + k_latency_alpha * (ms - h.latency_ms) : ms;
+            h.connected_once = true;
+            last_connected_ = i;
+        }
+
+        // a failed attempt or a lost connection
+        void on_failed(std::size_t i, TimePoint now) {
+            auto& h = health_[i];
+            h.failures = std::min<std::uint32_t>(h.failures + 1, 16);
+            const auto doublings = std::min<std::uint32_t>(h.failures, 7) - 1;
+            h.retry_at = now + std::min<std::chrono::seconds>(k_max_cooldown, k_first_cooldown * (std::int64_t{1} << doublings));
+        }
+
+        // Priority policy: the preferred endpoint to switch to while connected to `current` since
+        // `connected_at`, or npos. One that fails again goes back on cooldown, which spaces out
+        // further tries.
+        std::size_t fail_back_target(std::size_t current, TimePoint connected_at, TimePoint now) const {
+            if (opts_.policy != FailoverPolicy::Priority || now - connected_at < opts_.failback_after) return npos;
+            std::size_t best = npos;
+            for (std::size_t i = 0; i < endpoints_.size(); ++i) {
+                if (endpoints_[i].priority >= endpoints_[current].priority || !ready(i, now)) continue;
+                if (best == npos || better_(i, best)) best = i;
+            }
+            return best;
+        }
+
+        // lower is healthier: consecutive failures dominate, then connect latency in ms
+        double score(std::size_t i) const noexcept {
+            return static_cast<double>(health_[i].failures) * 1000.0 + health_[i].latency_ms;
+        }
+
+    private:
+        static constexpr auto k_first_cooldown = std::chrono::seconds(1);
+        static constexpr auto k_max_cooldown = std::chrono::seconds(60);
+        static constexpr double k_latency_alpha = 0.3;
+
+        struct Health {
+            std::uint32_t failures = 0;
+            TimePoint retry_at{};
+            double latency_ms = 0.0; // EWMA of connect -> CONNACK
+            bool connected_once = false;
+        };
+
+        bool better_(std::size_t a, std::size_t b) const noexcept {
+            if (endpoints_[a].priority != endpoints_[b].priority) return endpoints_[a].priority < endpoints_[b].priority;
+            return score(a) < score(b);
+        }
+
+        std::vector<BrokerEndpoint> endpoints_;
+        FailoverOptions opts_;
+        std::vector<Health> health_;
+        std::size_t last_connected_ = npos;
+};
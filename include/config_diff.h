@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "app_config.h"
+
+// What a reload (SIGHUP) changes relative to the running config, grouped by what has to be
+// rebuilt to apply it. Metrics are matched by name.
+struct ConfigDiff {
+    // new metric index -> index of the identical running metric (its sensor is kept), -1 if added or changed
+    std::vector<std::int32_t> kept_from;
+    std::vector<std::string> added;
+    std::vector<std::string> removed;
+    std::vector<std::string> changed;
+
+    bool schedule = false;   // metrics or intervals changed: the sampler is rebuilt
+    bool publishing = false; // batch, compression, retain or replay rate changed
+    bool reconnect = false;  // broker session settings changed: a new MqttClient is connected
+    bool log_level = false;
+    bool max_inflight = false;
+    bool drain_timeout = false; // read whenever sessions close, so it applies once the config is swapped
+
+    // settings that cannot change while running; a reload touching any of them is rejected
+    std::vector<std::string> restart_only;
+
+    bool empty() const noexcept {
+        return !schedule && !publishing && !reconnect && !log_level && !max_inflight && !drain_timeout && restart_only.empty();
+    }
+};
+
+inline ConfigDiff diff_config(const AppConfig& running, const AppConfig& next) {
+    ConfigDiff diff;
+
+    // client_id names the LWT/status topic, and qos and payload_format are baked into the
+    // LWT and the retained status message, so they count as session settings
+    diff.reconnect = running.brokers != next.brokers || !(running.failover == next.failover) || running.keepalive_s != next.keepalive_s ||
+                     running.mqtt5 != next.mqtt5 || running.topic_aliases != next.topic_aliases ||
+                     running.message_expiry_s != next.message_expiry_s || running.client_id != next.client_id ||
+                     running.qos != next.qos || running.payload_format != next.payload_format;
+    diff.max_inflight = running.max_inflight != next.max_inflight;
+    diff.drain_timeout = running.drain_timeout_ms != next.drain_timeout_ms;
+    diff.log_level = running.log_level != next.log_level;
+    diff.publishing = running.retain != next.retain || running.schema_version != next.schema_version ||
+                      !(running.batch == next.batch) ||
+                      !(running.compression == next.compression) ||
+                      running.store_forward.replay_per_s != next.store_forward.replay_per_s;
+
+    if (running.epoll_loop != next.epoll_loop) diff.restart_only.push_back("event_loop");
+    if (running.connections != next.connections) diff.restart_only.push_back("broker.connections");
+    if (!(running.spool == next.spool)) diff.restart_only.push_back("spool");
+    if (!(running.metrics_endpoint == next.metrics_endpoint)) diff.restart_only.push_back("metrics_endpoint");
+    if (running.store_forward.capacity != next.store_forward.capacity ||
+        running.store_forward.policy != next.store_forward.policy) {
+        diff.restart_only.push_back("store_forward");
+    }
+
+    std::unordered_map<std::string, std::int32_t> running_index;
+    for (std::size_t i = 0; i < running.metrics.size(); ++i) {
+        running_index.emplace(running.metrics[i].name, static_cast<std::int32_t>(i));
+    }
+
+    diff.kept_from.assign(next.metrics.size(), -1);
+    std::vector<bool> matched(running.metrics.size(), false);
+    for (std::size_t i = 0; i < next.metrics.size(); ++i) {
+        const auto& metric = next.metrics[i];
+        const auto it = running_index.find(metric.name);
+        if (it == running_index.end() || matched[static_cast<std::size_t>(it->second)]) {
+            diff.added.push_back(metric.name);
+            continue;
+        }
+        const auto& old = running.metrics[static_cast<std::size_t>(it->second)];
+        matched[static_cast<std::size_t>(it->second)] = true;
+        if (old == metric && effective_interval_ms(running, old) == effective_interval_ms(next, metric)) {
+            diff.kept_from[i] = it->second;
+        } else {
+            diff.changed.push_back(metric.name);
+        }
+    }
+    for (std::size_t i = 0; i < running.metrics.size(); ++i) {
+        if (!matched[i]) diff.removed.push_back(running.metrics[i].name);
+    }
+
+    // any added, removed, changed or reordered metric, or a new heartbeat period
+    bool metrics_differ = running.metrics.size() != next.metrics.size();
+    for (std::size_t i = 0; !metrics_differ && i < diff.kept_from.size(); ++i) {
+        metrics_differ = diff.kept_from[i] != static_cast<std::int32_t>(i);
+    }
+    diff.schedule = metrics_differ || running.health_interval_ms != next.health_interval_ms;
+    return diff;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Pipeline counters and gauges written from any thread (sampler, publisher, MqttClient) and read
+// when the health message is built. Relaxed atomics only, no locks; every slot has its own cache
+// line so writers on different threads never contend.
+enum class Counter : std::size_t {
+    BytesSent,    // payload bytes accepted by mosquitto_publish
+    Overruns,     // gauge: scheduler ticks that missed their deadline (set by the sampler)
+    QueueDepth,   // gauge: sampler -> publisher queue high-water mark since the last health message
+    QueueDropped, // samples lost because the publisher fell behind
+    Suppressed,   // gauge: readings held back by deadband filters (set by the sampler)
+    Count
+};
+
+class CounterRegistry {
+    public:
+        void add(Counter counter, std::uint64_t n = 1) noexcept { slot_(counter).fetch_add(n, std::memory_order_relaxed); }
+        void set(Counter counter, std::uint64_t value) noexcept { slot_(counter).store(value, std::memory_order_relaxed); }
+
+        // raises a high-water gauge to `value`
+        void raise(Counter counter, std::uint64_t value) noexcept {
+            auto& slot = slot_(counter);
+            std::uint64_t seen = slot.load(std::memory_order_relaxed);
+            while (seen < value && !slot.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+        }
+
+        std::uint64_t value(Counter counter) const noexcept { return slot_(counter).load(std::memory_order_relaxed); }
+        // reads and resets a high-water gauge
+        std::uint64_t take(Counter counter) noexcept { return slot_(counter).exchange(0, std::memory_order_relaxed); }
+
+    private:
+        static constexpr std::size_t k_cache_line = 64;
+
+        struct alignas(k_cache_line) Slot {
+            std::atomic<std::uint64_t> value{0};
+        };
+
+        std::atomic<std::uint64_t>& slot_(Counter counter) noexcept { return slots_[static_cast<std::size_t>(counter)].value; }
+        const std::atomic<std::uint64_t>& slot_(Counter counter) const noexcept {
+            return slots_[static_cast<std::size_t>(counter)].value;
+        }
+
+        std::array<Slot, static_cast<std::size_t>(Counter::Count)> slots_{};
+};
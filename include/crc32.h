@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32 (IEEE 802.3, reflected, poly 0xEDB88320) -- same result as zlib's crc32()
+namespace crc32_detail {
+    constexpr std::array<std::uint32_t, 256> make_table() {
+        std::array<std::uint32_t, 256> table{};
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1u) ? (crc >> 1) ^ 0xEDB88320u : (crc >> 1);
+            }
+            table[i] = crc;
+        }
+        return table;
+    }
+
+    inline constexpr std::array<std::uint32_t, 256> table = make_table();
+} // namespace crc32_detail
+
+// pass the previous result as `crc` to checksum data in pieces
+inline std::uint32_t crc32(const void* data, std::size_t len, std::uint32_t crc = 0) {
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    crc = ~crc;
+    for (std::size_t i = 0; i < len; ++i) {
+        crc = crc32_detail::table[(crc ^ bytes[i]) & 0xFFu] ^ (crc >> 8);
+    }
+    return ~crc;
+}
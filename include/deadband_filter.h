@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Report-by-exception for one metric: a reading is published only when it differs from the
+// last published value by more than the band, or when max_silence has passed since then.
+// The band is max(abs, pct% of |last published value|), so `abs` acts as a floor near zero.
+// With no band configured, any change is published. A default-constructed filter passes
+// every reading.
+class DeadbandFilter {
+    public:
+        using Clock     = std::chrono::steady_clock;
+        using TimePoint = Clock::time_point;
+
+        DeadbandFilter() = default;
+        DeadbandFilter(double abs, double pct, Clock::duration max_silence)
+            : abs_(abs), pct_(pct), max_silence_(max_silence),
+              enabled_(abs > 0.0 || pct > 0.0 || max_silence > Clock::duration::zero()) {}
+
+        bool enabled() const noexcept { return enabled_; }
+
+        // true if the reading should be published; the filter then remembers it as the reference
+        bool should_publish(double value, TimePoint now) noexcept {
+            if (enabled_ && has_last_ && !exceeds_band_(value) &&
+                (max_silence_ <= Clock::duration::zero() || now - last_sent_ < max_silence_)) {
+                return false;
+            }
+            has_last_ = true;
+            last_value_ = value;
+            last_sent_ = now;
+            return true;
+        }
+
+    private:
+        bool exceeds_band_(double value) const noexcept {
+            if (std::isnan(value) || std::isnan(last_value_)) return std::isnan(value) != std::isnan(last_value_);
+            const double band = std::max(abs_, pct_ / 100.0 * std::fabs(last_value_));
+            const double delta = std::fabs(value - last_value_);
+            return band > 0.0 ? delta > band : delta != 0.0;
+        }
+
+        double abs_ = 0.0;
+        double pct_ = 0.0;
+        Clock::duration max_silence_{};
+        bool enabled_ = false;
+
+        bool has_last_ = false;
+        double last_value_ = 0.0;
+        TimePoint last_sent_{};
+};
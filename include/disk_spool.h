@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+
+// Append-only, segment-based on-disk queue of (topic, payload) messages for long broker outages.
+//
+// Layout: <dir>/<index>.seg segment files plus <dir>/cursor (drain position).
+// Record: u32 body_len | u32 crc32(body) | body, where body = i64 timestamp_s | u16 topic_len | topic | payload.
+//
+// Appends are collected in memory and written with one write() + fdatasync() per
+// flush_records records or flush_interval, whichever comes first, to keep SD-card
+// write amplification low. On startup every segment is CRC-checked and a torn tail
+// (power loss mid-write) is truncated away. Delivery is at-least-once: records
+// drained after the last persisted cursor may be sent again after a crash.
+class DiskSpool {
+    public:
+        using Clock     = std::chrono::steady_clock;
+        using TimePoint = Clock::time_point;
+
+        struct Options {
+            std::string dir;
+            std::uint64_t max_bytes = 64ull * 1024 * 1024;   // oldest segments are dropped beyond this
+            std::int64_t max_age_s = 7 * 24 * 3600;          // older records are discarded instead of sent
+            std::uint64_t segment_bytes = 1024 * 1024;
+            std::size_t flush_records = 64;
+            std::chrono::milliseconds flush_interval{1000};
+        };
+
+        struct Record {
+            std::int64_t timestamp_s = 0;
+            std::string_view topic;   // valid until the next peek()/pop()
+            std::string_view payload;
+        };
+
+        // creates the directory if needed and recovers existing segments; throws std::runtime_error
+        explicit DiskSpool(Options opts);
+        ~DiskSpool();
+
+        DiskSpool(const DiskSpool&) = delete;
+        DiskSpool& operator = (const DiskSpool&) = delete;
+
+        bool append(std::string_view topic, std::string_view payload, std::int64_t timestamp_s);
+
+        // oldest undelivered record (skipping expired ones); false when the spool is empty
+        bool peek(Record& out);
+        void pop();
+
+        // time-based flush and cursor persistence; call regularly
+        void tick(TimePoint now);
+        void flush();
+
+        bool empty() const noexcept { return pending_ == 0; }
+        std::uint64_t pending() const noexcept { return pending_; }
+        std::uint64_t dropped() const noexcept { return dropped_; }
+        std::uint64_t bytes() const noexcept { return total_bytes_; }
+
+    private:
+        struct Segment {
+            std::uint64_t index = 0;
+            std::uint64_t bytes = 0;    // durable + buffered bytes
+            std::uint64_t records = 0;  // records not yet drained
+        };
+
+        static constexpr std::size_t k_header_len = 8;
+        static constexpr std::size_t k_body_fixed_len = 10; // timestamp_s + topic_len
+        static constexpr std::uint32_t k_max_record_len = 4 * 1024 * 1024;
+
+        std::string segment_path_(std::uint64_t index) const;
+        std::string cursor_path_() const;
+
+        void recover_();
+        std::uint64_t scan_segment_(Segment& seg, std::uint64_t start_offset);
+        void load_cursor_(std::uint64_t& segment, std::uint64_t& offset) const;
+        void persist_cursor_();
+        void sync_dir_();
+
+        bool open_active_();
+        void close_active_();
+        void enforce_size_cap_(std::uint64_t incoming);
+        void drop_head_segment_();
+        bool read_record_(Record& out, std::uint64_t& record_len);
+
+        Options opts_;
+        int dir_fd_ = -1; // fsync'd after segments are created or removed and the cursor is renamed
+
+        std::deque<Segment> segments_;   // oldest first; back() is the active segment once opened
+        std::uint64_t next_index_ = 0;
+        int active_fd_ = -1;
+        std::uint64_t active_durable_ = 0; // bytes of the active segment already on disk
+
+        std::string write_buf_;
+        std::size_t buffered_records_ = 0;
+        TimePoint last_flush_ = Clock::now();
+
+        // drain position inside segments_.front()
+        int read_fd_ = -1;
+        std::uint64_t read_segment_ = 0;
+        std::uint64_t read_offset_ = 0;
+        std::string read_buf_;
+        std::uint64_t peeked_len_ = 0;   // length of the record returned by the last peek()
+        bool cursor_dirty_ = false;
+        TimePoint last_cursor_ = Clock::now();
+
+        std::uint64_t pending_ = 0;
+        std::uint64_t dropped_ = 0;
+        std::uint64_t total_bytes_ = 0;
+};
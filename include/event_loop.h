@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+// RAII wrappers over epoll, timerfd and signalfd for the single-threaded event loop
+// (event_loop: "epoll"). Construction throws std::runtime_error if the kernel object cannot be
+// created; the other calls are noexcept and ignore errors a closed fd would cause.
+
+class EventLoop {
+    public:
+        using Handler = std::function<void(std::uint32_t events)>;
+
+        EventLoop() : fd_(::epoll_create1(EPOLL_CLOEXEC)) {
+            if (fd_ < 0) throw std::runtime_error("epoll_create1 failed");
+        }
+        ~EventLoop() { ::close(fd_); }
+
+        EventLoop(const EventLoop&) = delete;
+        EventLoop& operator = (const EventLoop&) = delete;
+
+        // handlers are keyed by fd; watching a watched fd replaces its handler and events
+        void watch(int fd, std::uint32_t events, Handler handler) {
+            epoll_event ev{};
+            ev.events = events;
+            ev.data.fd = fd;
+            if (::epoll_ctl(fd_, EPOLL_CTL_ADD, fd, &ev) != 0) ::epoll_ctl(fd_, EPOLL_CTL_MOD, fd, &ev);
+            handlers_[fd] = std::move(handler);
+        }
+
+        void modify(int fd, std::uint32_t events) noexcept {
+            epoll_event ev{};
+            ev.events = events;
+            ev.data.fd = fd;
+            ::epoll_ctl(fd_, EPOLL_CTL_MOD, fd, &ev);
+        }
+
+        // safe after the fd was closed (closing already dropped it from the epoll set)
+        void unwatch(int fd) noexcept {
+            ::epoll_ctl(fd_, EPOLL_CTL_DEL, fd, nullptr);
+            handlers_.erase(fd);
+        }
+
+        // waits up to timeout_ms (-1 = until an event) and runs the handlers of ready fds;
+        // returns how many were ready
+        int run_once(int timeout_ms) {
+            epoll_event ready[16];
+            const int n = ::epoll_wait(fd_, ready, 16, timeout_ms);
+            for (int i = 0; i < n; ++i) {
+                // an earlier handler may have unwatched this fd
+                const auto it = handlers_.find(ready[i].data.fd);
+                if (it != handlers_.end()) it->second(ready[i].events);
+            }
+            return n < 0 ? 0 : n;
+        }
+
+    private:
+        int fd_;
+        std::unordered_map<int, Handler> handlers_;
+};
+
+// One-shot deadline timer on CLOCK_MONOTONIC, which is what std::chrono::steady_clock reads
+// on Linux, so steady_clock time points arm it directly.
+class TimerFd {
+    public:
+        using TimePoint = std::chrono::steady_clock::time_point;
+
+        TimerFd() : fd_(::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) {
+            if (fd_ < 0) throw std::runtime_error("timerfd_create failed");
+        }
+        ~TimerFd() { ::close(fd_); }
+
+        TimerFd(const TimerFd&) = delete;
+        TimerFd& operator = (const TimerFd&) = delete;
+
+        int fd() const noexcept { return fd_; }
+
+        // a deadline in the past fires at once; TimePoint::max() disarms. Re-arming at the
+        // current deadline is free.
+        void arm_at(TimePoint deadline) noexcept {
+            if (deadline == armed_) return;
+            armed_ = deadline;
+
+            itimerspec spec{};
+            if (deadline != TimePoint::max()) {
+                const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+                const auto at = ns > 0 ? ns : 1; // an all-zero it_value would disarm
+                spec.it_value.tv_sec = static_cast<time_t>(at / 1000000000);
+                spec.it_value.tv_nsec = static_cast<long>(at % 1000000000);
+            }
+            ::timerfd_settime(fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+        }
+
+        void disarm() noexcept { arm_at(TimePoint::max()); }
+
+        // clears the readable state after the timer fired; the timer is then disarmed
+        void consume() noexcept {
+            std::uint64_t expirations = 0;
+            ssize_t n;
+            do { n = ::read(fd_, &expirations, sizeof(expirations)); } while (n < 0 && errno == EINTR);
+            armed_ = TimePoint::max();
+        }
+
+    private:
+        int fd_;
+        TimePoint armed_ = TimePoint::max();
+};
+
+// Delivers signals as readable events. The constructor blocks them in the calling thread;
+// threads started afterwards inherit the mask, so construct it before starting any.
+class SignalFd {
+    public:
+        explicit SignalFd(std::initializer_list<int> signals) {
+            sigset_t mask;
+            sigemptyset(&mask);
+            for (const int signo : signals) sigaddset(&mask, signo);
+            if (::pthread_sigmask(SIG_BLOCK, &mask, nullptr) != 0) throw std::runtime_error("pthread_sigmask failed");
+            fd_ = ::signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+            if (fd_ < 0) throw std::runtime_error("signalfd failed");
+        }
+        ~SignalFd() { ::close(fd_); }
+
+        SignalFd(const SignalFd&) = delete;
+        SignalFd& operator = (const SignalFd&) = delete;
+
+        int fd() const noexcept { return fd_; }
+
+        // next pending signal number, nullopt once none are left
+        std::optional<int> next() noexcept {
+            signalfd_siginfo info{};
+            ssize_t n;
+            do { n = ::read(fd_, &info, sizeof(info)); } while (n < 0 && errno == EINTR);
+            if (n != static_cast<ssize_t>(sizeof(info))) return std::nullopt;
+            return static_cast<int>(info.ssi_signo);
+        }
+
+    private:
+        int fd_ = -1;
+};
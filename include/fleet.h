@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "app_config.h"
+#include "payload_writer.h"
+#include "time_utils.h"
+
+// Fleet load-generator mode (--fleet N): N simulated devices in one process, each with its own
+// MqttClient (client id, LWT/status topic, reconnect backoff, in-flight window), multiplexed over
+// fleet.threads epoll loops instead of one mosquitto network thread per connection.
+
+// "<base>-<index>", zero-padded to the width of the largest index so ids sort in index order
+inline std::string fleet_client_id(std::string_view base, std::size_t index, std::size_t devices) {
+    std::size_t width = 1;
+    for (std::size_t n = devices > 0 ? devices - 1 : 0; n >= 10; n /= 10) ++width;
+    const std::string digits = std::to_string(index);
+
+    std::string out;
+    out.reserve(base.size() + 1 + std::max(width, digits.size()));
+    out.append(base);
+    out.push_back('-');
+    if (digits.size() < width) out.append(width - digits.size(), '0');
+    out.append(digits);
+    return out;
+}
+
+// when a device connects and when it first publishes, relative to fleet start
+struct FleetSlot {
+    std::chrono::milliseconds connect_at{0};
+    std::chrono::milliseconds first_publish{0};
+};
+
+// Connections ramp up at ramp_per_s; publish phases are spread evenly over spread_ms (pass the
+// metric's interval for an even spread across the whole period) so the fleet does not publish
+// in lock-step.
+inline FleetSlot fleet_slot(std::size_t index, std::size_t devices, int ramp_per_s, int spread_ms) {
+    FleetSlot slot;
+    slot.connect_at = std::chrono::milliseconds(static_cast<std::int64_t>(index) * 1000 / std::max(1, ramp_per_s));
+    const auto phase = devices > 0 ? static_cast<std::int64_t>(index) * std::max(0, spread_ms) / static_cast<std::int64_t>(devices) : 0;
+    slot.first_publish = slot.connect_at + std::chrono::milliseconds(phase);
+    return slot;
+}
+
+// Telemetry payloads of one device, a writer per metric in the configured schema. Readings are
+// stamped with the Unix time they were sampled at, mapped from steady_clock through the loop's
+// WallClock (refreshed once per tick, as in the daemon's sampler).
+class FleetPayloads {
+    public:
+        FleetPayloads(const AppConfig& cfg, std::string_view client_id) {
+            writers_.reserve(cfg.metrics.size());
+            for (const auto& metric : cfg.metrics) writers_.emplace_back(client_id, metric.name, metric.unit, cfg.schema_version);
+        }
+
+        // returned view is valid until the next write() of the same metric
+        std::string_view write(std::size_t metric, double value, std::uint64_t seq, const WallClock& wall,
+                               std::chrono::steady_clock::time_point sampled_at) {
+            const auto timestamp_ms = wall.unix_ms(sampled_at);
+            return writers_[metric].write(value, seq, timestamp_ms / 1000, timestamp_ms);
+        }
+
+    private:
+        std::vector<TelemetryPayloadWriter> writers_;
+};
+
+// counts over the whole fleet
+struct FleetTotals {
+    std::uint64_t published = 0;
+    std::uint64_t skipped = 0;   // publishes not taken (full window or no connection)
+    std::uint64_t delivered = 0; // acked (QoS 1/2) or written (QoS 0)
+    std::size_t connected = 0;   // devices connected
+};
+
+// Runs `devices` simulated devices publishing cfg.metrics (simulated values from start/step)
+// until `running` goes false, logging aggregate acked msg/s and ack latency every
+// fleet.report_interval_s. Each device's MqttClient uses compact mid tracking. Returns the
+// process exit code; `totals`, if given, receives the final counts (connected: before the
+// devices disconnect).
+int run_fleet(const AppConfig& cfg, std::size_t devices, const std::atomic<bool>& running, FleetTotals* totals = nullptr);
@@ -1,28 +1,181 @@
 #pragma once
 
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <array>
 #include <cstdint>
 #include <string_view>
 
+#include "latency_histogram.h"
+#include "process_stats.h"
+
+struct HealthCounters {
+    std::uint64_t publish_ok = 0;   // acked by the broker (QoS 1/2) or written to the socket (QoS 0)
+    std::uint64_t publish_fail = 0;
+    std::uint64_t inflight = 0;     // QoS > 0 messages awaiting their ack
+    std::uint64_t backpressure = 0; // publishes deferred because the in-flight window was full
+    std::uint64_t reconnects = 0;
+    std::uint64_t overruns = 0; // scheduler ticks that missed their deadline
+    std::uint64_t queue_dropped = 0; // samples lost because the publisher thread fell behind
+    std::uint64_t queue_depth = 0;   // sampler -> publisher queue high-water mark since the previous health message
+    std::uint64_t bytes_sent = 0;    // payload bytes handed to the broker connection
+    std::uint64_t suppressed = 0; // readings not published because they stayed inside their deadband
+
+    // store-and-forward
+    std::uint64_t buffered = 0; // readings currently waiting for the broker
+    std::uint64_t dropped = 0;  // readings lost to buffer overflow
+    std::uint64_t replayed = 0; // buffered readings published after reconnect
+
+    // compression (totals over compressed payloads; ratio = in / out)
+    std::uint64_t compress_in_bytes = 0;
+    std::uint64_t compress_out_bytes = 0;
+    std::uint64_t compress_cpu_us = 0;  // thread CPU time spent in deflate
+};
+
+struct HealthCounterField {
+    std::string_view key;
+    std::uint64_t HealthCounters::* member;
+};
+
+// "counters" object layout; kept in key order, which is the order nlohmann::json dumps them in
+inline constexpr std::array<HealthCounterField, 16> health_counter_fields{{
+    {"backpressure", &HealthCounters::backpressure},
+    {"buffered", &HealthCounters::buffered},
+    {"bytes_sent", &HealthCounters::bytes_sent},
+    {"compress_cpu_us", &HealthCounters::compress_cpu_us},
+    {"compress_in_bytes", &HealthCounters::compress_in_bytes},
+    {"compress_out_bytes", &HealthCounters::compress_out_bytes},
+    {"dropped", &HealthCounters::dropped},
+    {"inflight", &HealthCounters::inflight},
+    {"overruns", &HealthCounters::overruns},
+    {"publish_fail", &HealthCounters::publish_fail},
+    {"publish_ok", &HealthCounters::publish_ok},
+    {"queue_depth", &HealthCounters::queue_depth},
+    {"queue_dropped", &HealthCounters::queue_dropped},
+    {"reconnects", &HealthCounters::reconnects},
+    {"replayed", &HealthCounters::replayed},
+    {"suppressed", &HealthCounters::suppressed},
+}};
+
+static_assert(std::is_sorted(health_counter_fields.begin(), health_counter_fields.end(),
+                             [](const HealthCounterField& lhs, const HealthCounterField& rhs) { return lhs.key < rhs.key; }),
+              "health_counter_fields must stay sorted by key");
+
+struct ProcessStatsField {
+    std::string_view key;
+    std::uint64_t ProcessStats::* member;
+};
+
+// "process" object layout, in key order like health_counter_fields
+inline constexpr std::array<ProcessStatsField, 5> process_stats_fields{{
+    {"cpu_sys_us", &ProcessStats::cpu_sys_us},
+    {"cpu_user_us", &ProcessStats::cpu_user_us},
+    {"ctx_involuntary", &ProcessStats::ctx_involuntary},
+    {"ctx_voluntary", &ProcessStats::ctx_voluntary},
+    {"rss_kb", &ProcessStats::rss_kb},
+}};
+
+static_assert(std::is_sorted(process_stats_fields.begin(), process_stats_fields.end(),
+                             [](const ProcessStatsField& lhs, const ProcessStatsField& rhs) { return lhs.key < rhs.key; }),
+              "process_stats_fields must stay sorted by key");
+
+// per-stage latency since the previous health message, in microseconds
+struct LatencyReport {
+    LatencySummary sample;    // ISensorDevice::sample()
+    LatencySummary serialize; // payload rendering
+    LatencySummary publish;   // time inside mosquitto_publish
+    LatencySummary ack;       // publish -> PUBACK/PUBCOMP (QoS > 0)
+};
+
+struct LatencyStageField {
+    std::string_view key;
+    LatencySummary LatencyReport::* member;
+};
+
+struct LatencySummaryField {
+    std::string_view key;
+    std::uint64_t LatencySummary::* member;
+};
+
+// "latency_us" object layout, in key order like health_counter_fields
+inline constexpr std::array<LatencyStageField, 4> latency_stage_fields{{
+    {"ack", &LatencyReport::ack},
+    {"publish", &LatencyReport::publish},
+    {"sample", &LatencyReport::sample},
+    {"serialize", &LatencyReport::serialize},
+}};
+
+inline constexpr std::array<LatencySummaryField, 5> latency_summary_fields{{
+    {"count", &LatencySummary::count},
+    {"max", &LatencySummary::max},
+    {"p50", &LatencySummary::p50},
+    {"p99", &LatencySummary::p99},
+    {"p999", &LatencySummary::p999},
+}};
+
+static_assert(std::is_sorted(latency_stage_fields.begin(), latency_stage_fields.end(),
+                             [](const LatencyStageField& lhs, const LatencyStageField& rhs) { return lhs.key < rhs.key; }),
+              "latency_stage_fields must stay sorted by key");
+static_assert(std::is_sorted(latency_summary_fields.begin(), latency_summary_fields.end(),
+                             [](const LatencySummaryField& lhs, const LatencySummaryField& rhs) { return lhs.key < rhs.key; }),
+              "latency_summary_fields must stay sorted by key");
+
 inline nlohmann::json make_health_payload_v1 (
     std::string_view client_id,
     std::uint64_t uptime_s,
     std::uint64_t seq,
-    std::uint64_t publish_ok,
-    std::uint64_t publish_fail,
-    std::uint64_t reconnects,
-    std::uint64_t now_s
+    const HealthCounters& counters,
+    std::uint64_t now_s,
+    const LatencyReport* latency = nullptr,
+    const ProcessStats* process = nullptr
 ) {
-    return {
+    nlohmann::json counters_json = nlohmann::json::object();
+    for (const auto& field : health_counter_fields) {
+        counters_json[std::string(field.key)] = counters.*field.member;
+    }
+
+    nlohmann::json out = {
         {"schema_version", 1},
         {"device", {{"client_id", client_id}}},
         {"uptime_s", uptime_s},
         {"seq", seq},
-        {"counters", {
-            {"publish_ok", publish_ok},
-            {"publish_fail", publish_fail},
-            {"reconnects", reconnects},
-        }},
+        {"counters", std::move(counters_json)},
         {"timestamp_s", now_s}
     };
-}
\ No newline at end of file
+
+    if (latency) {
+        nlohmann::json latency_json = nlohmann::json::object();
+        for (const auto& stage : latency_stage_fields) {
+            nlohmann::json summary = nlohmann::json::object();
+            for (const auto& field : latency_summary_fields) {
+                summary[std::string(field.key)] = (*latency).*stage.member.*field.member;
+            }
+            latency_json[std::string(stage.key)] = std::move(summary);
+        }
+        out["latency_us"] = std::move(latency_json);
+    }
+    if (process) {
+        nlohmann::json process_json = nlohmann::json::object();
+        for (const auto& field : process_stats_fields) {
+            process_json[std::string(field.key)] = (*process).*field.member;
+        }
+        out["process"] = std::move(process_json);
+    }
+    return out;
+}
+
+inline nlohmann::json make_health_payload_v1 (
+    std::string_view client_id,
+    std::uint64_t uptime_s,
+    std::uint64_t seq,
+    std::uint64_t publish_ok,
+    std::uint64_t publish_fail,
+    std::uint64_t reconnects,
+    std::uint64_t now_s
+) {
+    HealthCounters counters;
+    counters.publish_ok = publish_ok;
+    counters.publish_fail = publish_fail;
+    counters.reconnects = reconnects;
+    return make_health_payload_v1(client_id, uptime_s, seq, counters, now_s);
+}
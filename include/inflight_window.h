@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Tracks which message ids are waiting for their broker ack (QoS 1/2) or socket write
+// (QoS 0), and how many QoS > 0 messages are outstanding.
+//
+// on_sent() runs on the publishing thread after mosquitto_publish has returned the mid;
+// on_complete() runs on the network thread from the publish callback, which can fire before
+// on_sent() for a fast broker. A per-mid state byte resolves that race without locks. Every
+// message given a mid must pass through on_sent(), or its callback leaves an early-completion
+// mark that a later message reusing the mid would take for its own ack.
+//
+// By default there is a slot for each of the 65536 mids. resize() trades that for fewer slots
+// (2048 at least, ~2 KB): mids then share a slot, which keeps the high bits of its mid as a tag.
+// mosquitto hands out mids in sequence, so two messages only meet in a slot when one is still
+// waiting after `slots` newer ones; the newer one takes the slot and the older one stops
+// counting toward the window, as after reset().
+class InflightWindow {
+    public:
+        static constexpr std::size_t k_max_slots = 65536; // MQTT mids are 16-bit
+        static constexpr std::size_t k_min_slots = 2048;  // the tag has to fit beside the state
+
+        explicit InflightWindow(std::size_t max_inflight = 0, std::size_t slots = k_max_slots) : max_(max_inflight) {
+            resize(slots);
+        }
+
+        // rounded up to a power of two within [k_min_slots, k_max_slots]; not thread-safe, call
+        // before the first message is sent
+        void resize(std::size_t slots) {
+            std::size_t n = k_min_slots;
+            while (n < slots && n < k_max_slots) n *= 2;
+            states_ = std::make_unique<std::atomic<std::uint8_t>[]>(n);
+            mask_ = n - 1;
+            tag_shift_ = 0;
+            while ((std::size_t{1} << tag_shift_) < n) ++tag_shift_;
+        }
+        std::size_t slots() const noexcept { return mask_ + 1; }
+
+        void set_max(std::size_t max_inflight) noexcept { max_ = max_inflight; }
+        std::size_t max() const noexcept { return max_; }
+
+        // 0 = unbounded
+        bool full() const noexcept { return max_ != 0 && inflight() >= max_; }
+        std::size_t inflight() const noexcept { return inflight_.load(std::memory_order_acquire); }
+        // QoS > 0 messages released by reset() whose ack has not arrived (yet)
+        std::size_t released() const noexcept { return released_.load(std::memory_order_acquire); }
+        std::uint64_t completed() const noexcept { return completed_.load(std::memory_order_relaxed); }
+
+        void on_sent(int mid, int qos) noexcept {
+            auto& slot = states_[index_(mid)];
+            const auto tag = tag_(mid);
+            if (qos > 0) inflight_.fetch_add(1, std::memory_order_acq_rel);
+            auto sent = pack_(tag, qos > 0 ? k_awaiting_ack : k_awaiting_write);
+            const auto old = slot.exchange(sent, std::memory_order_acq_rel);
+            // an older mid sharing the slot (or a released one reusing the mid) stops counting
+            if (state_of_(old) == k_released_ack) released_.fetch_sub(1, std::memory_order_acq_rel);
+            if (tag_of_(old) != tag) {
+                if (state_of_(old) == k_awaiting_ack) inflight_.fetch_sub(1, std::memory_order_acq_rel);
+                return;
+            }
+            if (state_of_(old) == k_completed_early) {
+                // reset() may have released the message in between; it is delivered either way
+                if (slot.compare_exchange_strong(sent, pack_(tag, k_idle), std::memory_order_acq_rel)) {
+                    complete_(qos > 0);
+                } else {
+                    if (state_of_(sent) == k_released_ack) released_.fetch_sub(1, std::memory_order_acq_rel);
+                    slot.store(pack_(tag, k_idle), std::memory_order_release);
+                    complete_(false);
+                }
+            }
+        }
+
+        void on_complete(int mid) noexcept {
+            auto& slot = states_[index_(mid)];
+            const auto tag = tag_(mid);
+            auto cur = slot.load(std::memory_order_acquire);
+            for (;;) {
+                const auto state = state_of_(cur);
+                const bool ours = tag_of_(cur) == tag;
+                if (ours && state == k_completed_early) return; // duplicate callback
+                // the slot belongs to a newer message; this one was already released
+                if (!ours && (state == k_awaiting_ack || state == k_released_ack)) return;
+                const bool tracked = ours && state != k_idle;
+                const auto next = pack_(tag, tracked ? k_idle : k_completed_early);
+                if (!slot.compare_exchange_weak(cur, next, std::memory_order_acq_rel)) continue;
+                if (tracked && state == k_released_ack) released_.fetch_sub(1, std::memory_order_acq_rel);
+                if (tracked) complete_(state == k_awaiting_ack);
+                return;
+            }
+        }
+
+        // Connection lost: messages still waiting no longer hold the window. The client library
+        // may resend them after reconnecting, so their acks can still arrive; they count as
+        // delivered then, without leaving an early-completion mark behind. Until then the QoS > 0
+        // ones are counted by released().
+        void reset() noexcept {
+            for (std::size_t i = 0; i <= mask_; ++i) {
+                auto& slot = states_[i];
+                auto cur = slot.load(std::memory_order_acquire);
+                while (state_of_(cur) == k_awaiting_ack || state_of_(cur) == k_awaiting_write) {
+                    const bool ack = state_of_(cur) == k_awaiting_ack;
+                    if (!slot.compare_exchange_weak(cur, pack_(tag_of_(cur), ack ? k_released_ack : k_released_write),
+                                                    std::memory_order_acq_rel)) continue;
+                    if (ack) {
+                        released_.fetch_add(1, std::memory_order_acq_rel);
+                        inflight_.fetch_sub(1, std::memory_order_acq_rel);
+                    }
+                    break;
+                }
+            }
+        }
+
+    private:
+        static constexpr std::uint8_t k_idle = 0;
+        static constexpr std::uint8_t k_awaiting_ack = 1;    // QoS > 0, counts toward the window
+        static constexpr std::uint8_t k_awaiting_write = 2;  // QoS 0
+        static constexpr std::uint8_t k_completed_early = 3; // callback ran before on_sent()
+        static constexpr std::uint8_t k_released_write = 4;  // QoS 0 sent before reset()
+        static constexpr std::uint8_t k_released_ack = 5;    // QoS > 0 sent before reset(), counted by released()
+        static constexpr int k_state_bits = 3;
+
+        std::size_t index_(int mid) const noexcept { return static_cast<std::size_t>(mid) & mask_; }
+        std::uint8_t tag_(int mid) const noexcept { return static_cast<std::uint8_t>((static_cast<unsigned>(mid) & 0xFFFF) >> tag_shift_); }
+        static std::uint8_t pack_(std::uint8_t tag, std::uint8_t state) noexcept {
+            return static_cast<std::uint8_t>(tag << k_state_bits | state);
+        }
+        static std::uint8_t state_of_(std::uint8_t packed) noexcept { return packed & ((1u << k_state_bits) - 1); }
+        static std::uint8_t tag_of_(std::uint8_t packed) noexcept { return static_cast<std::uint8_t>(packed >> k_state_bits); }
+
+        void complete_(bool counted) noexcept {
+            if (counted) inflight_.fetch_sub(1, std::memory_order_acq_rel);
+            completed_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::size_t max_ = 0;
+        std::atomic<std::size_t> inflight_{0};
+        std::atomic<std::size_t> released_{0};
+        std::atomic<std::uint64_t> completed_{0};
+        std::unique_ptr<std::atomic<std::uint8_t>[]> states_;
+        std::size_t mask_ = 0;
+        int tag_shift_ = 0;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+struct LatencySummary {
+    std::uint64_t count = 0;
+    std::uint64_t max = 0;
+    std::uint64_t p50 = 0;
+    std::uint64_t p99 = 0;
+    std::uint64_t p999 = 0;
+};
+
+// Fixed-bucket, log-linear (HDR-style) histogram of microsecond latencies.
+// Values below 16 us get exact buckets; above that every power of two is split into
+// 16 sub-buckets, so a reported percentile is within ~6% of the true value. Values
+// beyond ~71 minutes land in the last bucket.
+//
+// record() is wait-free (one relaxed increment) and may run on any thread; readers
+// take snapshots and diff them, so nothing is ever reset under a writer.
+class LatencyHistogram {
+    public:
+        static constexpr int k_sub_bits = 4;
+        static constexpr std::size_t k_sub_buckets = std::size_t{1} << k_sub_bits;
+        static constexpr int k_max_exponent = 31;
+        static constexpr std::size_t k_buckets = k_sub_buckets * (k_max_exponent - k_sub_bits + 2);
+
+        using Counts = std::array<std::uint64_t, k_buckets>;
+
+        static constexpr std::size_t bucket_of(std::uint64_t value_us) noexcept {
+            if (value_us < k_sub_buckets) return static_cast<std::size_t>(value_us);
+            const int exponent = std::bit_width(value_us) - 1;
+            if (exponent > k_max_exponent) return k_buckets - 1;
+            const auto sub = static_cast<std::size_t>((value_us >> (exponent - k_sub_bits)) & (k_sub_buckets - 1));
+            return k_sub_buckets * static_cast<std::size_t>(exponent - k_sub_bits + 1) + sub;
+        }
+
+        // largest value that maps to `bucket`
+        static constexpr std::uint64_t upper_bound_of(std::size_t bucket) noexcept {
+            if (bucket < k_sub_buckets) return bucket;
+            const auto exponent = static_cast<int>(bucket / k_sub_buckets) + k_sub_bits - 1;
+            const std::uint64_t sub = bucket % k_sub_buckets;
+            const int shift = exponent - k_sub_bits;
+            return ((k_sub_buckets + sub + 1) << shift) - 1;
+        }
+
+        void record(std::uint64_t value_us) noexcept {
+            counts_[bucket_of(value_us)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        template <typename Rep, typename Period>
+        void record(std::chrono::duration<Rep, Period> elapsed) noexcept {
+            const auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+            record(us < 0 ? 0 : static_cast<std::uint64_t>(us));
+        }
+
+        void snapshot(Counts& out) const noexcept {
+            for (std::size_t i = 0; i < k_buckets; ++i) out[i] = counts_[i].load(std::memory_order_relaxed);
+        }
+
+        // adds this histogram's counts to `out` (merging many histograms into one snapshot)
+        void accumulate(Counts& out) const noexcept {
+            for (std::size_t i = 0; i < k_buckets; ++i) out[i] += counts_[i].load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::array<std::atomic<std::uint64_t>, k_buckets> counts_{};
+};
+
+// Records the lifetime of the scope into a histogram.
+class LatencyTimer {
+    public:
+        explicit LatencyTimer(LatencyHistogram& histogram) noexcept
+            : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+        ~LatencyTimer() { histogram_.record(std::chrono::steady_clock::now() - start_); }
+
+        LatencyTimer(const LatencyTimer&) = delete;
+        LatencyTimer& operator = (const LatencyTimer&) = delete;
+
+    private:
+        LatencyHistogram& histogram_;
+        std::chrono::steady_clock::time_point start_;
+};
+
+// Summarizes what a histogram recorded since the previous call (reader side, one thread).
+class LatencyWindow {
+    public:
+        LatencySummary update(const LatencyHistogram& histogram) {
+            LatencyHistogram::Counts now;
+            histogram.snapshot(now);
+            return update(now);
+        }
+
+        // `now` is a cumulative snapshot, e.g. several histograms merged with accumulate()
+        LatencySummary update(const LatencyHistogram::Counts& now) {
+            LatencySummary out;
+            for (std::size_t i = 0; i < now.size(); ++i) {
+                delta_[i] = now[i] - prev_[i];
+                out.count += delta_[i];
+            }
+            prev_ = now;
+            if (out.count == 0) return out;
+
+            out.p50 = percentile_(out.count, 0.50);
+            out.p99 = percentile_(out.count, 0.99);
+            out.p999 = percentile_(out.count, 0.999);
+            for (std::size_t i = delta_.size(); i-- > 0;) {
+                if (delta_[i] != 0) { out.max = LatencyHistogram::upper_bound_of(i); break; }
+            }
+            return out;
+        }
+
+    private:
+        std::uint64_t percentile_(std::uint64_t total, double q) const {
+            // 1-based rank of the q-quantile sample
+            const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(total))));
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < delta_.size(); ++i) {
+                seen += delta_[i];
+                if (seen >= rank) return LatencyHistogram::upper_bound_of(i);
+            }
+            return LatencyHistogram::upper_bound_of(delta_.size() - 1);
+        }
+
+        LatencyHistogram::Counts prev_{};
+        LatencyHistogram::Counts delta_{};
+};
@@ -1,16 +1,15 @@
 #pragma once
 
 #include <atomic>
-#include <chrono>
-#include <ctime>
-#include <iomanip>
-#include <iostream>
-#include <mutex>
-#include <sstream>
-#include <string>
+#include <cstdint>
 #include <string_view>
 #include <array>
 
+// Lowest level compiled into the binary (0=debug ... 4=off); set via -DTELEMETRY_LOG_MIN_LEVEL.
+#ifndef TELEMETRY_LOG_MIN_LEVEL
+#define TELEMETRY_LOG_MIN_LEVEL 0
+#endif
+
 namespace logger {
 
     enum class Level : int { Debug = 0, Info = 1, Warn = 2, Error = 3, Off = 4 };
@@ -35,6 +34,10 @@ namespace logger {
         return "INFO";
     }
 
+    constexpr bool compiled_in(Level lvl) {
+        return static_cast<int>(lvl) >= TELEMETRY_LOG_MIN_LEVEL && lvl != Level::Off;
+    }
+
     inline std::atomic<Level>& current_level() {
         static std::atomic<Level> lvl{Level::Info};
         return lvl;
@@ -49,36 +52,31 @@ namespace logger {
             current_level().load(std::memory_order_relaxed) != Level::Off;
     }
 
-    inline std::mutex& mutex() {
-        static std::mutex m;
-        return m;
-    }
-
-    inline std::string timestamp() {
-        const auto now = std::chrono::system_clock::now();
-        const std::time_t t = std::chrono::system_clock::to_time_t(now);
-
-        std::tm tm{};
-
-        #if defined(_WIN32) 
-            localtime_s(&tm, &t);
-        #else 
-            localtime_r(&t, &tm);
-        #endif
-
-        std::ostringstream oss;
-        oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
-        return oss.str();
-    }
-
-    inline void write(Level lvl, std::string_view file, int line, std::string_view msg) {
-        if (!enabled(lvl)) return;
-        std::lock_guard<std::mutex> lock(mutex());
-        std::cerr << timestamp()
-            << " [" << level_str(lvl) << "] "
-            << file << ":" << line << " - "
-            << msg << '\n'; 
-    }
+    // Formats and emits one line. Synchronous (stderr, under a mutex) until start_async();
+    // afterwards the record is copied into a per-thread lock-free buffer and written by a
+    // background thread. Messages longer than max_message_len are truncated.
+    void write(Level lvl, std::string_view file, int line, std::string_view msg);
+
+    inline constexpr std::size_t max_message_len = 448;
+    // records a thread can have waiting for the background writer before write() drops them
+    inline constexpr std::size_t thread_buffer_records = 128;
+
+    // starts the background writer; idempotent
+    void start_async();
+    // writes everything still buffered, stops the writer and returns to synchronous mode
+    void stop_async();
+    // blocks until every record logged so far by any thread has been written
+    void flush();
+    // records lost because a thread's buffer was full
+    std::uint64_t dropped();
+
+    // RAII helper for main(): async logging for the lifetime of the guard
+    struct AsyncGuard {
+        AsyncGuard() { start_async(); }
+        ~AsyncGuard() { stop_async(); }
+        AsyncGuard(const AsyncGuard&) = delete;
+        AsyncGuard& operator = (const AsyncGuard&) = delete;
+    };
 
     inline Level parse_level(std::string_view str) {
         for (const auto& lvl_entry : level_table) {
@@ -97,7 +95,15 @@ namespace logger {
 } // namespace logger
 
 // ---- Convenience macros ----
-#define LOG_DEBUG(msg) ::logger::write(::logger::Level::Debug, __FILE__, __LINE__, (msg))
-#define LOG_INFO(msg) ::logger::write(::logger::Level::Info, __FILE__, __LINE__, (msg))
-#define LOG_WARN(msg) ::logger::write(::logger::Level::Warn, __FILE__, __LINE__, (msg))
-#define LOG_ERROR(msg) ::logger::write(::logger::Level::Error, __FILE__, __LINE__, (msg))
\ No newline at end of file
+// `msg` is only evaluated when the level is compiled in and currently enabled.
+#define LOG_AT_(lvl, msg) \
+    do { \
+        if constexpr (::logger::compiled_in(lvl)) { \
+            if (::logger::enabled(lvl)) ::logger::write((lvl), __FILE__, __LINE__, (msg)); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(msg) LOG_AT_(::logger::Level::Debug, msg)
+#define LOG_INFO(msg) LOG_AT_(::logger::Level::Info, msg)
+#define LOG_WARN(msg) LOG_AT_(::logger::Level::Warn, msg)
+#define LOG_ERROR(msg) LOG_AT_(::logger::Level::Error, msg)
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#include "app_config.h"
+#include "counter_registry.h"
+#include "metrics_snapshot.h"
+#include "process_stats.h"
+
+// OpenMetrics text exposition of the health message's content: publisher counters and latency
+// histograms (from `snapshot`), the pipeline counters of `registry`, process resource use and
+// uptime. Ends with "# EOF".
+std::string render_openmetrics(const MetricsSnapshot& snapshot, const CounterRegistry& registry,
+                               const ProcessStats& process, std::uint64_t uptime_s);
+
+// Local scrape endpoint (metrics_endpoint.enabled): plain HTTP/1.1 GET /metrics on a Unix domain
+// socket or 127.0.0.1, served by its own thread with non-blocking sockets and poll(). It only
+// reads the lock-free snapshot and registry, so a slow or stuck scraper never blocks sampling or
+// publishing. Each connection gets one response and is closed.
+class MetricsEndpoint {
+    public:
+        using TimePoint = std::chrono::steady_clock::time_point;
+
+        // binds and starts serving; throws std::runtime_error if the socket cannot be set up.
+        // snapshot and registry must outlive the endpoint.
+        MetricsEndpoint(const MetricsEndpointConfig& cfg, const MetricsSnapshot& snapshot,
+                        const CounterRegistry& registry, TimePoint start);
+        ~MetricsEndpoint();
+
+        MetricsEndpoint(const MetricsEndpoint&) = delete;
+        MetricsEndpoint& operator = (const MetricsEndpoint&) = delete;
+
+        std::uint64_t scrapes() const noexcept { return scrapes_.load(std::memory_order_relaxed); }
+
+    private:
+        void run_();
+        std::string respond_(std::string_view request);
+
+        const MetricsSnapshot& snapshot_;
+        const CounterRegistry& registry_;
+        TimePoint start_;
+        std::string unix_path_; // unlinked on shutdown
+        int listen_fd_ = -1;
+        int stop_fd_ = -1;      // eventfd; written by the destructor
+        ProcessStatsReader process_stats_; // serving thread only
+        std::atomic<std::uint64_t> scrapes_{0};
+        std::thread thread_;
+};
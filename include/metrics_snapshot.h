@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "health_payload.h"
+#include "latency_histogram.h"
+
+// Publisher state copied out for readers on other threads (the OpenMetrics endpoint). The
+// publishing thread stores it periodically with relaxed atomic stores, and readers load it the
+// same way, so neither side ever waits. Values are individually current, not a consistent set.
+class MetricsSnapshot {
+    public:
+        enum class Stage : std::size_t { Sample, Serialize, Publish, Ack, Count }; // as in LatencyReport
+
+        void store(const HealthCounters& counters, bool connected) noexcept {
+            for (std::size_t i = 0; i < health_counter_fields.size(); ++i) {
+                counters_[i].store(counters.*health_counter_fields[i].member, std::memory_order_relaxed);
+            }
+            connected_.store(connected, std::memory_order_relaxed);
+        }
+
+        void store(Stage stage, const LatencyHistogram& histogram) noexcept {
+            LatencyHistogram::Counts counts;
+            histogram.snapshot(counts);
+            store(stage, counts);
+        }
+
+        void store(Stage stage, const LatencyHistogram::Counts& counts) noexcept {
+            auto& out = latency_[static_cast<std::size_t>(stage)];
+            for (std::size_t i = 0; i < counts.size(); ++i) out[i].store(counts[i], std::memory_order_relaxed);
+        }
+
+        HealthCounters counters() const noexcept {
+            HealthCounters out;
+            for (std::size_t i = 0; i < health_counter_fields.size(); ++i) {
+                out.*health_counter_fields[i].member = counters_[i].load(std::memory_order_relaxed);
+            }
+            return out;
+        }
+
+        bool connected() const noexcept { return connected_.load(std::memory_order_relaxed); }
+
+        void latency(Stage stage, LatencyHistogram::Counts& out) const noexcept {
+            const auto& in = latency_[static_cast<std::size_t>(stage)];
+            for (std::size_t i = 0; i < out.size(); ++i) out[i] = in[i].load(std::memory_order_relaxed);
+        }
+
+    private:
+        using AtomicCounts = std::array<std::atomic<std::uint64_t>, LatencyHistogram::k_buckets>;
+
+        std::array<std::atomic<std::uint64_t>, health_counter_fields.size()> counters_{};
+        std::atomic<bool> connected_{false};
+        std::array<AtomicCounts, static_cast<std::size_t>(Stage::Count)> latency_{};
+};
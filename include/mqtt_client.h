@@ -9,30 +9,111 @@
 #include <random>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <vector>
 
+#include "ack_timer.h"
+#include "broker_selector.h"
+#include "counter_registry.h"
+#include "inflight_window.h"
+#include "latency_histogram.h"
 #include "reconnect_backoff.h"
+#include "payload_writer.h"
+#include "tcp_probe.h"
+#include "topic_alias.h"
 
 using Clock = std::chrono::steady_clock;
 using TimePoint = Clock::time_point;
 
+// MQTT 5 mode; ignored unless enabled
+struct Mqtt5Options {
+    bool enabled = false;
+    bool topic_aliases = true;          // up to the broker's Topic Alias Maximum, per connection
+    std::uint32_t message_expiry_s = 0; // 0 = no Message Expiry Interval
+    std::string content_type;           // Content Type property of publish() messages (empty = none)
+};
+
+// per-message MQTT 5 properties handed to the publish function
+struct MessageProps {
+    std::uint16_t topic_alias = 0;      // 0 = none; with topic == nullptr the alias alone names the topic
+    std::uint32_t message_expiry_s = 0;
+    const char* content_type = nullptr;
+    const char* content_encoding = nullptr; // "content-encoding" user property (compressed payloads)
+};
+
 class MqttClient {
     public:
-        MqttClient(std::string host, int port, std::string client_id, int qos);
+        // telemetry_content_type is advertised in the retained status payload (empty for JSON)
+        MqttClient(std::string host, int port, std::string client_id, int qos, std::string telemetry_content_type = {},
+                   Mqtt5Options v5 = {});
         ~MqttClient();
 
         MqttClient(const MqttClient&) = delete;
         MqttClient& operator = (const MqttClient&) = delete;
         
-        bool connect(int keepalive_seconds = 60);
-        void tick(); // pulse (non-blocking reconnect attempts)
+        // Failover across several brokers: connection attempts go to the endpoint BrokerSelector
+        // picks instead of the constructor's host/port, a failed or lost broker is skipped while
+        // it cools down, and tick() fails back to a preferred one (priority policy). Call before connect().
+        void set_brokers(std::vector<BrokerEndpoint> endpoints, FailoverOptions opts);
+        // "host:port" of the current session or attempt
+        std::string broker() const;
+        // Extra session of a sharded device (broker.connections): no LWT and no online/offline
+        // status, since the primary session reports for the device. Call before connect().
+        void disable_status() noexcept;
+
+        // Without start_network_thread the caller drives the connection through socket(),
+        // want_write() and service_io() (fleet mode multiplexes many clients over one thread).
+        bool connect(int keepalive_seconds = 60, bool start_network_thread = true);
+        void tick(); // pulse (non-blocking reconnect attempts, fail back)
         std::uint64_t reconnects() const noexcept { return reconnects_.load(std::memory_order_relaxed); }
+        bool connected() const noexcept { return connected_.load(std::memory_order_relaxed); }
         
-        bool publish(std::string_view topic, std::string_view payload, int qos = 0, bool retain = false);
+        // not thread-safe: call from a single (publishing) thread.
+        // Returns false without sending while the in-flight window is full.
+        // content_encoding is sent as a user property in MQTT 5 mode (NUL-terminated, may be null);
+        // such a zlib-compressed message gets the Content Type application/zlib.
+        bool publish(std::string_view topic, std::string_view payload, int qos = 0, bool retain = false,
+                     const char* content_encoding = nullptr);
+
+        // QoS > 0 messages published but not yet acked; 0 = unbounded (the default)
+        void set_max_inflight(std::size_t max_inflight) noexcept { window_.set_max(max_inflight); }
+        // Sizes mid tracking (in-flight window, ack timing) for the current max_inflight instead
+        // of every possible mid: ~3 KB per client instead of ~72 KB, for fleet mode's thousands
+        // of clients. Call before connect(); unbounded (0) keeps the full size.
+        void compact_tracking();
+        bool window_full() const noexcept { return window_.full(); }
+        std::size_t inflight() const noexcept { return window_.inflight(); }
+        // QoS > 0 messages not acked yet: the window plus those a lost connection released, which
+        // the client library resends after reconnecting
+        std::size_t unacked() const noexcept { return window_.inflight() + window_.released(); }
+        // messages acked by the broker (QoS 1/2) or written to the socket (QoS 0), status included
+        std::uint64_t delivered() const noexcept { return window_.completed(); }
+        // messages the connection did not take (not connected or a publish error), status included
+        std::uint64_t failed() const noexcept { return failed_.load(std::memory_order_relaxed); }
+        // publish() adds payload sizes to Counter::BytesSent; the registry must outlive the client
+        void set_counters(CounterRegistry& counters) noexcept { counters_ = &counters; }
+
+        // waits up to `timeout` for outstanding acks (shutdown), including those of messages a lost
+        // connection released; true once unacked() reaches 0
+        bool drain(std::chrono::milliseconds timeout);
 
         void stop() noexcept;
 
+        // ----external loop (connect() without a network thread); same thread as publish()----
+        int socket() const noexcept { return mosq_ ? mosquitto_socket(mosq_) : -1; }
+        bool want_write() const noexcept { return mosq_ && mosquitto_want_write(mosq_); }
+        // reads and/or writes as the poller reported, then runs keepalive housekeeping
+        void service_io(bool readable, bool writable) noexcept;
+        // when tick() next has work: the next backoff attempt or the timeout of the attempt in
+        // flight; TimePoint::max() while connected
+        TimePoint reconnect_due() const noexcept;
+
         const std::string& client_id() const { return client_id_; };
 
+        // time spent inside mosquitto_publish, and publish -> broker ack for QoS > 0
+        const LatencyHistogram& publish_latency() const noexcept { return publish_latency_; }
+        const LatencyHistogram& ack_latency() const noexcept { return ack_latency_; }
+
     private:
         // ----common variables----
         std::string host_;
@@ -48,8 +129,11 @@ class MqttClient {
         std::atomic<bool> loop_started_ {false};
 
         static void on_connect(struct mosquitto* mosq, void* obj, int rc);
+        static void on_connect_v5(struct mosquitto* mosq, void* obj, int rc, int flags, const mosquitto_property* props);
         static void on_disconnect(struct mosquitto* mosq, void* obj, int rc);
+        static void on_publish(struct mosquitto* mosq, void* obj, int mid);
         bool ensure_connected();
+        void wait_io_(std::chrono::milliseconds timeout) noexcept; // sleeps, or services the socket without a network thread
 
         // ----reconnect----
         // flags
@@ -58,6 +142,7 @@ class MqttClient {
         // in-flight timeout tracking
         std::atomic<int64_t> reconnect_started_ticks_{0};
         static constexpr auto k_reconnect_in_flight_timeout = std::chrono::seconds(15);
+        std::chrono::seconds reconnect_timeout_ = k_reconnect_in_flight_timeout; // failover: connect_timeout
         bool in_flight_timed_out_(TimePoint now) noexcept;
 
         // helper to convert Timepoint -> int64 ticks
@@ -68,19 +153,77 @@ class MqttClient {
 
         // counters
         std::atomic<uint64_t> reconnects_ {0};
+        std::atomic<uint64_t> failed_ {0}; // publish() and status (network thread)
 
-        std::function<int()> reconnect_fn_ = [this] { return mosquitto_reconnect_async(mosq_); };
+        std::function<int()> reconnect_fn_ = [this] {
+            return selector_ ? connect_endpoint_(attempt_index_) : mosquitto_reconnect_async(mosq_);
+        };
+
+        using PublishFn = std::function<int(int* mid, const char* topic, int payload_len, const void* payload, int qos, bool retain,
+                                            const MessageProps& props)>;
+        PublishFn publish_fn_ = [this](int* mid, const char* topic, int payload_len, const void* payload, int qos, bool retain,
+                                       const MessageProps& props) {
+            return mosquitto_publish_(mid, topic, payload_len, payload, qos, retain, props);
+        };
+        int mosquitto_publish_(int* mid, const char* topic, int payload_len, const void* payload, int qos, bool retain,
+                               const MessageProps& props);
 
         void tick_reconnect_();
 
+        // ----failover (set_brokers)----
+        // attempt_* are written by the ticking thread and read by callbacks on the network thread
+        mutable std::mutex failover_mutex_;
+        std::unique_ptr<BrokerSelector> selector_;
+        std::size_t attempt_index_ = 0;  // endpoint of the current session or attempt
+        bool attempt_open_ = false;      // attempt or session whose failure has not been recorded yet
+        TimePoint attempt_started_{};
+        TimePoint session_started_{};
+        int keepalive_s_ = 60;
+        // failback leaves the live session only once the preferred broker accepts a TCP
+        // connection; ticking thread only
+        TcpProbe probe_;
+        std::size_t probe_target_ = BrokerSelector::npos;
+        std::function<TcpProbe::Result(const BrokerEndpoint&, TimePoint)> probe_fn_ = [this](const BrokerEndpoint& endpoint, TimePoint now) {
+            if (!probe_.active()) probe_.start(endpoint.host, endpoint.port, now + reconnect_timeout_);
+            return probe_.poll(now);
+        };
+
+        int connect_endpoint_(std::size_t index);
+        bool begin_attempt_(TimePoint now); // picks the endpoint; false while all of them cool down
+        void failover_connected_(TimePoint now);
+        void failover_failed_(TimePoint now);
+        void tick_failback_();
+
         // ----status/LWT----
         std::string status_topic_;
-        std::string will_payload_; // offline
-        std::string online_payload_; // online
+        std::string telemetry_content_type_;
+        std::string will_payload_; // offline (LWT, rendered once at setup)
+        StatusPayloadWriter online_status_{client_id_, telemetry_content_type_};  // used from on_connect (network thread)
+        StatusPayloadWriter offline_status_{client_id_, telemetry_content_type_}; // used from stop()
         int qos_;
+        bool status_enabled_ = true;
 
         void setup_lwt_();
-        void publish_status_(const std::string& payload);
+        void publish_status_(std::string_view payload);
+
+        // ----MQTT 5----
+        Mqtt5Options v5_;
+        // written by on_connect/on_disconnect (network thread), applied by publish() when the generation changes
+        std::atomic<std::uint16_t> alias_max_{0};
+        std::atomic<std::uint32_t> alias_generation_{0};
+        TopicAliasTable aliases_;          // publishing thread only
+        std::uint32_t aliases_generation_ = 0;
+
+        void sync_aliases_();
+
+        // ----latency----
+        LatencyHistogram publish_latency_;
+        LatencyHistogram ack_latency_;
+        AckTimer ack_timer_;
+
+        // ----in-flight window----
+        InflightWindow window_;
+        CounterRegistry* counters_ = nullptr;
 
         // ----time functions----
         std::function<TimePoint()> now_fn_ = [] { return Clock::now(); };
@@ -104,10 +247,20 @@ class MqttClient {
 
         void set_now_fn_for_test(std::function<TimePoint()> func) { now_fn_ = std::move(func); }
         void set_reconnect_fn_for_test(std::function<int()> func) { reconnect_fn_ = std::move(func); }
+        void set_probe_fn_for_test(std::function<TcpProbe::Result(const BrokerEndpoint&, TimePoint)> func) {
+            probe_fn_ = std::move(func);
+        }
+        void set_publish_fn_for_test(PublishFn func) { publish_fn_ = std::move(func); }
         void set_mosq_present_for_test(bool present) { 
             mosq_present_for_test_.store(present, std::memory_order_relaxed); 
         }
         void simulate_connect_for_test(int rc) { MqttClient::on_connect(nullptr, this, rc); }
+        void simulate_connect_v5_for_test(int rc, std::uint16_t topic_alias_max) {
+            alias_max_.store(topic_alias_max, std::memory_order_relaxed);
+            alias_generation_.fetch_add(1, std::memory_order_release);
+            MqttClient::on_connect(nullptr, this, rc);
+        }
+        void simulate_publish_ack_for_test(int mid) { MqttClient::on_publish(nullptr, this, mid); }
         void simulate_disconnect_for_test(int rc) { MqttClient::on_disconnect(nullptr, this, rc); } 
         static constexpr auto reconnect_in_flight_timeout_for_test() noexcept {
             return k_reconnect_in_flight_timeout;
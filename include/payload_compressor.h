@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// zlib (RFC 1950) compression of outgoing payloads with an optional preset dictionary.
+//
+// The stream is self-describing: a zlib header starts with 0x78, which no payload_format
+// produces, and with a dictionary its FDICT flag is set and the header carries the
+// dictionary's Adler-32 as DICTID, so consumers know which dictionary to hand to inflate().
+// A good dictionary is a concatenation of typical payloads (zlib only uses its last 32 KiB).
+//
+// Not thread-safe; owned by the publishing thread.
+class PayloadCompressor {
+    public:
+        struct Options {
+            int level = 6;                // zlib level 1..9
+            std::size_t min_bytes = 256;  // smaller payloads are sent as-is
+            std::string dictionary;       // raw dictionary bytes; empty = none
+        };
+
+        // throws std::runtime_error if zlib cannot be initialized
+        explicit PayloadCompressor(Options opts);
+        ~PayloadCompressor();
+
+        PayloadCompressor(const PayloadCompressor&) = delete;
+        PayloadCompressor& operator = (const PayloadCompressor&) = delete;
+
+        // compressed payload (valid until the next call), or `payload` itself when it is below
+        // min_bytes or would not shrink
+        std::string_view compress(std::string_view payload);
+
+        // Adler-32 of the dictionary (the zlib DICTID), 0 without one
+        std::uint32_t dictionary_id() const noexcept { return dictionary_id_; }
+
+        // MQTT 5 "content-encoding" user property value: "zlib" or "zlib; dict=<8 hex digits>"
+        const std::string& content_encoding() const noexcept { return content_encoding_; }
+
+        // totals over compressed messages only
+        std::uint64_t bytes_in() const noexcept { return bytes_in_; }
+        std::uint64_t bytes_out() const noexcept { return bytes_out_; }
+        std::uint64_t cpu_us() const noexcept { return cpu_ns_ / 1000; }
+
+    private:
+        Options opts_;
+        void* stream_ = nullptr; // z_stream, kept out of the header
+        std::string out_;
+        std::uint32_t dictionary_id_ = 0;
+        std::string content_encoding_;
+
+        std::uint64_t bytes_in_ = 0;
+        std::uint64_t bytes_out_ = 0;
+        std::uint64_t cpu_ns_ = 0;
+};
+
+// true if `payload` starts with a zlib header, i.e. was produced by PayloadCompressor
+inline bool is_zlib_payload(std::string_view payload) noexcept {
+    if (payload.size() < 2) return false;
+    const auto cmf = static_cast<std::uint8_t>(payload[0]);
+    const auto flg = static_cast<std::uint8_t>(payload[1]);
+    return cmf == 0x78 && ((cmf << 8) | flg) % 31 == 0;
+}
+
+// inverse of PayloadCompressor::compress (consumers, tests); throws std::runtime_error on bad input
+std::string decompress_payload(std::string_view payload, std::string_view dictionary = {});
+
+// reads a dictionary file; throws std::runtime_error
+std::string load_compression_dictionary(const std::string& path);
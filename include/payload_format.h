@@ -0,0 +1,99 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Wire encodings for the v1 payloads. The payload schema is the same in every format;
+// only the encoding differs. Consumers can tell the formats apart from the first bytes:
+//   json_v1  -> '{'
+//   cbor     -> CBOR self-describe tag 55799 (0xD9 0xD9 0xF7)
+//   msgpack  -> map header (0x80-0x8F, 0xDE, 0xDF)
+// The retained status payload also advertises the telemetry content type when it is not JSON.
+enum class PayloadFormat : int { JsonV1 = 0, Cbor = 1, MsgPack = 2 };
+
+struct PayloadFormatEntry {
+    std::string_view name;
+    PayloadFormat fmt;
+    std::string_view content_type;
+};
+
+inline constexpr std::array<PayloadFormatEntry, 3> payload_format_table{{
+    {"json_v1", PayloadFormat::JsonV1, "application/json"},
+    {"cbor", PayloadFormat::Cbor, "application/cbor"},
+    {"msgpack", PayloadFormat::MsgPack, "application/msgpack"},
+}};
+
+inline constexpr std::array<std::uint8_t, 3> k_cbor_self_describe{0xD9, 0xD9, 0xF7};
+
+inline bool try_parse_payload_format(std::string_view str, PayloadFormat& out) {
+    for (const auto& entry : payload_format_table) {
+        if (str == entry.name) { out = entry.fmt; return true; }
+    }
+    return false;
+}
+
+inline std::string_view payload_format_name(PayloadFormat fmt) {
+    for (const auto& entry : payload_format_table) {
+        if (fmt == entry.fmt) return entry.name;
+    }
+    return "json_v1";
+}
+
+inline std::string_view content_type(PayloadFormat fmt) {
+    for (const auto& entry : payload_format_table) {
+        if (fmt == entry.fmt) return entry.content_type;
+    }
+    return "application/json";
+}
+
+inline std::string encode_payload(const nlohmann::json& payload, PayloadFormat fmt) {
+    switch (fmt) {
+        case PayloadFormat::Cbor: {
+            std::vector<std::uint8_t> bytes = nlohmann::json::to_cbor(payload);
+            std::string out(k_cbor_self_describe.begin(), k_cbor_self_describe.end());
+            out.append(bytes.begin(), bytes.end());
+            return out;
+        }
+        case PayloadFormat::MsgPack: {
+            std::vector<std::uint8_t> bytes = nlohmann::json::to_msgpack(payload);
+            return std::string(bytes.begin(), bytes.end());
+        }
+        case PayloadFormat::JsonV1:
+        default:
+            return payload.dump();
+    }
+}
+
+inline PayloadFormat detect_payload_format(std::string_view bytes) {
+    if (!bytes.empty() && bytes.front() == '{') return PayloadFormat::JsonV1;
+    if (bytes.size() >= k_cbor_self_describe.size() &&
+        static_cast<std::uint8_t>(bytes[0]) == k_cbor_self_describe[0] &&
+        static_cast<std::uint8_t>(bytes[1]) == k_cbor_self_describe[1] &&
+        static_cast<std::uint8_t>(bytes[2]) == k_cbor_self_describe[2]) {
+        return PayloadFormat::Cbor;
+    }
+    return PayloadFormat::MsgPack;
+}
+
+// consumer-side helper (used by tests and tooling)
+inline nlohmann::json decode_payload(std::string_view bytes) {
+    switch (detect_payload_format(bytes)) {
+        case PayloadFormat::JsonV1:
+            return nlohmann::json::parse(bytes);
+        case PayloadFormat::Cbor: {
+            const auto* data = reinterpret_cast<const std::uint8_t*>(bytes.data());
+            // tag 55799 carries no meaning beyond "this is CBOR", skip it
+            return nlohmann::json::from_cbor(data + k_cbor_self_describe.size(), data + bytes.size());
+        }
+        case PayloadFormat::MsgPack:
+        default: {
+            const auto* data = reinterpret_cast<const std::uint8_t*>(bytes.data());
+            return nlohmann::json::from_msgpack(data, data + bytes.size());
+        }
+    }
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "health_payload.h"
+
+// Allocation-free writers for the v1 payloads. The output is byte-identical to
+// make_*_payload_v1(...).dump(): nlohmann::json objects dump their keys in sorted
+// order, so every constant fragment can be rendered once up front and only the
+// numbers are formatted per message into a reused buffer.
+
+namespace payload_detail {
+
+    // JSON string literal, escaped exactly as nlohmann::json does (construction time only)
+    inline std::string quoted(std::string_view str) { return nlohmann::json(str).dump(); }
+
+    template <typename Int>
+    inline void append_int(std::string& out, Int value) {
+        std::array<char, 24> buf{};
+        const auto res = std::to_chars(buf.data(), buf.data() + buf.size(), value);
+        out.append(buf.data(), res.ptr);
+    }
+
+    // std::to_chars picks the shortest round-trip digits, which differs from nlohmann's
+    // Grisu2 output for some 17-digit values, so reuse nlohmann's formatter directly. It is an
+    // internal one: the *_matches_json_dump tests pin its output for the version below, so
+    // re-run them before accepting another.
+    static_assert(NLOHMANN_JSON_VERSION_MAJOR == 3 && NLOHMANN_JSON_VERSION_MINOR == 11,
+                  "payload writers are only verified byte-identical against nlohmann_json 3.11.x");
+    inline void append_double(std::string& out, double value) {
+        if (!std::isfinite(value)) {
+            out.append("null");
+            return;
+        }
+        std::array<char, 64> buf{};
+        char* end = ::nlohmann::detail::to_chars(buf.data(), buf.data() + buf.size(), value);
+        out.append(buf.data(), end);
+    }
+
+} // namespace payload_detail
+
+// Byte-identical to make_payload_v1(...).dump(), or make_payload_v2 with schema_version 2.
+class TelemetryPayloadWriter {
+    public:
+        TelemetryPayloadWriter(std::string_view client_id, std::string_view metric_name, std::string_view unit,
+                               int schema_version = 1)
+            : schema_version_(schema_version) {
+            buf_ = "{\"device\":{\"client_id\":" + payload_detail::quoted(client_id) +
+                   "},\"metric\":{\"name\":" + payload_detail::quoted(metric_name) +
+                   ",\"unit\":" + payload_detail::quoted(unit) +
+                   ",\"value\":";
+            prefix_len_ = buf_.size();
+            buf_.reserve(prefix_len_ + k_max_variable_len);
+        }
+
+        // returned view is valid until the next write(); timestamp_ms is written by schema 2 only
+        std::string_view write(double value, std::uint64_t seq, std::int64_t timestamp_s, std::int64_t timestamp_ms = 0) {
+            buf_.resize(prefix_len_);
+            payload_detail::append_double(buf_, value);
+            buf_.append(schema_version_ >= 2 ? "},\"schema_version\":2,\"seq\":" : "},\"schema_version\":1,\"seq\":");
+            payload_detail::append_int(buf_, seq);
+            if (schema_version_ >= 2) {
+                buf_.append(",\"timestamp_ms\":");
+                payload_detail::append_int(buf_, timestamp_ms);
+            }
+            buf_.append(",\"timestamp_s\":");
+            payload_detail::append_int(buf_, timestamp_s);
+            buf_.push_back('}');
+            return buf_;
+        }
+
+    private:
+        static constexpr std::size_t k_max_variable_len = 128;
+
+        std::string buf_;
+        std::size_t prefix_len_ = 0;
+        int schema_version_;
+};
+
+class HealthPayloadWriter {
+    public:
+        explicit HealthPayloadWriter(std::string_view client_id)
+            : device_("},\"device\":{\"client_id\":" + payload_detail::quoted(client_id) + "}") {
+            buf_.reserve(device_.size() + k_max_variable_len);
+        }
+
+        std::string_view write(std::uint64_t uptime_s, std::uint64_t seq, const HealthCounters& counters, std::uint64_t now_s,
+                               const LatencyReport* latency = nullptr, const ProcessStats* process = nullptr) {
+            buf_.assign("{\"counters\":{");
+            for (std::size_t i = 0; i < health_counter_fields.size(); ++i) {
+                const auto& field = health_counter_fields[i];
+                if (i > 0) buf_.push_back(',');
+                buf_.push_back('"');
+                buf_.append(field.key);
+                buf_.append("\":");
+                payload_detail::append_int(buf_, counters.*field.member);
+            }
+            buf_.append(device_);
+            if (latency) {
+                buf_.append(",\"latency_us\":{");
+                for (std::size_t i = 0; i < latency_stage_fields.size(); ++i) {
+                    const auto& stage = latency_stage_fields[i];
+                    if (i > 0) buf_.push_back(',');
+                    buf_.push_back('"');
+                    buf_.append(stage.key);
+                    buf_.append("\":{");
+                    for (std::size_t j = 0; j < latency_summary_fields.size(); ++j) {
+                        const auto& field = latency_summary_fields[j];
+                        if (j > 0) buf_.push_back(',');
+                        buf_.push_back('"');
+                        buf_.append(field.key);
+                        buf_.append("\":");
+                        payload_detail::append_int(buf_, (*latency).*stage.member.*field.member);
+                    }
+                    buf_.push_back('}');
+                }
+                buf_.push_back('}');
+            }
+            if (process) {
+                buf_.append(",\"process\":{");
+                for (std::size_t i = 0; i < process_stats_fields.size(); ++i) {
+                    const auto& field = process_stats_fields[i];
+                    if (i > 0) buf_.push_back(',');
+                    buf_.push_back('"');
+                    buf_.append(field.key);
+                    buf_.append("\":");
+                    payload_detail::append_int(buf_, (*process).*field.member);
+                }
+                buf_.push_back('}');
+            }
+            buf_.append(",\"schema_version\":1,\"seq\":");
+            payload_detail::append_int(buf_, seq);
+            buf_.append(",\"timestamp_s\":");
+            payload_detail::append_int(buf_, now_s);
+            buf_.append(",\"uptime_s\":");
+            payload_detail::append_int(buf_, uptime_s);
+            buf_.push_back('}');
+            return buf_;
+        }
+
+    private:
+        static constexpr std::size_t k_max_variable_len = 1024;
+
+        std::string device_;
+        std::string buf_;
+};
+
+class StatusPayloadWriter {
+    public:
+        explicit StatusPayloadWriter(std::string_view client_id, std::string_view telemetry_content_type = {})
+            : prefix_("{\"device\":{\"client_id\":" + payload_detail::quoted(client_id) + "},\"schema_version\":1,\"state\":") {
+            if (!telemetry_content_type.empty()) {
+                suffix_ = ",\"telemetry_content_type\":" + payload_detail::quoted(telemetry_content_type);
+            }
+            buf_.reserve(prefix_.size() + suffix_.size() + k_max_variable_len);
+        }
+
+        // state is one of the fixed literals ("online"/"offline"), so it needs no escaping
+        std::string_view write(std::string_view state, std::int64_t timestamp_s) {
+            buf_.assign(prefix_);
+            buf_.push_back('"');
+            buf_.append(state);
+            buf_.append("\"");
+            buf_.append(suffix_);
+            buf_.append(",\"timestamp_s\":");
+            payload_detail::append_int(buf_, timestamp_s);
+            buf_.push_back('}');
+            return buf_;
+        }
+
+    private:
+        static constexpr std::size_t k_max_variable_len = 64;
+
+        std::string prefix_;
+        std::string suffix_;
+        std::string buf_;
+};
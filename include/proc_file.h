@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// A /proc or /sys file kept open for the daemon's lifetime and re-read from offset 0 with
+// pread() each sample: procfs and sysfs regenerate the contents on every read at offset 0,
+// so there is no reopen and no seek. The buffer is sized once; reads never allocate.
+class ProcFile {
+    public:
+        explicit ProcFile(std::size_t capacity = 4096) : buf_(capacity) {}
+        ~ProcFile() { close_(); }
+
+        ProcFile(const ProcFile&) = delete;
+        ProcFile& operator = (const ProcFile&) = delete;
+
+        bool open(const std::string& path) {
+            close_();
+            fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            return fd_ >= 0;
+        }
+
+        bool is_open() const noexcept { return fd_ >= 0; }
+
+        // current contents, truncated to the buffer capacity; empty on error
+        std::string_view read() noexcept {
+            if (fd_ < 0) return {};
+            ssize_t n;
+            do { n = ::pread(fd_, buf_.data(), buf_.size(), 0); } while (n < 0 && errno == EINTR);
+            return n > 0 ? std::string_view(buf_.data(), static_cast<std::size_t>(n)) : std::string_view{};
+        }
+
+    private:
+        void close_() noexcept {
+            if (fd_ >= 0) ::close(fd_);
+            fd_ = -1;
+        }
+
+        int fd_ = -1;
+        std::vector<char> buf_;
+};
+
+namespace proc_parse {
+
+    inline bool is_space(char c) noexcept { return c == ' ' || c == '\t'; }
+
+    // the rest of the line that starts with `key` (after leading blanks) followed by a space, tab
+    // or ':'; nullopt if absent
+    inline std::optional<std::string_view> find_line(std::string_view text, std::string_view key) noexcept {
+        std::size_t pos = 0;
+        while (pos < text.size()) {
+            std::size_t end = text.find('\n', pos);
+            if (end == std::string_view::npos) end = text.size();
+            auto line = text.substr(pos, end - pos);
+            while (!line.empty() && is_space(line.front())) line.remove_prefix(1);
+            if (line.size() > key.size() && line.substr(0, key.size()) == key) {
+                const char next = line[key.size()];
+                if (is_space(next) || next == ':') return line.substr(key.size() + 1);
+            }
+            pos = end + 1;
+        }
+        return std::nullopt;
+    }
+
+    // parses up to `max` whitespace-separated unsigned integers; returns how many were read
+    inline std::size_t parse_u64s(std::string_view text, std::uint64_t* out, std::size_t max) noexcept {
+        std::size_t count = 0;
+        const char* p = text.data();
+        const char* end = p + text.size();
+        while (count < max) {
+            while (p < end && (is_space(*p) || *p == ':')) ++p;
+            if (p == end) break;
+            const auto res = std::from_chars(p, end, out[count]);
+            if (res.ec != std::errc{}) break;
+            p = res.ptr;
+            ++count;
+        }
+        return count;
+    }
+
+    // a single (possibly negative) integer, e.g. a sysfs attribute
+    inline std::optional<std::int64_t> parse_i64(std::string_view text) noexcept {
+        while (!text.empty() && is_space(text.front())) text.remove_prefix(1);
+        std::int64_t value = 0;
+        const auto res = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (res.ec != std::errc{}) return std::nullopt;
+        return value;
+    }
+
+} // namespace proc_parse
+
+// Per-second rate of a monotonically increasing counter. The first update and any update
+// after the counter went backwards (reset, wrap, interface re-created) yield no value.
+class CounterRate {
+    public:
+        using Clock     = std::chrono::steady_clock;
+        using TimePoint = Clock::time_point;
+
+        std::optional<double> update(std::uint64_t counter, TimePoint now) noexcept {
+            const bool have_prev = has_prev_;
+            const auto prev = prev_;
+            const auto prev_at = prev_at_;
+            has_prev_ = true;
+            prev_ = counter;
+            prev_at_ = now;
+
+            if (!have_prev || counter < prev || now <= prev_at) return std::nullopt;
+            const double dt = std::chrono::duration<double>(now - prev_at).count();
+            return static_cast<double>(counter - prev) / dt;
+        }
+
+    private:
+        bool has_prev_ = false;
+        std::uint64_t prev_ = 0;
+        TimePoint prev_at_{};
+};
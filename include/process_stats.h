@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "proc_file.h"
+
+// the daemon's own resource use, reported in the health payload
+struct ProcessStats {
+    std::uint64_t cpu_user_us = 0;
+    std::uint64_t cpu_sys_us = 0;
+    std::uint64_t ctx_voluntary = 0;   // blocked waiting (sleeps, I/O)
+    std::uint64_t ctx_involuntary = 0; // preempted
+    std::uint64_t rss_kb = 0;
+};
+
+// getrusage(RUSAGE_SELF) for CPU time and context switches (all threads), /proc/self/statm for
+// RSS. statm is opened once and re-read with pread, so a read does not allocate.
+class ProcessStatsReader {
+    public:
+        ProcessStatsReader() : statm_(128) {
+            (void)statm_.open("/proc/self/statm");
+            const long page = ::sysconf(_SC_PAGESIZE);
+            page_kb_ = page > 0 ? static_cast<std::uint64_t>(page) / 1024 : 4;
+        }
+
+        ProcessStats read() noexcept {
+            ProcessStats out;
+            rusage usage{};
+            if (::getrusage(RUSAGE_SELF, &usage) == 0) {
+                out.cpu_user_us = to_us_(usage.ru_utime);
+                out.cpu_sys_us = to_us_(usage.ru_stime);
+                out.ctx_voluntary = static_cast<std::uint64_t>(usage.ru_nvcsw);
+                out.ctx_involuntary = static_cast<std::uint64_t>(usage.ru_nivcsw);
+            }
+            // "size resident shared text lib data dt", in pages
+            std::uint64_t pages[2] = {0, 0};
+            if (proc_parse::parse_u64s(statm_.read(), pages, 2) == 2) out.rss_kb = pages[1] * page_kb_;
+            return out;
+        }
+
+    private:
+        static std::uint64_t to_us_(const timeval& tv) noexcept {
+            return static_cast<std::uint64_t>(tv.tv_sec) * 1000000 + static_cast<std::uint64_t>(tv.tv_usec);
+        }
+
+        ProcFile statm_;
+        std::uint64_t page_kb_ = 4;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+enum class OverflowPolicy : int { DropOldest = 0, DropNewest = 1 };
+
+inline bool try_parse_overflow_policy(std::string_view str, OverflowPolicy& out) {
+    if (str == "drop_oldest") { out = OverflowPolicy::DropOldest; return true; }
+    if (str == "drop_newest") { out = OverflowPolicy::DropNewest; return true; }
+    return false;
+}
+
+inline std::string_view overflow_policy_name(OverflowPolicy policy) {
+    return policy == OverflowPolicy::DropNewest ? "drop_newest" : "drop_oldest";
+}
+
+// what take_front_if() does with the element it visits
+enum class RingVisit : int { Take, Skip, Stop };
+
+// Fixed-capacity FIFO. Storage is allocated once in the constructor; push/pop never allocate.
+// Single-threaded: callers own synchronization.
+template <typename T>
+class RingBuffer {
+    public:
+        explicit RingBuffer(std::size_t capacity, OverflowPolicy policy = OverflowPolicy::DropOldest)
+            : slots_(capacity), policy_(policy) {}
+
+        // returns false if the element was not stored (DropNewest on a full buffer, or zero capacity);
+        // with DropOldest a full buffer overwrites its oldest element, which counts as one drop
+        bool push(const T& value) {
+            if (slots_.empty()) { ++dropped_; return false; }
+
+            if (size_ == slots_.size()) {
+                ++dropped_;
+                if (policy_ == OverflowPolicy::DropNewest) return false;
+                head_ = next_(head_);
+                --size_;
+            }
+            slots_[(head_ + size_) % slots_.size()] = value;
+            ++size_;
+            return true;
+        }
+
+        // oldest element; only valid when !empty()
+        const T& front() const { return slots_[head_]; }
+
+        // i-th oldest element; only valid when i < size()
+        const T& at(std::size_t i) const { return slots_[(head_ + i) % slots_.size()]; }
+
+        void pop() {
+            if (size_ == 0) return;
+            head_ = next_(head_);
+            --size_;
+        }
+
+        void pop(std::size_t count) {
+            if (count > size_) count = size_;
+            if (count == 0) return;
+            head_ = (head_ + count) % slots_.size();
+            size_ -= count;
+        }
+
+        // Visits the elements oldest first until `visit` returns Stop, removing the ones it Takes.
+        // Skipped elements stay ahead of the unvisited ones, in their order. Returns the number
+        // removed; never allocates.
+        template <typename Visit>
+        std::size_t take_front_if(Visit&& visit) {
+            std::size_t visited = 0;
+            std::size_t kept = 0;
+            for (; visited < size_; ++visited) {
+                const RingVisit what = visit(at(visited));
+                if (what == RingVisit::Stop) break;
+                if (what == RingVisit::Skip) {
+                    if (kept != visited) slot_(kept) = slot_(visited);
+                    ++kept;
+                }
+            }
+            const std::size_t taken = visited - kept;
+            if (taken == 0) return 0;
+            for (std::size_t i = kept; i-- > 0;) slot_(taken + i) = slot_(i);
+            pop(taken);
+            return taken;
+        }
+
+        void clear() noexcept { head_ = 0; size_ = 0; }
+
+        bool empty() const noexcept { return size_ == 0; }
+        bool full() const noexcept { return size_ == slots_.size(); }
+        std::size_t size() const noexcept { return size_; }
+        std::size_t capacity() const noexcept { return slots_.size(); }
+        std::uint64_t dropped() const noexcept { return dropped_; }
+        OverflowPolicy policy() const noexcept { return policy_; }
+
+    private:
+        std::size_t next_(std::size_t idx) const noexcept { return (idx + 1) % slots_.size(); }
+        T& slot_(std::size_t i) { return slots_[(head_ + i) % slots_.size()]; }
+
+        std::vector<T> slots_;
+        OverflowPolicy policy_;
+        std::size_t head_ = 0;
+        std::size_t size_ = 0;
+        std::uint64_t dropped_ = 0;
+};
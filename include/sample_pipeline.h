@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include "telemetry_publisher.h"
+#include "window_aggregator.h"
+
+// Record passed from the sampling thread to the publishing thread through SpscQueue.
+struct SampleEvent {
+    enum class Kind : std::uint8_t {
+        Reading, // `reading` is a fresh sample
+        EndTick, // all readings of one scheduler tick have been pushed
+        Summary, // an aggregation window closed; `summary` describes it, reading.value is its mean
+        Health   // heartbeat due at sequence reading.seq; the sampler's counters are in the CounterRegistry
+    };
+
+    Kind kind = Kind::Reading;
+    PendingReading reading;
+    WindowSummary summary;
+};
+
+static_assert(std::is_trivially_copyable_v<SampleEvent>);
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Min-heap of absolute deadlines. A job's next deadline is always its previous
+// deadline + period, so time spent sampling/publishing never accumulates as drift.
+class DeadlineScheduler {
+    public:
+        using Clock     = std::chrono::steady_clock;
+        using TimePoint = Clock::time_point;
+        using Duration  = Clock::duration;
+
+        // returns the job id (ids are assigned sequentially from 0)
+        std::size_t add(Duration period, TimePoint first_deadline) {
+            const std::size_t id = next_id_++;
+            heap_.push_back(Job{first_deadline, period, id});
+            std::push_heap(heap_.begin(), heap_.end(), later_);
+            return id;
+        }
+
+        bool empty() const noexcept { return heap_.empty(); }
+        std::size_t size() const noexcept { return heap_.size(); }
+
+        TimePoint next_deadline() const noexcept {
+            return heap_.empty() ? TimePoint::max() : heap_.front().deadline;
+        }
+
+        // Appends the ids of all jobs due at `now` (ascending id order) and re-arms them.
+        // A job that is so late its following deadline has also passed counts the missed
+        // ticks as overruns and skips ahead instead of firing a catch-up burst.
+        void collect_due(TimePoint now, std::vector<std::size_t>& due) {
+            const std::size_t first = due.size();
+
+            while (!heap_.empty() && heap_.front().deadline <= now) {
+                std::pop_heap(heap_.begin(), heap_.end(), later_);
+                Job& job = heap_.back();
+                due.push_back(job.id);
+
+                const auto missed = static_cast<std::uint64_t>((now - job.deadline) / job.period);
+                overruns_ += missed;
+                job.deadline += job.period * static_cast<Duration::rep>(missed + 1);
+
+                std::push_heap(heap_.begin(), heap_.end(), later_);
+            }
+            std::sort(due.begin() + static_cast<std::ptrdiff_t>(first), due.end());
+        }
+
+        std::uint64_t overruns() const noexcept { return overruns_; }
+
+    private:
+        struct Job {
+            TimePoint deadline;
+            Duration period;
+            std::size_t id;
+        };
+
+        static bool later_(const Job& lhs, const Job& rhs) noexcept { return lhs.deadline > rhs.deadline; }
+
+        std::vector<Job> heap_;
+        std::size_t next_id_ = 0;
+        std::uint64_t overruns_ = 0;
+};
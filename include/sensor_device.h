@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "sensor.h"
+
+enum class SampleStatus : std::uint8_t {
+    Ok,
+    NoData // nothing to report this time (read failed, or a rate with no elapsed time)
+};
+
+// One reading, filled in place by ISensorDevice::sample().
+struct SampleRecord {
+    std::uint32_t metric = 0;      // the device's id for the metric (SensorSet::channel_of); set by the caller
+    SampleStatus status = SampleStatus::NoData;
+    double value = 0.0;
+    std::int64_t timestamp_ns = 0; // steady clock, when the device was read
+};
+
+static_assert(std::is_trivially_copyable_v<SampleRecord>);
+
+// A device serves one or more metrics, registered once while building it. Each tick the
+// caller hands it the due metrics as a span of records and it fills them in one call, so
+// sampling costs one virtual dispatch per device rather than per reading.
+class ISensorDevice {
+    public:
+        virtual ~ISensorDevice() = default;
+
+        virtual bool init() = 0;
+        virtual void sample(std::span<SampleRecord> records) = 0;
+        virtual std::string_view name() const = 0;
+        // Closes the sensors of every metric id not listed (a reload removed those metrics);
+        // the listed ones keep their ids and state.
+        virtual void retain(std::span<const std::uint32_t> metrics) = 0;
+};
+
+namespace sensor_detail {
+
+    // built-in sensors read a bare value; legacy ISensor implementations go through Reading
+    template <typename S>
+    std::optional<double> read_value(S& sensor) { return sensor.read(); }
+
+    inline std::optional<double> read_value(ISensor& sensor) {
+        const auto reading = sensor.sample();
+        if (!reading) return std::nullopt;
+        return reading->value;
+    }
+
+} // namespace sensor_detail
+
+// Device over a set of sensors of one type. For the built-in sensor classes (final, with a
+// non-virtual read()) no call inside the loop is virtual and nothing is allocated.
+template <typename S>
+class SensorGroup final : public ISensorDevice {
+    public:
+        explicit SensorGroup(std::string name) : name_(std::move(name)) {}
+
+        void add(std::uint32_t metric, std::unique_ptr<S> sensor) {
+            if (channel_of_.size() <= metric) channel_of_.resize(metric + 1, 0);
+            channel_of_[metric] = static_cast<std::uint32_t>(sensors_.size());
+            sensors_.push_back(std::move(sensor));
+            metric_of_.push_back(metric);
+        }
+
+        bool init() override {
+            for (auto& sensor : sensors_) {
+                if (!sensor->init()) return false;
+            }
+            return true;
+        }
+
+        void sample(std::span<SampleRecord> records) override {
+            const std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            for (auto& record : records) {
+                const auto value = sensor_detail::read_value(*sensors_[channel_of_[record.metric]]);
+                record.timestamp_ns = now;
+                record.status = value ? SampleStatus::Ok : SampleStatus::NoData;
+                record.value = value.value_or(0.0);
+            }
+        }
+
+        std::string_view name() const override { return name_; }
+        std::size_t size() const noexcept { return sensors_.size(); }
+
+        void retain(std::span<const std::uint32_t> metrics) override {
+            std::size_t kept = 0;
+            for (std::size_t i = 0; i < sensors_.size(); ++i) {
+                if (std::find(metrics.begin(), metrics.end(), metric_of_[i]) == metrics.end()) continue;
+                sensors_[kept] = std::move(sensors_[i]);
+                metric_of_[kept] = metric_of_[i];
+                channel_of_[metric_of_[kept]] = static_cast<std::uint32_t>(kept);
+                ++kept;
+            }
+            sensors_.resize(kept);
+            metric_of_.resize(kept);
+        }
+
+    private:
+        std::string name_;
+        std::vector<std::unique_ptr<S>> sensors_;
+        std::vector<std::uint32_t> metric_of_;  // index into sensors_ -> metric id
+        std::vector<std::uint32_t> channel_of_; // metric id -> index into sensors_
+};
+
+// Keeps sensors written against the per-reading ISensor interface working.
+using SensorAdapter = SensorGroup<ISensor>;
+
+// all configured metrics, grouped into devices
+struct SensorSet {
+    std::vector<std::unique_ptr<ISensorDevice>> devices;
+    std::vector<std::uint32_t> device_of;  // metric id -> index into devices
+    std::vector<std::uint32_t> channel_of; // metric id -> id the device registered it under (SampleRecord::metric)
+};
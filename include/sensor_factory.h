@@ -1,8 +1,23 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <vector>
+
+#include "sensor_device.h"
 
 struct MetricConfig;
 class ISensor;
 
-std::unique_ptr<ISensor> make_sensor(const MetricConfig& metric);
\ No newline at end of file
+// single sensor behind the per-reading ISensor interface
+std::unique_ptr<ISensor> make_sensor(const MetricConfig& metric);
+
+// every metric, grouped into one device per sensor type (metric ids are indices into `metrics`)
+SensorSet make_sensor_devices(const std::vector<MetricConfig>& metrics);
+
+// Sensors for a reloaded metric list. Metric i with kept_from[i] >= 0 keeps the running sensor of
+// metric kept_from[i], state included; the others get new, initialized devices. Running devices no
+// kept metric uses are dropped, and kept ones close the sensors of removed metrics.
+// Throws std::runtime_error if a new device fails to init, leaving `running` untouched.
+SensorSet rebuild_sensor_devices(SensorSet& running, const std::vector<MetricConfig>& metrics,
+                                 const std::vector<std::int32_t>& kept_from);
@@ -10,6 +10,7 @@ class SimulatedSensor final : public ISensor {
 
         bool init() override;
         std::optional<Reading> sample() override;
+        std::optional<double> read() noexcept; // sample() without building a Reading
         std::string_view name() const override;
 
     private:
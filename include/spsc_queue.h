@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// Bounded lock-free single-producer/single-consumer queue of trivially copyable records.
+// One thread may push and one (other) thread may pop; neither side ever blocks or allocates.
+// Head and tail live on separate cache lines, and each side caches the other's index so
+// the shared line is only touched when the cached view says the queue is full/empty.
+template <typename T>
+class SpscQueue {
+    static_assert(std::is_trivially_copyable_v<T>, "SpscQueue holds fixed-size POD records");
+
+    public:
+        // capacity is rounded up to a power of two
+        explicit SpscQueue(std::size_t capacity)
+            : mask_(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity) - 1),
+              slots_(std::make_unique<T[]>(mask_ + 1)) {}
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator = (const SpscQueue&) = delete;
+
+        // producer side; false when full (the record is not stored)
+        bool try_push(const T& value) noexcept {
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if (tail - head_cache_ > mask_) {
+                head_cache_ = head_.load(std::memory_order_acquire);
+                if (tail - head_cache_ > mask_) return false;
+            }
+            slots_[tail & mask_] = value;
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer side; copies up to max records into out, returns how many
+        std::size_t pop_bulk(T* out, std::size_t max) noexcept {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            if (tail_cache_ == head) {
+                tail_cache_ = tail_.load(std::memory_order_acquire);
+                if (tail_cache_ == head) return 0;
+            }
+            std::size_t count = tail_cache_ - head;
+            if (count > max) count = max;
+            for (std::size_t i = 0; i < count; ++i) out[i] = slots_[(head + i) & mask_];
+            head_.store(head + count, std::memory_order_release);
+            return count;
+        }
+
+        bool try_pop(T& out) noexcept { return pop_bulk(&out, 1) == 1; }
+
+        // exact only when called from one of the two sides while the other is idle
+        std::size_t size_approx() const noexcept {
+            return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+        }
+        std::size_t capacity() const noexcept { return mask_ + 1; }
+
+    private:
+        static constexpr std::size_t k_cache_line = 64;
+
+        const std::size_t mask_;
+        const std::unique_ptr<T[]> slots_;
+
+        alignas(k_cache_line) std::atomic<std::size_t> head_{0}; // written by the consumer
+        std::size_t tail_cache_ = 0;                             // consumer's view of tail_
+
+        alignas(k_cache_line) std::atomic<std::size_t> tail_{0}; // written by the producer
+        std::size_t head_cache_ = 0;                             // producer's view of head_
+};
@@ -6,11 +6,16 @@
 
 #include "time_utils.h"
 
-inline nlohmann::json make_status_payload_v1(std::string_view client_id, std::string_view state) {
-    return {
+// telemetry_content_type is only included when the device publishes a non-JSON payload_format
+inline nlohmann::json make_status_payload_v1(std::string_view client_id,
+                                             std::string_view state,
+                                             std::string_view telemetry_content_type = {}) {
+    nlohmann::json payload = {
         {"schema_version", 1},
         {"device", {{"client_id", client_id}}},
         {"state", state},
         {"timestamp_s", unix_time_s()}
     };
+    if (!telemetry_content_type.empty()) payload["telemetry_content_type"] = telemetry_content_type;
+    return payload;
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "proc_file.h"
+#include "sensor.h"
+
+// Built-in Linux system metrics. Each sensor opens its file once in init() and re-reads it
+// with pread() per sample, parsing in place; counters are turned into rates from deltas.
+// init() also takes the first counter snapshot, so the first sample already has a rate.
+// read() is the allocation-free path used by SensorGroup; sample() wraps it in a Reading.
+
+// CPU utilization in percent since the previous sample, from a /proc/stat "cpu" or "cpuN" line
+class CpuUsageSensor final : public ISensor {
+    public:
+        CpuUsageSensor(std::string metric, std::string unit, std::string cpu = "cpu", std::string path = "/proc/stat");
+
+        bool init() override;
+        std::optional<Reading> sample() override;
+        std::string_view name() const override { return metric_; }
+        std::optional<double> read();
+
+    private:
+        bool read_(std::uint64_t& busy, std::uint64_t& total);
+
+        std::string metric_;
+        std::string unit_;
+        std::string cpu_;
+        std::string path_;
+        ProcFile file_{32 * 1024}; // per-CPU lines follow the aggregate one
+        std::uint64_t prev_busy_ = 0;
+        std::uint64_t prev_total_ = 0;
+};
+
+// one /proc/meminfo entry (kB), times `scale`
+class MemInfoSensor final : public ISensor {
+    public:
+        MemInfoSensor(std::string metric, std::string unit, std::string key = "MemAvailable", double scale = 1.0,
+                      std::string path = "/proc/meminfo");
+
+        bool init() override;
+        std::optional<Reading> sample() override;
+        std::string_view name() const override { return metric_; }
+        std::optional<double> read();
+
+    private:
+        std::string metric_;
+        std::string unit_;
+        std::string key_;
+        double scale_;
+        std::string path_;
+        ProcFile file_{8 * 1024};
+};
+
+// per-second rate of one /proc/net/dev counter, e.g. eth0 rx_bytes
+class NetDevSensor final : public ISensor {
+    public:
+        // field: rx_bytes, rx_packets, rx_errs, rx_drop, tx_bytes, tx_packets, tx_errs or tx_drop
+        NetDevSensor(std::string metric, std::string unit, std::string iface, std::string field = "rx_bytes",
+                     std::string path = "/proc/net/dev");
+
+        bool init() override;
+        std::optional<Reading> sample() override;
+        std::string_view name() const override { return metric_; }
+        std::optional<double> read();
+
+        // column of `field` after "<iface>:", or -1 if unknown
+        static int field_index(std::string_view field) noexcept;
+
+    private:
+        std::optional<std::uint64_t> read_();
+
+        std::string metric_;
+        std::string unit_;
+        std::string iface_;
+        int index_;
+        std::string path_;
+        ProcFile file_{16 * 1024};
+        CounterRate rate_;
+};
+
+// a sysfs attribute holding one integer (thermal zone temp, hwmon *_input), times `scale`
+class SysfsValueSensor final : public ISensor {
+    public:
+        SysfsValueSensor(std::string metric, std::string unit, std::string path, double scale);
+
+        bool init() override;
+        std::optional<Reading> sample() override;
+        std::string_view name() const override { return metric_; }
+        std::optional<double> read();
+
+    private:
+        std::string metric_;
+        std::string unit_;
+        std::string path_;
+        double scale_;
+        ProcFile file_{64};
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <string>
+
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Non-blocking TCP connect, polled until it completes or its deadline passes. Tells whether a
+// broker accepts connections again without touching the live MQTT session (failback). Name
+// resolution in start() may block like mosquitto_connect_async does; nothing else does.
+class TcpProbe {
+    public:
+        using Clock     = std::chrono::steady_clock;
+        using TimePoint = Clock::time_point;
+
+        enum class Result : int { Pending, Open, Failed };
+
+        TcpProbe() = default;
+        ~TcpProbe() { close_(); }
+
+        TcpProbe(const TcpProbe&) = delete;
+        TcpProbe& operator = (const TcpProbe&) = delete;
+
+        bool active() const noexcept { return active_; }
+        void cancel() noexcept { close_(); }
+
+        // starts connecting to host:port, replacing a probe still running
+        void start(const std::string& host, int port, TimePoint deadline) {
+            close_();
+            active_ = true;
+            deadline_ = deadline;
+
+            addrinfo hints{};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            hints.ai_flags = AI_NUMERICSERV;
+            addrinfo* found = nullptr;
+            if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &found) != 0) return;
+            for (const addrinfo* ai = found; ai && fd_ < 0; ai = ai->ai_next) {
+                fd_ = ::socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+                if (fd_ >= 0 && ::connect(fd_, ai->ai_addr, ai->ai_addrlen) != 0 && errno != EINPROGRESS) close_fd_();
+            }
+            ::freeaddrinfo(found);
+        }
+
+        // never blocks; the probe ends (active() == false) once it returns Open or Failed
+        Result poll(TimePoint now) {
+            if (!active_ || fd_ < 0) {
+                close_();
+                return Result::Failed;
+            }
+            pollfd pfd{fd_, POLLOUT, 0};
+            if (::poll(&pfd, 1, 0) > 0) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                const bool open = ::getsockopt(fd_, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0;
+                close_();
+                return open ? Result::Open : Result::Failed;
+            }
+            if (now >= deadline_) {
+                close_();
+                return Result::Failed;
+            }
+            return Result::Pending;
+        }
+
+    private:
+        void close_fd_() noexcept {
+            if (fd_ >= 0) ::close(fd_);
+            fd_ = -1;
+        }
+
+        void close_() noexcept {
+            close_fd_();
+            active_ = false;
+        }
+
+        int fd_ = -1;
+        bool active_ = false;
+        TimePoint deadline_{};
+};
@@ -7,19 +7,89 @@
 #include <cstdint>
 
 #include "time_utils.h"
+#include "window_aggregator.h"
 
 inline nlohmann::json make_payload_v1(
     std::string_view client_id,
     std::string_view metric_name,
     std::string_view unit,
     double value,
-    std::uint64_t seq
+    std::uint64_t seq,
+    std::int64_t timestamp_s
 ) {
     return {
         {"schema_version", 1},
         {"device", {{"client_id", client_id}}},
         {"metric", {{"name", metric_name}, {"unit", unit}, {"value", value}}},
-        {"timestamp_s", unix_time_s()},
+        {"timestamp_s", timestamp_s},
         {"seq", seq}
     };
-}
\ No newline at end of file
+}
+
+inline nlohmann::json make_payload_v1(
+    std::string_view client_id,
+    std::string_view metric_name,
+    std::string_view unit,
+    double value,
+    std::uint64_t seq
+) {
+    return make_payload_v1(client_id, metric_name, unit, value, seq, unix_time_s());
+}
+
+// Schema 2: schema 1 plus "timestamp_ms", the acquisition time in Unix milliseconds.
+// timestamp_s stays, so consumers of schema 1 fields keep working.
+inline nlohmann::json make_payload_v2(
+    std::string_view client_id,
+    std::string_view metric_name,
+    std::string_view unit,
+    double value,
+    std::uint64_t seq,
+    std::int64_t timestamp_ms
+) {
+    auto payload = make_payload_v1(client_id, metric_name, unit, value, seq, timestamp_ms / 1000);
+    payload["schema_version"] = 2;
+    payload["timestamp_ms"] = timestamp_ms;
+    return payload;
+}
+
+// One window of an aggregated metric. metric.value carries the mean so consumers of plain
+// readings keep working; the statistics are under "window".
+inline nlohmann::json make_summary_payload_v1(
+    std::string_view client_id,
+    std::string_view metric_name,
+    std::string_view unit,
+    const WindowSummary& summary,
+    std::uint64_t seq,
+    std::int64_t timestamp_s
+) {
+    auto payload = make_payload_v1(client_id, metric_name, unit, summary.mean, seq, timestamp_s);
+    nlohmann::json window = {
+        {"count", summary.count},
+        {"min", summary.min},
+        {"max", summary.max},
+        {"mean", summary.mean},
+        {"stddev", summary.stddev},
+        {"window_ms", summary.window_ms}
+    };
+    if (summary.has_percentiles) {
+        window["p50"] = summary.p50;
+        window["p90"] = summary.p90;
+        window["p99"] = summary.p99;
+    }
+    payload["window"] = std::move(window);
+    return payload;
+}
+
+inline nlohmann::json make_summary_payload_v2(
+    std::string_view client_id,
+    std::string_view metric_name,
+    std::string_view unit,
+    const WindowSummary& summary,
+    std::uint64_t seq,
+    std::int64_t timestamp_ms
+) {
+    auto payload = make_summary_payload_v1(client_id, metric_name, unit, summary, seq, timestamp_ms / 1000);
+    payload["schema_version"] = 2;
+    payload["timestamp_ms"] = timestamp_ms;
+    return payload;
+}
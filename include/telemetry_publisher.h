@@ -0,0 +1,166 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "app_config.h"
+#include "batch_payload.h"
+#include "counter_registry.h"
+#include "disk_spool.h"
+#include "health_payload.h"
+#include "latency_histogram.h"
+#include "metrics_snapshot.h"
+#include "payload_compressor.h"
+#include "payload_writer.h"
+#include "process_stats.h"
+#include "ring_buffer.h"
+#include "window_aggregator.h"
+
+class MqttClient;
+
+// a sampled reading that has not been delivered yet
+struct PendingReading {
+    std::uint32_t metric = 0; // index into AppConfig::metrics
+    double value = 0.0;
+    std::uint64_t seq = 0;
+    std::int64_t timestamp_ms = 0; // Unix time the sensor was read (window end for summaries)
+
+    std::int64_t timestamp_s() const noexcept { return timestamp_ms / 1000; }
+};
+
+// Serializes (and optionally compresses) readings and hands them to MqttClient on the
+// per-metric topics and/or devices/<client_id>/batch. Readings the broker could not take go to a bounded
+// store-and-forward buffer (in memory, or the on-disk spool when spool.enabled) and
+// are replayed, rate limited, once connected again.
+class TelemetryPublisher {
+    public:
+        using Clock     = std::chrono::steady_clock;
+        using TimePoint = Clock::time_point;
+
+        TelemetryPublisher(MqttClient& mqtt, const AppConfig& cfg);
+
+        TelemetryPublisher(const TelemetryPublisher&) = delete;
+        TelemetryPublisher& operator = (const TelemetryPublisher&) = delete;
+
+        void publish_reading(const PendingReading& reading);
+
+        // aggregated metrics: one message per window on the metric's topic, never batched.
+        // Without the spool, a summary that cannot be sent is dropped (counted in `dropped`).
+        void publish_summary(const PendingReading& reading, const WindowSummary& summary);
+
+        // counts one scheduler tick toward batch.max_ticks
+        void end_tick();
+
+        // replays buffered readings at store_forward.replay_per_s while connected;
+        // also drives the spool's periodic flush
+        void service(TimePoint now);
+        // true while readings wait for replay (service() has work once connected)
+        bool backlogged() const { return has_backlog_(); }
+
+        // publishes a partially filled batch and syncs the spool (shutdown, reload)
+        void flush();
+
+        // Applies a reloaded config: the AppConfig passed to the constructor now holds the new
+        // values and `previous` the old ones. Call flush() first. Buffered readings are remapped
+        // to the new metric ids by name. Throws std::runtime_error (compression dictionary).
+        void reconfigure(const AppConfig& previous);
+        // switches to a new connection (reload with changed broker settings)
+        void set_client(MqttClient& mqtt) noexcept { mqtt_ = &mqtt; }
+        // broker.connections > 1: telemetry topics hash over the client and these extra sessions;
+        // health stays on the client, and the counters and latencies cover all of them
+        void set_shards(std::vector<MqttClient*> shards) {
+            shards_ = std::move(shards);
+            outages_.assign(shards_.empty() ? 0 : shards_.size() + 1, Outage{});
+        }
+
+        // health includes the pipeline counters of `registry` (resetting its high-water gauges),
+        // per-stage latency percentiles since the previous health message and process resource use
+        void publish_health(std::uint64_t uptime_s, std::uint64_t seq, CounterRegistry& registry);
+
+        // ISensorDevice::sample() durations; recorded by the sampling thread
+        LatencyHistogram& sample_latency() noexcept { return sample_latency_; }
+
+        HealthCounters counters() const;
+        // copies counters, connection state and latency histograms out for other threads
+        void snapshot(MetricsSnapshot& out) const;
+
+    private:
+        struct MetricEntry {
+            std::string topic;
+            TelemetryPayloadWriter writer;
+        };
+
+        struct Outage {
+            TimePoint since{}; // zero while connected
+            bool reported = false;
+        };
+
+        struct Batch {
+            Batch(const AppConfig& cfg, std::size_t max_readings);
+
+            BatchPayloadWriter writer;
+            std::vector<PendingReading> readings;
+            int ticks = 0;
+        };
+
+        void build_metrics_();
+        static std::unique_ptr<PayloadCompressor> make_compressor_(const AppConfig& cfg);
+        MqttClient& client_for_(std::string_view topic) const;
+        bool any_connected_() const;
+        void watch_sessions_(TimePoint now);
+        LatencyHistogram::Counts merged_latency_(const LatencyHistogram& (MqttClient::*histogram)() const noexcept) const;
+        bool publish_(std::string_view topic, std::string_view payload, int qos, bool retain);
+        std::string_view compress_(std::string_view payload);
+        std::string_view render_single_(const PendingReading& reading);
+        std::string_view render_batch_(Batch& batch);
+        bool publish_single_(const PendingReading& reading);
+        bool publish_batch_(Batch& batch);
+        void flush_batch_(Batch& batch);
+        void add_to_batch_(const PendingReading& reading);
+        bool batch_has_room_(const Batch& batch, std::uint32_t metric) const;
+        void buffer_(const PendingReading& reading);
+        void spool_message_(std::string_view topic, std::string_view payload, std::int64_t timestamp_s);
+        bool has_backlog_() const;
+        void replay_(std::size_t budget);
+        void replay_spool_(std::size_t budget);
+
+        MqttClient* mqtt_;
+        std::vector<MqttClient*> shards_;
+        // sharded only, per session (the client, then the shards): a long outage is logged once,
+        // since the readings of its topics wait for it
+        std::vector<Outage> outages_;
+        const AppConfig& cfg_;
+
+        std::vector<MetricEntry> metrics_;
+        std::string batch_topic_;
+        std::unique_ptr<Batch> batch_;        // live readings (batch mode only)
+        std::unique_ptr<Batch> replay_batch_; // replayed readings (batch mode only)
+
+        std::string health_topic_;
+        HealthPayloadWriter health_writer_;
+        ProcessStatsReader process_stats_;
+
+        std::string encoded_; // scratch for CBOR/MessagePack payloads
+        std::unique_ptr<PayloadCompressor> compressor_; // compression.enabled only
+
+        LatencyHistogram sample_latency_;
+        LatencyHistogram serialize_latency_;
+        LatencyWindow sample_window_;
+        LatencyWindow serialize_window_;
+        LatencyWindow publish_window_;
+        LatencyWindow ack_window_;
+
+        RingBuffer<PendingReading> pending_;
+        std::unique_ptr<DiskSpool> spool_; // replaces pending_ when spool.enabled
+        double replay_tokens_ = 0.0;
+        std::vector<std::uint8_t> replay_ready_; // per metric: its session is connected (replay_ scratch)
+        TimePoint replay_last_ = Clock::now();
+
+        std::uint64_t backpressure_ = 0;
+        std::uint64_t replayed_ = 0;
+        std::uint64_t summaries_dropped_ = 0; // not sent and no spool to keep them
+};
@@ -7,4 +7,33 @@ inline std::int64_t unix_time_s() {
     return std::chrono::duration_cast<std::chrono::seconds>(
         std::chrono::system_clock::now().time_since_epoch()
     ).count();
-}
\ No newline at end of file
+}
+
+// Maps steady_clock readings to Unix time. refresh() reads both clocks once (the sampler does
+// so every tick); readings stamped from steady_clock are then converted with an addition
+// instead of a system_clock read per message. A step of the wall clock (NTP) shows up at the
+// next refresh.
+class WallClock {
+    public:
+        WallClock() noexcept { refresh(); }
+
+        void refresh() noexcept {
+            const auto steady = std::chrono::steady_clock::now();
+            const auto system = std::chrono::system_clock::now();
+            offset_ns_ = std::chrono::duration_cast<std::chrono::nanoseconds>(system.time_since_epoch()).count() -
+                         std::chrono::duration_cast<std::chrono::nanoseconds>(steady.time_since_epoch()).count();
+        }
+
+        // steady_ns: nanoseconds since the steady_clock epoch
+        std::int64_t unix_ms(std::int64_t steady_ns) const noexcept {
+            const std::int64_t ns = steady_ns + offset_ns_;
+            return ns / 1'000'000 - (ns % 1'000'000 < 0 ? 1 : 0);
+        }
+
+        std::int64_t unix_ms(std::chrono::steady_clock::time_point at) const noexcept {
+            return unix_ms(std::chrono::duration_cast<std::chrono::nanoseconds>(at.time_since_epoch()).count());
+        }
+
+    private:
+        std::int64_t offset_ns_ = 0;
+};
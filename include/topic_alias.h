@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// MQTT 5 client->broker topic aliases for one connection. Aliases are handed out 1..max in
+// first-use order; once the broker's Topic Alias Maximum is used up, further topics go out
+// in full. The table must be reset whenever a new connection is established.
+class TopicAliasTable {
+    public:
+        void reset(std::uint16_t max) {
+            aliases_.clear();
+            max_ = max;
+        }
+
+        // alias already known to the broker, 0 if none
+        std::uint16_t find(std::string_view topic) const {
+            const auto it = aliases_.find(topic);
+            return it == aliases_.end() ? 0 : it->second;
+        }
+
+        // alias to establish next, 0 when the table is full
+        std::uint16_t next() const noexcept {
+            return aliases_.size() < max_ ? static_cast<std::uint16_t>(aliases_.size() + 1) : 0;
+        }
+
+        // record an alias once the message that established it was accepted
+        void add(std::string_view topic, std::uint16_t alias) { aliases_.emplace(std::string(topic), alias); }
+
+        std::size_t size() const noexcept { return aliases_.size(); }
+        std::uint16_t max() const noexcept { return max_; }
+
+    private:
+        struct Hash {
+            using is_transparent = void;
+            std::size_t operator()(std::string_view str) const noexcept { return std::hash<std::string_view>{}(str); }
+        };
+
+        std::unordered_map<std::string, std::uint16_t, Hash, std::equal_to<>> aliases_;
+        std::uint16_t max_ = 0;
+};
+
+// bytes needed for an MQTT variable byte integer
+inline std::size_t mqtt5_varint_size(std::size_t value) {
+    std::size_t size = 1;
+    while (value >= 128) { value /= 128; ++size; }
+    return size;
+}
+
+// Encoded size of an MQTT 5 PUBLISH packet (fixed header included), used to report the
+// bytes topic aliases save. props_len is the length of the encoded property block.
+inline std::size_t mqtt5_publish_size(std::size_t topic_len, std::size_t payload_len, int qos, std::size_t props_len) {
+    const std::size_t remaining = 2 + topic_len + (qos > 0 ? 2 : 0) + mqtt5_varint_size(props_len) + props_len + payload_len;
+    return 1 + mqtt5_varint_size(remaining) + remaining;
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <string_view>
 
@@ -27,4 +29,32 @@ inline std::string make_status_topic(std::string_view client_id) {
 [[nodiscard]]
 inline std::string make_health_topic(std::string_view client_id) {
     return make_topic(client_id, "health");
-}
\ No newline at end of file
+}
+
+[[nodiscard]]
+inline std::string make_batch_topic(std::string_view client_id) {
+    return make_topic(client_id, "batch");
+}
+
+// client id of extra session `index` (1 and up) of a device sharded over broker.connections;
+// session 0 is the device's own id and carries its status/LWT
+[[nodiscard]]
+inline std::string make_shard_client_id(std::string_view client_id, std::size_t index) {
+    std::string str(client_id);
+    str.append("-s");
+    str.append(std::to_string(index));
+    return str;
+}
+
+// which of `shards` sessions publishes `topic` (FNV-1a); a topic always maps to the same one,
+// which keeps per-topic ordering
+[[nodiscard]]
+inline std::size_t topic_shard(std::string_view topic, std::size_t shards) noexcept {
+    if (shards <= 1) return 0;
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const char c : topic) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return static_cast<std::size_t>(hash % shards);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <semaphore>
+
+// Lets producer threads wake a consumer without a lock on the hot path: only the first
+// notify() after the consumer re-arms actually touches the semaphore.
+class Wakeup {
+    public:
+        void notify() {
+            if (!pending_.exchange(true, std::memory_order_acq_rel)) sem_.release();
+        }
+
+        // returns true if woken, false on timeout; re-arm happens before the caller drains
+        template <typename Rep, typename Period>
+        bool wait_for(std::chrono::duration<Rep, Period> timeout) {
+            const bool woken = sem_.try_acquire_for(timeout);
+            if (woken) pending_.store(false, std::memory_order_release);
+            return woken;
+        }
+
+    private:
+        std::binary_semaphore sem_{0};
+        std::atomic<bool> pending_{false};
+};
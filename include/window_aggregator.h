@@ -0,0 +1,217 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+// statistics of one metric over one window
+struct WindowSummary {
+    std::uint64_t count = 0;
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+    double stddev = 0.0; // population
+    bool has_percentiles = false;
+    double p50 = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+    std::uint32_t window_ms = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<WindowSummary>);
+
+// Windowed statistics for the metrics that aggregate instead of publishing every sample.
+//
+// A window is split into panes of slide_ms (one pane for a tumbling window); the caller
+// closes a pane every slide_ms and gets the summary over the last window_ms back. Each
+// accumulator field is its own array indexed by slot (struct of arrays): the hot add() path
+// only touches the current-pane arrays, and merging a metric's panes walks contiguous memory.
+// Sums are taken relative to the metric's first value to limit cancellation in the variance.
+//
+// Percentiles are computed from a copy of the window's samples, decimated to at most
+// max_samples per window (every k-th sample), so they are approximate at high rates.
+// Single-threaded: owned by the sampler thread.
+class WindowAggregator {
+    public:
+        struct Spec {
+            std::uint32_t window_ms = 0;
+            std::uint32_t slide_ms = 0;             // == window_ms for a tumbling window
+            std::uint32_t interval_ms = 0;          // sample period, sizes the percentile buffer
+            bool percentiles = false;
+            std::uint32_t max_samples = 1024;
+        };
+
+        // returns the slot used by add()/close_pane()
+        std::size_t add_metric(const Spec& spec) {
+            const std::size_t slot = window_ms_.size();
+            const std::uint32_t panes = std::max<std::uint32_t>(1, spec.window_ms / std::max<std::uint32_t>(1, spec.slide_ms));
+
+            window_ms_.push_back(spec.window_ms);
+            count_.push_back(0);
+            sum_.push_back(0.0);
+            sum_sq_.push_back(0.0);
+            min_.push_back(k_inf);
+            max_.push_back(-k_inf);
+            offset_.push_back(std::numeric_limits<double>::quiet_NaN());
+
+            pane_base_.push_back(pane_count_.size());
+            panes_.push_back(panes);
+            pane_head_.push_back(0);
+            pane_count_.resize(pane_count_.size() + panes, 0);
+            pane_sum_.resize(pane_sum_.size() + panes, 0.0);
+            pane_sum_sq_.resize(pane_sum_sq_.size() + panes, 0.0);
+            pane_min_.resize(pane_min_.size() + panes, k_inf);
+            pane_max_.resize(pane_max_.size() + panes, -k_inf);
+
+            Samples samples;
+            if (spec.percentiles) {
+                const std::uint64_t per_window = spec.window_ms / std::max<std::uint32_t>(1, spec.interval_ms) + 1;
+                const std::uint64_t cap = std::max<std::uint32_t>(1, spec.max_samples);
+                samples.stride = static_cast<std::uint32_t>((per_window + cap - 1) / cap);
+                // a pane may see one extra sample at its edges
+                const std::uint64_t per_pane = spec.slide_ms / std::max<std::uint32_t>(1, spec.interval_ms) + 2;
+                samples.ring.resize(static_cast<std::size_t>(panes * ((per_pane + samples.stride - 1) / samples.stride)));
+                samples.pane_kept.resize(panes, 0);
+                samples.scratch.reserve(samples.ring.size());
+            }
+            samples_.push_back(std::move(samples));
+            return slot;
+        }
+
+        std::size_t size() const noexcept { return window_ms_.size(); }
+
+        // non-finite values are ignored
+        void add(std::size_t slot, double value) noexcept {
+            if (!std::isfinite(value)) return;
+            if (std::isnan(offset_[slot])) offset_[slot] = value;
+
+            const double shifted = value - offset_[slot];
+            ++count_[slot];
+            sum_[slot] += shifted;
+            sum_sq_[slot] += shifted * shifted;
+            min_[slot] = std::min(min_[slot], value);
+            max_[slot] = std::max(max_[slot], value);
+
+            auto& samples = samples_[slot];
+            if (samples.ring.empty()) return;
+            if (samples.skip != 0) {
+                --samples.skip;
+                return;
+            }
+            samples.skip = samples.stride - 1;
+            samples.ring[samples.head] = value;
+            samples.head = (samples.head + 1) % samples.ring.size();
+            ++samples.cur_kept;
+        }
+
+        // ends the current pane and summarizes the last window (count == 0 if it saw no samples)
+        WindowSummary close_pane(std::size_t slot) {
+            const std::size_t base = pane_base_[slot];
+            const std::size_t panes = panes_[slot];
+            const std::size_t pane = base + pane_head_[slot];
+
+            pane_count_[pane] = count_[slot];
+            pane_sum_[pane] = sum_[slot];
+            pane_sum_sq_[pane] = sum_sq_[slot];
+            pane_min_[pane] = min_[slot];
+            pane_max_[pane] = max_[slot];
+            count_[slot] = 0;
+            sum_[slot] = 0.0;
+            sum_sq_[slot] = 0.0;
+            min_[slot] = k_inf;
+            max_[slot] = -k_inf;
+
+            auto& samples = samples_[slot];
+            if (!samples.ring.empty()) {
+                samples.pane_kept[pane_head_[slot]] = samples.cur_kept;
+                samples.cur_kept = 0;
+            }
+            pane_head_[slot] = (pane_head_[slot] + 1) % static_cast<std::uint32_t>(panes);
+
+            WindowSummary out;
+            out.window_ms = window_ms_[slot];
+            double sum = 0.0;
+            double sum_sq = 0.0;
+            double lo = k_inf;
+            double hi = -k_inf;
+            for (std::size_t i = base; i < base + panes; ++i) {
+                out.count += pane_count_[i];
+                sum += pane_sum_[i];
+                sum_sq += pane_sum_sq_[i];
+                lo = std::min(lo, pane_min_[i]);
+                hi = std::max(hi, pane_max_[i]);
+            }
+            if (out.count == 0) return out;
+
+            const double n = static_cast<double>(out.count);
+            const double mean_shifted = sum / n;
+            out.min = lo;
+            out.max = hi;
+            out.mean = offset_[slot] + mean_shifted;
+            out.stddev = std::sqrt(std::max(0.0, sum_sq / n - mean_shifted * mean_shifted));
+            if (!samples.ring.empty()) percentiles_(samples, out);
+            return out;
+        }
+
+    private:
+        static constexpr double k_inf = std::numeric_limits<double>::infinity();
+
+        struct Samples {
+            std::vector<double> ring;              // empty = percentiles disabled
+            std::size_t head = 0;
+            std::uint32_t stride = 1;
+            std::uint32_t skip = 0;
+            std::vector<std::size_t> pane_kept;    // samples kept per closed pane
+            std::size_t cur_kept = 0;
+            std::vector<double> scratch;
+        };
+
+        static void percentiles_(Samples& samples, WindowSummary& out) {
+            std::size_t kept = 0;
+            for (const auto n : samples.pane_kept) kept += n;
+            kept = std::min(kept, samples.ring.size());
+            if (kept == 0) return;
+
+            // the window's samples are the `kept` most recent entries of the ring
+            samples.scratch.clear();
+            const std::size_t cap = samples.ring.size();
+            for (std::size_t i = 0; i < kept; ++i) samples.scratch.push_back(samples.ring[(samples.head + cap - kept + i) % cap]);
+            std::sort(samples.scratch.begin(), samples.scratch.end());
+
+            // nearest rank
+            const auto at = [&](double q) {
+                const auto rank = static_cast<std::size_t>(std::ceil(q * static_cast<double>(kept)));
+                return samples.scratch[std::max<std::size_t>(rank, 1) - 1];
+            };
+            out.has_percentiles = true;
+            out.p50 = at(0.50);
+            out.p90 = at(0.90);
+            out.p99 = at(0.99);
+        }
+
+        std::vector<std::uint32_t> window_ms_;
+
+        // current pane, one entry per slot
+        std::vector<std::uint64_t> count_;
+        std::vector<double> sum_;
+        std::vector<double> sum_sq_;
+        std::vector<double> min_;
+        std::vector<double> max_;
+        std::vector<double> offset_; // first value seen; NaN until then
+
+        // closed panes; slot s owns [pane_base_[s], pane_base_[s] + panes_[s]) as a ring
+        std::vector<std::size_t> pane_base_;
+        std::vector<std::uint32_t> panes_;
+        std::vector<std::uint32_t> pane_head_;
+        std::vector<std::uint64_t> pane_count_;
+        std::vector<double> pane_sum_;
+        std::vector<double> pane_sum_sq_;
+        std::vector<double> pane_min_;
+        std::vector<double> pane_max_;
+
+        std::vector<Samples> samples_;
+};
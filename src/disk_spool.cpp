@@ -0,0 +1,466 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "disk_spool.h"
+#include "crc32.h"
+#include "logger.h"
+#include "time_utils.h"
+
+namespace {
+
+    void put_u16(std::string& out, std::uint16_t v) {
+        out.push_back(static_cast<char>(v & 0xFF));
+        out.push_back(static_cast<char>((v >> 8) & 0xFF));
+    }
+
+    void put_u32(std::string& out, std::uint32_t v) {
+        for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+    }
+
+    // same encoding as put_u32, over 4 bytes already in place
+    void set_u32(char* out, std::uint32_t v) {
+        for (int i = 0; i < 4; ++i) out[i] = static_cast<char>((v >> (8 * i)) & 0xFF);
+    }
+
+    void put_u64(std::string& out, std::uint64_t v) {
+        for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+    }
+
+    std::uint64_t get_le(const char* p, int len) {
+        std::uint64_t v = 0;
+        for (int i = len - 1; i >= 0; --i) v = (v << 8) | static_cast<std::uint8_t>(p[i]);
+        return v;
+    }
+
+    bool pread_all(int fd, char* buf, std::size_t len, std::uint64_t offset) {
+        while (len > 0) {
+            const ssize_t n = ::pread(fd, buf, len, static_cast<off_t>(offset));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            buf += n;
+            len -= static_cast<std::size_t>(n);
+            offset += static_cast<std::uint64_t>(n);
+        }
+        return true;
+    }
+
+    bool write_all(int fd, const char* buf, std::size_t len) {
+        while (len > 0) {
+            const ssize_t n = ::write(fd, buf, len);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            buf += n;
+            len -= static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+    std::string errno_str() { return std::strerror(errno); }
+
+} // namespace
+
+DiskSpool::DiskSpool(Options opts) : opts_(std::move(opts)) {
+    if (opts_.dir.empty()) throw std::runtime_error("spool dir must not be empty");
+    if (::mkdir(opts_.dir.c_str(), 0750) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Failed to create spool dir " + opts_.dir + ": " + errno_str());
+    }
+    dir_fd_ = ::open(opts_.dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd_ < 0) throw std::runtime_error("Failed to open spool dir " + opts_.dir + ": " + errno_str());
+    try {
+        recover_();
+    } catch (...) {
+        ::close(dir_fd_);
+        throw;
+    }
+}
+
+DiskSpool::~DiskSpool() {
+    flush();
+    if (cursor_dirty_) persist_cursor_();
+    close_active_();
+    if (read_fd_ >= 0) ::close(read_fd_);
+    ::close(dir_fd_);
+}
+
+// makes created, renamed and unlinked entries durable; without it a power loss can undo them
+void DiskSpool::sync_dir_() {
+    if (::fsync(dir_fd_) != 0) LOG_WARN("Spool: cannot sync " + opts_.dir + ": " + errno_str());
+}
+
+std::string DiskSpool::segment_path_(std::uint64_t index) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llu.seg", static_cast<unsigned long long>(index));
+    return opts_.dir + "/" + name;
+}
+
+std::string DiskSpool::cursor_path_() const { return opts_.dir + "/cursor"; }
+
+// ---- recovery ----
+
+void DiskSpool::recover_() {
+    std::vector<std::uint64_t> indices;
+    DIR* dir = ::opendir(opts_.dir.c_str());
+    if (!dir) throw std::runtime_error("Failed to open spool dir " + opts_.dir + ": " + errno_str());
+    while (const dirent* entry = ::readdir(dir)) {
+        const std::string_view name(entry->d_name);
+        if (name.size() != 20 || name.substr(16) != ".seg") continue;
+        if (!std::all_of(name.begin(), name.begin() + 16, [](char c) { return c >= '0' && c <= '9'; })) continue;
+        indices.push_back(std::stoull(std::string(name.substr(0, 16))));
+    }
+    ::closedir(dir);
+    std::sort(indices.begin(), indices.end());
+
+    std::uint64_t cursor_segment = 0;
+    std::uint64_t cursor_offset = 0;
+    load_cursor_(cursor_segment, cursor_offset);
+
+    for (const auto index : indices) {
+        next_index_ = index + 1;
+        if (index < cursor_segment) {
+            ::unlink(segment_path_(index).c_str()); // fully drained before the last shutdown/crash
+            continue;
+        }
+
+        Segment seg;
+        seg.index = index;
+        const std::uint64_t start = scan_segment_(seg, index == cursor_segment ? cursor_offset : 0);
+        if (seg.records == 0) {
+            ::unlink(segment_path_(index).c_str());
+            continue;
+        }
+        if (segments_.empty()) {
+            read_segment_ = index;
+            read_offset_ = start;
+        }
+        segments_.push_back(seg);
+        total_bytes_ += seg.bytes;
+        pending_ += seg.records;
+    }
+
+    // new segments must sort after the cursor, even when every segment before it was drained
+    // and removed; otherwise the next recovery would take them for drained ones
+    next_index_ = std::max(next_index_, cursor_segment + 1);
+    persist_cursor_();
+
+    if (pending_ > 0) {
+        LOG_INFO("Spool recovered " + std::to_string(pending_) + " records in " + std::to_string(segments_.size()) + " segments");
+    }
+}
+
+// Validates every record of a segment, truncating at the first torn/corrupt one.
+// Counts records at or after start_offset; returns the offset draining should start from.
+std::uint64_t DiskSpool::scan_segment_(Segment& seg, std::uint64_t start_offset) {
+    const std::string path = segment_path_(seg.index);
+    const int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_WARN("Spool: cannot open " + path + ": " + errno_str());
+        return 0;
+    }
+
+    struct stat st{};
+    ::fstat(fd, &st);
+    const auto file_size = static_cast<std::uint64_t>(st.st_size);
+
+    std::uint64_t offset = 0;
+    std::uint64_t total_records = 0;
+    std::uint64_t records_after_start = 0;
+    bool start_on_boundary = (start_offset == 0);
+    std::string body;
+    char header[k_header_len];
+
+    while (offset + k_header_len <= file_size) {
+        if (!pread_all(fd, header, k_header_len, offset)) break;
+        const auto body_len = static_cast<std::uint32_t>(get_le(header, 4));
+        const auto crc = static_cast<std::uint32_t>(get_le(header + 4, 4));
+        if (body_len < k_body_fixed_len || body_len > k_max_record_len) break;
+        if (offset + k_header_len + body_len > file_size) break;
+
+        body.resize(body_len);
+        if (!pread_all(fd, body.data(), body_len, offset + k_header_len)) break;
+        if (crc32(body.data(), body.size()) != crc) break;
+
+        if (offset == start_offset) start_on_boundary = true;
+        if (offset >= start_offset) ++records_after_start;
+        ++total_records;
+        offset += k_header_len + body_len;
+    }
+
+    if (offset < file_size) {
+        LOG_WARN("Spool: truncating " + path + " at " + std::to_string(offset) + " (torn or corrupt record)");
+        if (::ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+            LOG_WARN("Spool: ftruncate failed: " + errno_str());
+        }
+    }
+    ::close(fd);
+
+    seg.bytes = offset;
+    if (!start_on_boundary && start_offset != offset) {
+        LOG_WARN("Spool: cursor does not match a record boundary, replaying " + path + " from the start");
+        start_offset = 0;
+        records_after_start = total_records;
+    }
+    seg.records = records_after_start;
+    return std::min(start_offset, offset);
+}
+
+void DiskSpool::load_cursor_(std::uint64_t& segment, std::uint64_t& offset) const {
+    FILE* file = std::fopen(cursor_path_().c_str(), "r");
+    if (!file) return;
+    unsigned long long seg = 0;
+    unsigned long long off = 0;
+    if (std::fscanf(file, "%llu %llu", &seg, &off) == 2) {
+        segment = seg;
+        offset = off;
+    }
+    std::fclose(file);
+}
+
+void DiskSpool::persist_cursor_() {
+    cursor_dirty_ = false;
+    last_cursor_ = Clock::now();
+
+    const std::string tmp = cursor_path_() + ".tmp";
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        LOG_WARN("Spool: cannot write cursor: " + errno_str());
+        return;
+    }
+    const std::uint64_t segment = segments_.empty() ? next_index_ : segments_.front().index;
+    const std::uint64_t offset = segments_.empty() ? 0 : read_offset_;
+    const std::string line = std::to_string(segment) + " " + std::to_string(offset) + "\n";
+    const bool ok = write_all(fd, line.data(), line.size()) && ::fdatasync(fd) == 0;
+    ::close(fd);
+    if (!ok || ::rename(tmp.c_str(), cursor_path_().c_str()) != 0) {
+        LOG_WARN("Spool: cannot write cursor: " + errno_str());
+        return;
+    }
+    // also covers segments recover_() unlinked
+    sync_dir_();
+}
+
+// ---- writing ----
+
+bool DiskSpool::open_active_() {
+    const std::uint64_t index = next_index_++;
+    const std::string path = segment_path_(index);
+    active_fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0640);
+    if (active_fd_ < 0) {
+        LOG_ERROR("Spool: cannot create " + path + ": " + errno_str());
+        return false;
+    }
+    sync_dir_(); // records fdatasync'd later must not vanish with the entry
+    Segment seg;
+    seg.index = index;
+    if (segments_.empty()) {
+        read_segment_ = index;
+        read_offset_ = 0;
+    }
+    segments_.push_back(seg);
+    active_durable_ = 0;
+    return true;
+}
+
+void DiskSpool::close_active_() {
+    if (active_fd_ < 0) return;
+    ::close(active_fd_);
+    active_fd_ = -1;
+}
+
+void DiskSpool::drop_head_segment_() {
+    if (segments_.empty()) return;
+    const Segment seg = segments_.front();
+    const bool is_active = (active_fd_ >= 0 && segments_.size() == 1);
+    if (is_active) {
+        write_buf_.clear();
+        buffered_records_ = 0;
+        close_active_();
+    }
+    if (read_fd_ >= 0) {
+        ::close(read_fd_);
+        read_fd_ = -1;
+    }
+
+    ::unlink(segment_path_(seg.index).c_str());
+    sync_dir_();
+    pending_ -= seg.records;
+    dropped_ += seg.records;
+    total_bytes_ -= seg.bytes;
+    segments_.pop_front();
+
+    read_offset_ = 0;
+    read_segment_ = segments_.empty() ? 0 : segments_.front().index;
+    cursor_dirty_ = true;
+}
+
+void DiskSpool::enforce_size_cap_(std::uint64_t incoming) {
+    // never drop the segment being written; a full single segment rejects the record instead
+    while (total_bytes_ + incoming > opts_.max_bytes && segments_.size() > 1) {
+        LOG_WARN("Spool size cap reached, dropping " + std::to_string(segments_.front().records) + " oldest records");
+        drop_head_segment_();
+    }
+}
+
+bool DiskSpool::append(std::string_view topic, std::string_view payload, std::int64_t timestamp_s) {
+    if (topic.size() > 0xFFFF) return false;
+    const std::uint64_t body_len = k_body_fixed_len + topic.size() + payload.size();
+    if (body_len > k_max_record_len) return false;
+    const std::uint64_t record_len = k_header_len + body_len;
+
+    enforce_size_cap_(record_len);
+    if (total_bytes_ + record_len > opts_.max_bytes && !segments_.empty()) {
+        ++dropped_;
+        return false;
+    }
+
+    const bool rotate = active_fd_ >= 0 && segments_.back().bytes > 0 &&
+                        segments_.back().bytes + record_len > opts_.segment_bytes;
+    if (rotate) {
+        flush();
+        close_active_();
+    }
+    if (active_fd_ < 0 && !open_active_()) {
+        ++dropped_;
+        return false;
+    }
+
+    // encode straight into the write buffer; the crc is patched in once the body is there
+    const std::size_t start = write_buf_.size();
+    put_u32(write_buf_, static_cast<std::uint32_t>(body_len));
+    put_u32(write_buf_, 0);
+    put_u64(write_buf_, static_cast<std::uint64_t>(timestamp_s));
+    put_u16(write_buf_, static_cast<std::uint16_t>(topic.size()));
+    write_buf_.append(topic);
+    write_buf_.append(payload);
+
+    set_u32(write_buf_.data() + start + 4, crc32(write_buf_.data() + start + k_header_len, body_len));
+
+    auto& seg = segments_.back();
+    seg.bytes += record_len;
+    ++seg.records;
+    ++pending_;
+    total_bytes_ += record_len;
+
+    if (++buffered_records_ >= opts_.flush_records) flush();
+    return true;
+}
+
+void DiskSpool::flush() {
+    last_flush_ = Clock::now();
+    if (write_buf_.empty() || active_fd_ < 0) return;
+
+    if (!write_all(active_fd_, write_buf_.data(), write_buf_.size()) || ::fdatasync(active_fd_) != 0) {
+        LOG_ERROR("Spool write failed: " + errno_str() + " (dropping " + std::to_string(buffered_records_) + " records)");
+        // roll the segment back to its last durable size so it stays parseable
+        if (::ftruncate(active_fd_, static_cast<off_t>(active_durable_)) != 0) {
+            LOG_WARN("Spool: ftruncate failed: " + errno_str());
+        }
+        auto& seg = segments_.back();
+        const auto lost_bytes = seg.bytes - active_durable_;
+        seg.bytes = active_durable_;
+        seg.records -= buffered_records_;
+        pending_ -= buffered_records_;
+        dropped_ += buffered_records_;
+        total_bytes_ -= lost_bytes;
+    } else {
+        active_durable_ += write_buf_.size();
+    }
+    write_buf_.clear();
+    buffered_records_ = 0;
+}
+
+void DiskSpool::tick(TimePoint now) {
+    if (!write_buf_.empty() && now - last_flush_ >= opts_.flush_interval) flush();
+    if (cursor_dirty_ && now - last_cursor_ >= opts_.flush_interval) persist_cursor_();
+}
+
+// ---- draining ----
+
+bool DiskSpool::read_record_(Record& out, std::uint64_t& record_len) {
+    const auto& head = segments_.front();
+    if (read_fd_ < 0 || read_segment_ != head.index) {
+        if (read_fd_ >= 0) ::close(read_fd_);
+        read_segment_ = head.index;
+        read_fd_ = ::open(segment_path_(head.index).c_str(), O_RDONLY | O_CLOEXEC);
+        if (read_fd_ < 0) return false;
+    }
+
+    char header[k_header_len];
+    if (!pread_all(read_fd_, header, k_header_len, read_offset_)) return false;
+    const auto body_len = static_cast<std::uint32_t>(get_le(header, 4));
+    const auto crc = static_cast<std::uint32_t>(get_le(header + 4, 4));
+    if (body_len < k_body_fixed_len || body_len > k_max_record_len) return false;
+
+    read_buf_.resize(body_len);
+    if (!pread_all(read_fd_, read_buf_.data(), body_len, read_offset_ + k_header_len)) return false;
+    if (crc32(read_buf_.data(), read_buf_.size()) != crc) return false;
+
+    const auto topic_len = static_cast<std::size_t>(get_le(read_buf_.data() + 8, 2));
+    if (k_body_fixed_len + topic_len > body_len) return false;
+
+    const std::string_view body(read_buf_);
+    out.timestamp_s = static_cast<std::int64_t>(get_le(read_buf_.data(), 8));
+    out.topic = body.substr(k_body_fixed_len, topic_len);
+    out.payload = body.substr(k_body_fixed_len + topic_len);
+    record_len = k_header_len + body_len;
+    return true;
+}
+
+bool DiskSpool::peek(Record& out) {
+    while (pending_ > 0 && !segments_.empty()) {
+        auto& head = segments_.front();
+        const bool head_is_active = (active_fd_ >= 0 && segments_.size() == 1);
+
+        if (head.records == 0) {
+            if (head_is_active) return false;
+            drop_head_segment_();
+            continue;
+        }
+
+        // only read what is on disk; catch up with the writer when draining reaches buffered records
+        if (head_is_active && read_offset_ >= active_durable_) {
+            flush();
+            if (read_offset_ >= active_durable_) return false;
+        }
+
+        std::uint64_t record_len = 0;
+        if (!read_record_(out, record_len)) {
+            LOG_WARN("Spool: unreadable record in segment " + std::to_string(head.index) + ", dropping segment");
+            drop_head_segment_();
+            continue;
+        }
+        peeked_len_ = record_len;
+
+        if (opts_.max_age_s > 0 && out.timestamp_s < unix_time_s() - opts_.max_age_s) {
+            pop();
+            ++dropped_; // expired records are discarded, not delivered
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+void DiskSpool::pop() {
+    if (segments_.empty() || peeked_len_ == 0) return;
+    auto& head = segments_.front();
+
+    read_offset_ += peeked_len_;
+    peeked_len_ = 0;
+    --head.records;
+    --pending_;
+    cursor_dirty_ = true;
+
+    // a fully drained segment is removed (it has no records left, so nothing counts as dropped)
+    const bool head_is_active = (active_fd_ >= 0 && segments_.size() == 1);
+    if (head.records == 0 && !head_is_active) drop_head_segment_();
+}
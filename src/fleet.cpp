@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "fleet.h"
+#include "latency_histogram.h"
+#include "logger.h"
+#include "mqtt_client.h"
+#include "payload_writer.h"
+#include "scheduler.h"
+#include "time_utils.h"
+#include "topic_builder.h"
+
+namespace {
+
+    // keepalive pings, reconnects and timeouts are serviced at this period even when idle
+    constexpr auto k_housekeeping_period = std::chrono::milliseconds(100);
+    constexpr int k_max_events = 256;
+
+    struct FleetDevice {
+        std::unique_ptr<MqttClient> mqtt;
+        std::vector<std::string> topics;             // per metric
+        std::optional<FleetPayloads> payloads;
+        std::vector<double> values;                  // next simulated value per metric
+        std::uint64_t seq = 0;
+        TimePoint connect_at{};
+        bool started = false;
+
+        // what is registered with the loop's epoll set
+        int fd = -1;
+        bool want_write = false;
+        std::uint64_t reconnects = 0;
+    };
+
+    // written by one loop thread, read by the reporter
+    struct LoopStats {
+        std::atomic<std::uint64_t> published{0};
+        std::atomic<std::uint64_t> skipped{0}; // due while disconnected or with a full window
+    };
+
+    // One event-loop thread serving a contiguous slice of the fleet. Every MqttClient call for a
+    // device happens on this thread, so each client is single-threaded like the daemon's.
+    class FleetLoop {
+        public:
+            FleetLoop(std::span<FleetDevice> devices, std::size_t first_index, std::size_t total,
+                      const AppConfig& cfg, TimePoint start)
+                : devices_(devices), cfg_(cfg), epoll_fd_(::epoll_create1(EPOLL_CLOEXEC)) {
+                if (epoll_fd_ < 0) throw std::runtime_error("epoll_create1 failed");
+
+                // job id = local device index * metrics + metric
+                const std::size_t metrics = cfg.metrics.size();
+                for (std::size_t d = 0; d < devices_.size(); ++d) {
+                    for (std::size_t m = 0; m < metrics; ++m) {
+                        const int interval = effective_interval_ms(cfg, cfg.metrics[m]);
+                        const int spread = cfg.fleet.phase_spread_ms > 0 ? cfg.fleet.phase_spread_ms : interval;
+                        const auto slot = fleet_slot(first_index + d, total, cfg.fleet.ramp_per_s, spread);
+                        scheduler_.add(std::chrono::milliseconds(interval), start + slot.first_publish);
+                    }
+                }
+                due_.reserve(devices_.size() * metrics);
+            }
+
+            ~FleetLoop() { ::close(epoll_fd_); }
+
+            FleetLoop(const FleetLoop&) = delete;
+            FleetLoop& operator = (const FleetLoop&) = delete;
+
+            const LoopStats& stats() const noexcept { return stats_; }
+
+            void run(const std::atomic<bool>& running) {
+                std::array<epoll_event, k_max_events> events{};
+                auto next_housekeeping = Clock::now();
+
+                while (running.load(std::memory_order_relaxed)) {
+                    auto now = Clock::now();
+                    start_due_(now);
+                    publish_due_(now);
+
+                    if (now >= next_housekeeping) {
+                        housekeeping_();
+                        next_housekeeping = now + k_housekeeping_period;
+                    }
+
+                    TimePoint wake = std::min(scheduler_.next_deadline(), next_housekeeping);
+                    if (next_start_ < devices_.size()) wake = std::min(wake, devices_[next_start_].connect_at);
+                    now = Clock::now();
+                    // round up so a deadline less than 1 ms away does not spin
+                    const auto wait = wake > now ? std::chrono::ceil<std::chrono::milliseconds>(wake - now).count() : 0;
+
+                    const int n = ::epoll_wait(epoll_fd_, events.data(), k_max_events, static_cast<int>(wait));
+                    for (int i = 0; i < n; ++i) {
+                        auto& dev = *static_cast<FleetDevice*>(events[i].data.ptr);
+                        const bool readable = events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR);
+                        const bool writable = events[i].events & EPOLLOUT;
+                        dev.mqtt->service_io(readable, writable);
+                        sync_(dev);
+                    }
+                }
+            }
+
+        private:
+            void start_due_(TimePoint now) {
+                for (; next_start_ < devices_.size() && devices_[next_start_].connect_at <= now; ++next_start_) {
+                    auto& dev = devices_[next_start_];
+                    dev.started = true;
+                    // a failed attempt is retried by tick() under the client's backoff
+                    if (!dev.mqtt->connect(cfg_.keepalive_s, false)) {
+                        LOG_DEBUG("Fleet device " + dev.mqtt->client_id() + " connect failed");
+                    }
+                    sync_(dev);
+                }
+            }
+
+            void publish_due_(TimePoint now) {
+                due_.clear();
+                scheduler_.collect_due(now, due_);
+                if (due_.empty()) return;
+
+                const std::size_t metrics = cfg_.metrics.size();
+                wall_.refresh();
+                for (const auto id : due_) {
+                    auto& dev = devices_[id / metrics];
+                    const auto m = id % metrics;
+                    if (!dev.started || !dev.mqtt->connected()) {
+                        stats_.skipped.fetch_add(1, std::memory_order_relaxed);
+                        continue;
+                    }
+
+                    const auto payload = dev.payloads->write(m, dev.values[m], dev.seq, wall_, now);
+                    if (dev.mqtt->publish(dev.topics[m], payload, cfg_.qos, cfg_.retain)) {
+                        ++dev.seq;
+                        dev.values[m] += cfg_.metrics[m].step;
+                        stats_.published.fetch_add(1, std::memory_order_relaxed);
+                    } else {
+                        stats_.skipped.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    sync_(dev);
+                }
+            }
+
+            void housekeeping_() {
+                for (std::size_t i = 0; i < next_start_; ++i) {
+                    auto& dev = devices_[i];
+                    dev.mqtt->tick();
+                    dev.mqtt->service_io(false, false);
+                    sync_(dev);
+                }
+            }
+
+            // Keeps the epoll registration in step with the client's socket. Called right after
+            // every operation on a device, so a closed fd cannot be reused by another device's
+            // socket before this one is updated. A reconnect may reuse the same fd number (closing
+            // it dropped the old registration), hence the reconnect counter check.
+            void sync_(FleetDevice& dev) {
+                const int fd = dev.mqtt->socket();
+                const bool want_write = fd >= 0 && dev.mqtt->want_write();
+                const auto reconnects = dev.mqtt->reconnects();
+
+                epoll_event ev{};
+                ev.events = EPOLLIN | (want_write ? EPOLLOUT : 0u);
+                ev.data.ptr = &dev;
+
+                if (fd != dev.fd || reconnects != dev.reconnects) {
+                    if (dev.fd >= 0) ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, dev.fd, nullptr); // ENOENT once closed
+                    if (fd >= 0 && ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+                        ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+                    }
+                } else if (fd >= 0 && want_write != dev.want_write) {
+                    ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+                }
+                dev.fd = fd;
+                dev.want_write = want_write;
+                dev.reconnects = reconnects;
+            }
+
+            std::span<FleetDevice> devices_;
+            const AppConfig& cfg_;
+            int epoll_fd_;
+            DeadlineScheduler scheduler_;
+            std::vector<std::size_t> due_;
+            WallClock wall_;
+            std::size_t next_start_ = 0; // devices_ before this have been started (connect_at ascends)
+            LoopStats stats_;
+    };
+
+    // each device needs a socket; raise the soft limit as far as the hard limit allows
+    void raise_fd_limit(std::size_t devices) {
+        rlimit lim{};
+        if (::getrlimit(RLIMIT_NOFILE, &lim) != 0) return;
+        const rlim_t wanted = static_cast<rlim_t>(devices) + 64;
+        if (lim.rlim_cur >= wanted) return;
+        lim.rlim_cur = lim.rlim_max == RLIM_INFINITY ? wanted : std::min(wanted, lim.rlim_max);
+        ::setrlimit(RLIMIT_NOFILE, &lim);
+        if (lim.rlim_cur < wanted) {
+            LOG_WARN("Open file limit " + std::to_string(lim.rlim_cur) + " is below the " + std::to_string(wanted) +
+                     " a fleet of " + std::to_string(devices) + " needs; raise it with ulimit -n");
+        }
+    }
+
+    std::string format_rate(double value) {
+        std::array<char, 32> buf{};
+        std::snprintf(buf.data(), buf.size(), "%.1f", value);
+        return buf.data();
+    }
+
+    class FleetReporter {
+        public:
+            FleetReporter(const std::vector<FleetDevice>& devices, const std::vector<std::unique_ptr<FleetLoop>>& loops)
+                : devices_(devices), loops_(loops), start_(Clock::now()), last_at_(start_) {}
+
+            void report() {
+                const auto now = Clock::now();
+                const auto totals = totals_();
+                LatencyHistogram::Counts merged{};
+                for (const auto& dev : devices_) dev.mqtt->ack_latency().accumulate(merged);
+                const auto ack = ack_window_.update(merged);
+
+                const double dt = std::chrono::duration<double>(now - last_at_).count();
+                const double rate = dt > 0.0 ? static_cast<double>(totals.delivered - last_.delivered) / dt : 0.0;
+                LOG_INFO("Fleet: " + std::to_string(totals.connected) + "/" + std::to_string(devices_.size()) +
+                         " connected, " + format_rate(rate) + " msg/s delivered, " +
+                         std::to_string(totals.published - last_.published) + " published, " +
+                         std::to_string(totals.skipped - last_.skipped) + " skipped, ack us p50=" +
+                         std::to_string(ack.p50) + " p99=" + std::to_string(ack.p99) + " max=" + std::to_string(ack.max));
+                last_ = totals;
+                last_at_ = now;
+            }
+
+            FleetTotals report_totals() {
+                const auto totals = totals_();
+                const double secs = std::chrono::duration<double>(Clock::now() - start_).count();
+                LOG_INFO("Fleet totals: " + std::to_string(totals.published) + " published, " +
+                         std::to_string(totals.delivered) + " delivered, " + std::to_string(totals.skipped) +
+                         " skipped in " + format_rate(secs) + " s (" +
+                         format_rate(secs > 0.0 ? static_cast<double>(totals.delivered) / secs : 0.0) + " msg/s)");
+                return totals;
+            }
+
+        private:
+            FleetTotals totals_() const {
+                FleetTotals out;
+                for (const auto& loop : loops_) {
+                    out.published += loop->stats().published.load(std::memory_order_relaxed);
+                    out.skipped += loop->stats().skipped.load(std::memory_order_relaxed);
+                }
+                for (const auto& dev : devices_) {
+                    out.delivered += dev.mqtt->delivered();
+                    if (dev.mqtt->connected()) ++out.connected;
+                }
+                return out;
+            }
+
+            const std::vector<FleetDevice>& devices_;
+            const std::vector<std::unique_ptr<FleetLoop>>& loops_;
+            TimePoint start_;
+            FleetTotals last_;
+            TimePoint last_at_;
+            LatencyWindow ack_window_;
+    };
+
+} // namespace
+
+int run_fleet(const AppConfig& cfg, std::size_t devices, const std::atomic<bool>& running, FleetTotals* totals) {
+    if (devices == 0) throw std::runtime_error("--fleet needs at least one device");
+    raise_fd_limit(devices);
+
+    Mqtt5Options v5;
+    v5.enabled = cfg.mqtt5;
+    v5.topic_aliases = cfg.topic_aliases;
+    v5.message_expiry_s = static_cast<std::uint32_t>(cfg.message_expiry_s);
+    v5.content_type = "application/json";
+
+    const auto start = Clock::now();
+    std::vector<FleetDevice> fleet(devices);
+    for (std::size_t i = 0; i < devices; ++i) {
+        auto& dev = fleet[i];
+        const auto client_id = fleet_client_id(cfg.client_id, i, devices);
+        dev.mqtt = std::make_unique<MqttClient>(cfg.host, cfg.port, client_id, cfg.qos, std::string(), v5);
+        dev.mqtt->set_max_inflight(static_cast<std::size_t>(cfg.max_inflight));
+        dev.mqtt->compact_tracking();
+        dev.payloads.emplace(cfg, client_id);
+        for (const auto& metric : cfg.metrics) {
+            dev.topics.push_back(make_topic(client_id, metric.topic_suffix));
+            dev.values.push_back(metric.start);
+        }
+        dev.connect_at = start + fleet_slot(i, devices, cfg.fleet.ramp_per_s, 0).connect_at;
+    }
+
+    // contiguous slices so each loop starts its devices in connect_at order
+    const auto threads = std::min<std::size_t>(static_cast<std::size_t>(cfg.fleet.threads), devices);
+    std::vector<std::unique_ptr<FleetLoop>> loops;
+    for (std::size_t t = 0; t < threads; ++t) {
+        const std::size_t begin = devices * t / threads;
+        const std::size_t end = devices * (t + 1) / threads;
+        loops.push_back(std::make_unique<FleetLoop>(std::span(fleet).subspan(begin, end - begin), begin, devices, cfg, start));
+    }
+
+    LOG_INFO("Fleet: " + std::to_string(devices) + " devices on " + std::to_string(threads) + " event-loop threads, ramp " +
+             std::to_string(cfg.fleet.ramp_per_s) + " connections/s");
+
+    std::vector<std::thread> workers;
+    for (auto& loop : loops) workers.emplace_back([&loop, &running] { loop->run(running); });
+
+    FleetReporter reporter(fleet, loops);
+    const auto report_period = std::chrono::seconds(cfg.fleet.report_interval_s);
+    auto next_report = Clock::now() + report_period;
+    while (running.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_for(k_housekeeping_period);
+        if (Clock::now() >= next_report) {
+            reporter.report();
+            next_report += report_period;
+        }
+    }
+
+    for (auto& worker : workers) worker.join();
+    const auto final_totals = reporter.report_totals();
+    if (totals) *totals = final_totals;
+
+    // loops have exited, so this thread now owns every client; stop() sends the offline status
+    for (auto& dev : fleet) dev.mqtt->stop();
+    return EXIT_SUCCESS;
+}
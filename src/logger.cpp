@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "logger.h"
+#include "spsc_queue.h"
+#include "wakeup.h"
+
+namespace logger {
+
+namespace {
+
+    constexpr std::size_t max_file_len = 64;
+    constexpr auto writer_idle_wait = std::chrono::milliseconds(200);
+
+    struct Record {
+        std::int64_t time_us = 0; // system_clock
+        std::int32_t line = 0;
+        Level lvl = Level::Info;
+        std::uint16_t file_len = 0;
+        std::uint16_t msg_len = 0;
+        char text[max_file_len + max_message_len]; // file, then message
+    };
+
+    struct ThreadBuffer {
+        SpscQueue<Record> queue{thread_buffer_records};
+        std::atomic<std::uint64_t> dropped{0};
+        std::atomic<bool> retired{false}; // owning thread has exited
+    };
+
+    // "YYYY-mm-dd HH:MM:SS", reformatted only when the second changes
+    class TimestampCache {
+        public:
+            std::string_view get(std::int64_t time_us) {
+                const std::time_t sec = static_cast<std::time_t>(time_us / 1000000);
+                if (sec != cached_sec_) {
+                    std::tm tm{};
+                    localtime_r(&sec, &tm);
+                    len_ = std::strftime(text_, sizeof(text_), "%Y-%m-%d %H:%M:%S", &tm);
+                    cached_sec_ = sec;
+                }
+                return {text_, len_};
+            }
+
+        private:
+            std::time_t cached_sec_ = -1;
+            char text_[32] = {};
+            std::size_t len_ = 0;
+    };
+
+    struct Backend {
+        std::mutex registry_mutex;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+        // the SPSC consumer side is whoever holds this: the writer thread or flush()
+        std::mutex drain_mutex;
+        std::vector<Record> chunk = std::vector<Record>(thread_buffer_records);
+        std::vector<Record> drained;
+        std::string out;
+        TimestampCache drain_ts;
+        std::uint64_t retired_dropped = 0;
+        std::uint64_t reported_dropped = 0;
+
+        std::mutex sync_mutex;
+        TimestampCache sync_ts;
+        std::string sync_out;
+
+        std::mutex control_mutex;
+        std::atomic<bool> async{false};
+        std::atomic<bool> stopping{false};
+        std::thread writer;
+        Wakeup wakeup;
+    };
+
+    // never destroyed, so logging from static destructors stays safe
+    Backend& backend() {
+        static Backend* b = new Backend;
+        return *b;
+    }
+
+    struct ThreadHandle {
+        std::shared_ptr<ThreadBuffer> buffer;
+        ~ThreadHandle() {
+            if (buffer) buffer->retired.store(true, std::memory_order_release);
+        }
+    };
+
+    thread_local ThreadHandle t_handle;
+
+    ThreadBuffer& thread_buffer() {
+        if (!t_handle.buffer) {
+            t_handle.buffer = std::make_shared<ThreadBuffer>();
+            auto& b = backend();
+            std::lock_guard<std::mutex> lock(b.registry_mutex);
+            b.buffers.push_back(t_handle.buffer);
+        }
+        return *t_handle.buffer;
+    }
+
+    std::int64_t now_us() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()
+        ).count();
+    }
+
+    void fill(Record& rec, Level lvl, std::string_view file, int line, std::string_view msg) {
+        rec.time_us = now_us();
+        rec.line = line;
+        rec.lvl = lvl;
+        if (file.size() > max_file_len) file = file.substr(file.size() - max_file_len);
+        if (msg.size() > max_message_len) msg = msg.substr(0, max_message_len);
+        rec.file_len = static_cast<std::uint16_t>(file.size());
+        rec.msg_len = static_cast<std::uint16_t>(msg.size());
+        std::memcpy(rec.text, file.data(), file.size());
+        std::memcpy(rec.text + file.size(), msg.data(), msg.size());
+    }
+
+    void format(std::string& out, TimestampCache& ts, const Record& rec) {
+        out.append(ts.get(rec.time_us));
+        out.append(" [");
+        out.append(level_str(rec.lvl));
+        out.append("] ");
+        out.append(rec.text, rec.file_len);
+        out.push_back(':');
+        out.append(std::to_string(rec.line));
+        out.append(" - ");
+        out.append(rec.text + rec.file_len, rec.msg_len);
+        out.push_back('\n');
+    }
+
+    void write_fd(const std::string& out) {
+        const char* data = out.data();
+        std::size_t len = out.size();
+        while (len > 0) {
+            const ssize_t n = ::write(STDERR_FILENO, data, len);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return;
+            data += n;
+            len -= static_cast<std::size_t>(n);
+        }
+    }
+
+    void drain_all() {
+        auto& b = backend();
+        std::lock_guard<std::mutex> drain_lock(b.drain_mutex);
+
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        {
+            std::lock_guard<std::mutex> lock(b.registry_mutex);
+            buffers = b.buffers;
+        }
+
+        b.drained.clear();
+        std::uint64_t dropped = b.retired_dropped;
+        std::vector<ThreadBuffer*> finished;
+        for (const auto& buf : buffers) {
+            // read before draining: a retired thread cannot push anything after this
+            const bool retired = buf->retired.load(std::memory_order_acquire);
+            while (const std::size_t count = buf->queue.pop_bulk(b.chunk.data(), b.chunk.size())) {
+                b.drained.insert(b.drained.end(), b.chunk.begin(), b.chunk.begin() + static_cast<std::ptrdiff_t>(count));
+            }
+            dropped += buf->dropped.load(std::memory_order_relaxed);
+            if (retired) finished.push_back(buf.get());
+        }
+
+        if (!finished.empty()) {
+            std::lock_guard<std::mutex> lock(b.registry_mutex);
+            std::erase_if(b.buffers, [&](const std::shared_ptr<ThreadBuffer>& buf) {
+                if (std::find(finished.begin(), finished.end(), buf.get()) == finished.end()) return false;
+                b.retired_dropped += buf->dropped.load(std::memory_order_relaxed);
+                return true;
+            });
+        }
+
+        // per-thread order is preserved; interleave threads by time
+        std::stable_sort(b.drained.begin(), b.drained.end(),
+                         [](const Record& lhs, const Record& rhs) { return lhs.time_us < rhs.time_us; });
+
+        b.out.clear();
+        for (const auto& rec : b.drained) format(b.out, b.drain_ts, rec);
+
+        if (dropped > b.reported_dropped) {
+            Record note;
+            fill(note, Level::Warn, __FILE__, __LINE__,
+                 "logger buffers full, dropped " + std::to_string(dropped - b.reported_dropped) + " records");
+            format(b.out, b.drain_ts, note);
+            b.reported_dropped = dropped;
+        }
+
+        if (!b.out.empty()) write_fd(b.out);
+    }
+
+    void writer_loop() {
+        auto& b = backend();
+        while (!b.stopping.load(std::memory_order_acquire)) {
+            (void)b.wakeup.wait_for(writer_idle_wait);
+            drain_all();
+        }
+    }
+
+} // namespace
+
+void write(Level lvl, std::string_view file, int line, std::string_view msg) {
+    if (!enabled(lvl)) return;
+    auto& b = backend();
+
+    if (b.async.load(std::memory_order_acquire)) {
+        auto& buf = thread_buffer();
+        Record rec;
+        fill(rec, lvl, file, line, msg);
+        if (!buf.queue.try_push(rec)) {
+            buf.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // stop_async() may have run its final drain since the check above; pairs with its fence
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!b.async.load(std::memory_order_relaxed)) {
+            drain_all();
+            return;
+        }
+        b.wakeup.notify();
+        return;
+    }
+
+    Record rec;
+    fill(rec, lvl, file, line, msg);
+    std::lock_guard<std::mutex> lock(b.sync_mutex);
+    b.sync_out.clear();
+    format(b.sync_out, b.sync_ts, rec);
+    write_fd(b.sync_out);
+}
+
+void start_async() {
+    auto& b = backend();
+    std::lock_guard<std::mutex> lock(b.control_mutex);
+    if (b.async.load(std::memory_order_relaxed)) return;
+    b.stopping.store(false, std::memory_order_release);
+    b.writer = std::thread(writer_loop);
+    b.async.store(true, std::memory_order_release);
+}
+
+void stop_async() {
+    auto& b = backend();
+    std::lock_guard<std::mutex> lock(b.control_mutex);
+    if (!b.async.load(std::memory_order_relaxed)) return;
+    // new records go straight to stderr from here on; buffered ones are written below
+    b.async.store(false, std::memory_order_release);
+    // a write() that missed the store above sees its record drained below; one that saw it drains itself
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    b.stopping.store(true, std::memory_order_release);
+    b.wakeup.notify();
+    b.writer.join();
+    drain_all();
+}
+
+void flush() {
+    drain_all();
+}
+
+std::uint64_t dropped() {
+    auto& b = backend();
+    std::uint64_t total = 0;
+    {
+        std::lock_guard<std::mutex> lock(b.drain_mutex);
+        total = b.retired_dropped;
+    }
+    std::lock_guard<std::mutex> lock(b.registry_mutex);
+    for (const auto& buf : b.buffers) total += buf->dropped.load(std::memory_order_relaxed);
+    return total;
+}
+
+} // namespace logger
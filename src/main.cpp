@@ -1,11 +1,15 @@
 #include <atomic>
+#include <charconv>
 #include <csignal>
 #include <cstdint>
 #include <cstdlib>
 #include <thread>
+#include <algorithm>
 #include <vector>
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 #include <unistd.h>
 #include <chrono>
 #include <stdexcept>
@@ -14,18 +18,33 @@
 #include <mosquitto.h>
 
 #include "app_config.h"
+#include "config_diff.h"
+#include "counter_registry.h"
+#include "deadband_filter.h"
+#include "event_loop.h"
+#include "fleet.h"
+#include "latency_histogram.h"
 #include "logger.h"
+#include "metrics_endpoint.h"
+#include "metrics_snapshot.h"
 #include "mqtt_client.h"
-#include "telemetry_payload.h"
+#include "payload_format.h"
+#include "telemetry_publisher.h"
 #include "topic_builder.h"
-#include "health_payload.h"
+#include "sample_pipeline.h"
+#include "scheduler.h"
+#include "sensor_device.h"
 #include "sensor_factory.h"
-#include "simulated_sensor.h"
+#include "spsc_queue.h"
 #include "version.h"
+#include "wakeup.h"
+#include "window_aggregator.h"
 #include "time_utils.h"
 
 static std::atomic<bool> g_running{true};
+static std::atomic<bool> g_reload{false};
 static void handle_signal(int) { g_running.store(false, std::memory_order_relaxed); }
+static void handle_reload(int) { g_reload.store(true, std::memory_order_relaxed); }
 
 namespace {
 
@@ -38,6 +57,7 @@ namespace {
     struct CliOptions {
         CliAction action = CliAction::Run;
         std::string config_path = "config/config.json";
+        std::string fleet_devices; // --fleet N; empty = run as a single device
     };
 
     CliOptions parse_cli(int argc, char** argv) {
@@ -59,6 +79,12 @@ namespace {
                 return opts;
             }
 
+            if (arg == "--fleet") {
+                opts.fleet_devices = i + 1 < argc ? argv[++i] : "";
+                if (opts.fleet_devices.empty()) opts.fleet_devices = "0";
+                continue;
+            }
+
             if (!arg.empty() && arg[0] != '-') {
                 opts.config_path = arg;
             }
@@ -72,25 +98,101 @@ namespace {
         out["log_level"] = cfg.log_level;
         out["client_id"] = cfg.client_id;
         out["interval_ms"] = cfg.interval_ms;
+        out["health_interval_ms"] = cfg.health_interval_ms;
         out["qos"] = cfg.qos;
         out["retain"] = cfg.retain;
+        out["event_loop"] = cfg.epoll_loop ? "epoll" : "threads";
+        out["payload_format"] = payload_format_name(cfg.payload_format);
+        out["schema_version"] = cfg.schema_version;
+        out["batch"] = {
+            {"enabled", cfg.batch.enabled},
+            {"max_ticks", cfg.batch.max_ticks},
+            {"max_bytes", cfg.batch.max_bytes},
+            {"per_metric_topics", cfg.batch.per_metric_topics}
+        };
+        out["store_forward"] = {
+            {"capacity", cfg.store_forward.capacity},
+            {"policy", overflow_policy_name(cfg.store_forward.policy)},
+            {"replay_per_s", cfg.store_forward.replay_per_s}
+        };
+        out["spool"] = {
+            {"enabled", cfg.spool.enabled},
+            {"dir", cfg.spool.dir},
+            {"max_mb", cfg.spool.max_mb},
+            {"max_age_h", cfg.spool.max_age_h},
+            {"segment_kb", cfg.spool.segment_kb},
+            {"flush_records", cfg.spool.flush_records},
+            {"flush_interval_ms", cfg.spool.flush_interval_ms}
+        };
+        out["compression"] = {
+            {"enabled", cfg.compression.enabled},
+            {"min_bytes", cfg.compression.min_bytes},
+            {"level", cfg.compression.level},
+            {"dictionary", cfg.compression.dictionary}
+        };
+        out["metrics_endpoint"] = {
+            {"enabled", cfg.metrics_endpoint.enabled},
+            {"listen", cfg.metrics_endpoint.listen}
+        };
+        out["fleet"] = {
+            {"threads", cfg.fleet.threads},
+            {"ramp_per_s", cfg.fleet.ramp_per_s},
+            {"phase_spread_ms", cfg.fleet.phase_spread_ms},
+            {"report_interval_s", cfg.fleet.report_interval_s}
+        };
         out["broker"] = {
             {"host", cfg.host},
             {"port", cfg.port},
-            {"keepalive_s", cfg.keepalive_s}
+            {"keepalive_s", cfg.keepalive_s},
+            {"protocol", cfg.mqtt5 ? "mqtt5" : "mqtt311"},
+            {"topic_aliases", cfg.topic_aliases},
+            {"message_expiry_s", cfg.message_expiry_s},
+            {"max_inflight", cfg.max_inflight},
+            {"drain_timeout_ms", cfg.drain_timeout_ms},
+            {"connections", cfg.connections},
+            {"failover", {
+                {"policy", failover_policy_name(cfg.failover.policy)},
+                {"failback_after_s", cfg.failover.failback_after_s},
+                {"connect_timeout_s", cfg.failover.connect_timeout_s}
+            }}
         };
+        for (const auto& b : cfg.brokers) {
+            out["brokers"].push_back({{"host", b.host}, {"port", b.port}, {"priority", b.priority}});
+        }
 
         for (const auto& m : cfg.metrics) {
             out["metrics"].push_back({
                 {"name", m.name},
                 {"unit", m.unit},
                 {"type", m.type},
-                {"topic_suffix", m.topic_suffix}
+                {"source", m.source},
+                {"field", m.field},
+                {"scale", m.scale},
+                {"topic_suffix", m.topic_suffix},
+                {"interval_ms", effective_interval_ms(cfg, m)},
+                {"deadband_abs", m.deadband_abs},
+                {"deadband_pct", m.deadband_pct},
+                {"max_silence_ms", m.max_silence_ms},
+                {"aggregate", {
+                    {"window_ms", m.aggregate.window_ms},
+                    {"slide_ms", m.aggregate.slide_ms},
+                    {"percentiles", m.aggregate.percentiles},
+                    {"max_samples", m.aggregate.max_samples}
+                }}
             });
         }
         std::cout << out.dump(2) << "\n";
     }
 
+    std::size_t parse_fleet_devices(const std::string& arg) {
+        std::size_t devices = 0;
+        const auto res = std::from_chars(arg.data(), arg.data() + arg.size(), devices);
+        if (res.ec != std::errc{} || res.ptr != arg.data() + arg.size() || devices == 0) {
+            throw std::runtime_error("--fleet needs a positive device count, got '" + arg + "'");
+        }
+        return devices;
+    }
+
     struct MosquittoLibGuard {
         MosquittoLibGuard() { mosquitto_lib_init(); }
         ~MosquittoLibGuard() { mosquitto_lib_cleanup(); }
@@ -98,15 +200,10 @@ namespace {
         MosquittoLibGuard& operator=(const MosquittoLibGuard&) = delete;
     };
 
-    struct SensorEntry {
-        std::string topic;
-        std::unique_ptr<ISensor> sensor;
-    };
-
     struct AppState {
         std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
-        std::uint64_t publish_ok = 0;
-        std::uint64_t publish_fail = 0;
+        CounterRegistry counters; // shared with the sampler and MqttClient
+        MetricsSnapshot snapshot; // publisher state for the metrics endpoint
 
         std::uint64_t uptime_s() const {
             return (std::uint64_t)std::chrono::duration_cast<std::chrono::seconds>(
@@ -131,76 +228,585 @@ namespace {
         LOG_INFO("log level is: " + std::string(logger::level_str(lvl)));
     }
 
-    std::vector<SensorEntry> build_sensors(const AppConfig& cfg) {
-        std::vector<SensorEntry> sensors;
-        sensors.reserve(cfg.metrics.size());
-
-        for (const auto& metric : cfg.metrics) {
-            auto sensor = make_sensor(metric); 
-            if (!sensor || !sensor->init()) {
-                throw std::runtime_error("Sensor init failed: " + std::string(sensor ? sensor->name() : "null"));
-            }
-            sensors.push_back(SensorEntry {
-                make_topic(cfg.client_id, metric.topic_suffix),
-                std::move(sensor)
-            });
+    SensorSet build_sensors(const AppConfig& cfg) {
+        auto sensors = make_sensor_devices(cfg.metrics);
+        for (const auto& device : sensors.devices) {
+            if (!device->init()) throw std::runtime_error("Sensor init failed: " + std::string(device->name()));
         }
         return sensors;
     }
 
     void log_config_summary(const AppConfig& cfg) {
         LOG_INFO("Client ID: " + cfg.client_id);
-        LOG_INFO("Broker: " + cfg.host + ":" +std::to_string(cfg.port));
+        for (const auto& b : cfg.brokers) {
+            LOG_INFO("Broker: " + b.host + ":" + std::to_string(b.port) + " priority " + std::to_string(b.priority));
+        }
+        if (cfg.brokers.size() > 1) LOG_INFO("Broker failover: " + std::string(failover_policy_name(cfg.failover.policy)));
         LOG_INFO("Interval ms: " + std::to_string(cfg.interval_ms));
+        LOG_INFO("Payload format: " + std::string(payload_format_name(cfg.payload_format)) +
+                 " (schema " + std::to_string(cfg.schema_version) + ")");
+        LOG_INFO(std::string("MQTT protocol: ") + (cfg.mqtt5 ? "5" : "3.1.1"));
+        LOG_INFO(std::string("Event loop: ") + (cfg.epoll_loop ? "epoll" : "threads"));
+        if (cfg.connections > 1) LOG_INFO("Broker connections: " + std::to_string(cfg.connections));
         LOG_INFO("Metrics: " + std::to_string(cfg.metrics.size()) + " metrics");
     }
 
-    void publish_health(MqttClient& mqtt, 
-                        std::string health_topic,
-                        const AppConfig& cfg, 
-                        const AppState& state, 
-                        std::uint64_t seq) {
-        const auto now_s = unix_time_s();
-        auto health_payload = make_health_payload_v1(
-            cfg.client_id,
-            state.uptime_s(),
-            seq,
-            state.publish_ok,
-            state.publish_fail,
-            mqtt.reconnects(),
-            now_s
-        );
-        (void)mqtt.publish(health_topic, health_payload.dump(), /*qos*/ 1, /*retain*/ true);
-    }
-
-    int run_loop(MqttClient& mqtt, const AppConfig& cfg, std::vector<SensorEntry>& sensors) {
-        AppState state;
-        std::uint64_t seq = 0;
-        constexpr std::uint64_t health_every = 5;
-        const std::string health_topic = make_health_topic(cfg.client_id);
+    // extra sessions of broker.connections > 1 (telemetry only; the primary client keeps status/LWT)
+    using Shards = std::vector<std::unique_ptr<MqttClient>>;
+
+    // shard 0 is the device's own session; others get a suffixed client id and no status/LWT
+    std::unique_ptr<MqttClient> make_mqtt_client(const AppConfig& cfg, CounterRegistry& counters, std::size_t shard = 0) {
+        const std::string telemetry_content_type =
+            cfg.payload_format == PayloadFormat::JsonV1 ? std::string() : std::string(content_type(cfg.payload_format));
+        Mqtt5Options v5;
+        v5.enabled = cfg.mqtt5;
+        v5.topic_aliases = cfg.topic_aliases;
+        v5.message_expiry_s = static_cast<std::uint32_t>(cfg.message_expiry_s);
+        v5.content_type = std::string(content_type(cfg.payload_format));
+        const std::string client_id = shard == 0 ? cfg.client_id : make_shard_client_id(cfg.client_id, shard);
+        auto mqtt = std::make_unique<MqttClient>(cfg.host, cfg.port, client_id, cfg.qos, telemetry_content_type, v5);
+        if (shard != 0) mqtt->disable_status();
+        mqtt->set_max_inflight(static_cast<std::size_t>(cfg.max_inflight));
+        mqtt->set_counters(counters);
+        if (cfg.brokers.size() > 1) {
+            FailoverOptions failover;
+            failover.policy = cfg.failover.policy;
+            failover.failback_after = std::chrono::seconds(cfg.failover.failback_after_s);
+            failover.connect_timeout = std::chrono::seconds(cfg.failover.connect_timeout_s);
+            mqtt->set_brokers(cfg.brokers, failover);
+        }
+        return mqtt;
+    }
+
+    // throws std::runtime_error if a session cannot start connecting
+    Shards connect_shards(const AppConfig& cfg, CounterRegistry& counters) {
+        Shards shards;
+        for (int i = 1; i < cfg.connections; ++i) {
+            auto shard = make_mqtt_client(cfg, counters, static_cast<std::size_t>(i));
+            if (!shard->connect(cfg.keepalive_s)) throw std::runtime_error("MQTT connect of " + shard->client_id() + " failed");
+            shards.push_back(std::move(shard));
+        }
+        return shards;
+    }
+
+    std::vector<MqttClient*> shard_clients(const Shards& shards) {
+        std::vector<MqttClient*> out;
+        for (const auto& shard : shards) out.push_back(shard.get());
+        return out;
+    }
+
+    // waits until `deadline` for acks, then disconnects (publishing "offline" on the primary). The
+    // other sessions keep receiving acks meanwhile, so one deadline covers closing all of them.
+    void close_client(MqttClient& mqtt, std::chrono::steady_clock::time_point deadline) {
+        const auto left = deadline - std::chrono::steady_clock::now();
+        if (!mqtt.drain(std::max(std::chrono::milliseconds::zero(), std::chrono::duration_cast<std::chrono::milliseconds>(left)))) {
+            LOG_WARN(mqtt.client_id() + " closed with " + std::to_string(mqtt.unacked()) + " messages unacked");
+        }
+        mqtt.stop();
+    }
+
+    std::string join_names(const std::vector<std::string>& names) {
+        std::string out;
+        for (const auto& name : names) {
+            if (!out.empty()) out += ", ";
+            out += name;
+        }
+        return out;
+    }
 
+    // Reads the config file again (SIGHUP) and diffs it against the running config. Returns
+    // nullopt, after logging why, if it does not load, changes nothing, or changes settings that
+    // need a restart; the running config stays in effect.
+    std::optional<AppConfig> read_reload(const std::string& path, const AppConfig& running, ConfigDiff& diff) {
+        LOG_INFO("Reloading config from " + path);
+        AppConfig next;
+        try {
+            next = load_config_or_throw(path);
+            // fail now rather than halfway through applying it
+            if (next.compression.enabled && !next.compression.dictionary.empty() && !(next.compression == running.compression)) {
+                (void)load_compression_dictionary(next.compression.dictionary);
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR(std::string("Reload failed, keeping the running config: ") + e.what());
+            return std::nullopt;
+        }
+
+        diff = diff_config(running, next);
+        if (!diff.restart_only.empty()) {
+            LOG_ERROR("Reload rejected, these settings need a restart: " + join_names(diff.restart_only));
+            return std::nullopt;
+        }
+        if (diff.empty()) {
+            LOG_INFO("Reload: config unchanged");
+            return std::nullopt;
+        }
+        return next;
+    }
+
+    // connects the primary session of `cfg` and its shards into `mqtt` and `shards`, replacing
+    // (and closing) whatever they held; throws std::runtime_error if one cannot start connecting
+    void connect_sessions(const AppConfig& cfg, CounterRegistry& counters, std::unique_ptr<MqttClient>& mqtt, Shards& shards) {
+        shards.clear();
+        mqtt = make_mqtt_client(cfg, counters);
+        if (!mqtt->connect(cfg.keepalive_s, !cfg.epoll_loop)) throw std::runtime_error("MQTT connect to " + mqtt->broker() + " failed");
+        shards = connect_shards(cfg, counters);
+    }
+
+    // Applies a config from read_reload(). With diff.schedule the sampler must be stopped, its
+    // queue drained and, afterwards, rebuilt over the new sensors. Broker session changes drain
+    // and close the running sessions before connecting new ones: a second session with the same
+    // client id would take the first over, firing its LWT, and the two would keep kicking each
+    // other off. Everything else keeps running.
+    // Throws std::runtime_error if a new sensor or the new broker connection cannot be set up;
+    // the running config stays in effect and its sessions are connected again.
+    void apply_reload(AppConfig& cfg, AppConfig next, const ConfigDiff& diff, SensorSet& sensors,
+                      TelemetryPublisher& publisher, std::unique_ptr<MqttClient>& mqtt, Shards& shards,
+                      CounterRegistry& counters) {
+        const auto use_sessions = [&] {
+            publisher.set_client(*mqtt);
+            publisher.set_shards(shard_clients(shards));
+        };
+        const auto restore_sessions = [&] {
+            try {
+                connect_sessions(cfg, counters, mqtt, shards);
+            } catch (const std::exception& e) {
+                LOG_ERROR(std::string("Reload: reconnecting with the running config failed: ") + e.what());
+            }
+            use_sessions();
+        };
+
+        if (diff.reconnect) {
+            // a partial batch still goes out on the running session
+            publisher.flush();
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(cfg.drain_timeout_ms);
+            for (auto& shard : shards) close_client(*shard, deadline);
+            close_client(*mqtt, deadline);
+            try {
+                connect_sessions(next, counters, mqtt, shards);
+            } catch (...) {
+                restore_sessions();
+                throw;
+            }
+            use_sessions();
+        }
+        // last, since it takes the kept sensors out of `sensors` once it succeeds
+        std::optional<SensorSet> rebuilt;
+        if (diff.schedule) {
+            try {
+                rebuilt = rebuild_sensor_devices(sensors, next.metrics, diff.kept_from);
+            } catch (...) {
+                if (diff.reconnect) restore_sessions();
+                throw;
+            }
+        }
+
+        // readings and batches already built use the old metric ids and topics
+        publisher.flush();
+        const AppConfig previous = std::exchange(cfg, std::move(next));
+        if (rebuilt) sensors = std::move(*rebuilt);
+        if (diff.schedule || diff.publishing || diff.reconnect) publisher.reconfigure(previous);
+        if (diff.reconnect) LOG_INFO("Reload: reconnected to " + mqtt->broker());
+        if (diff.max_inflight) {
+            mqtt->set_max_inflight(static_cast<std::size_t>(cfg.max_inflight));
+            for (auto& shard : shards) shard->set_max_inflight(static_cast<std::size_t>(cfg.max_inflight));
+        }
+        if (diff.log_level) configure_logging_from_config(cfg);
+
+        if (!diff.added.empty()) LOG_INFO("Reload: added metrics: " + join_names(diff.added));
+        if (!diff.removed.empty()) LOG_INFO("Reload: removed metrics: " + join_names(diff.removed));
+        if (!diff.changed.empty()) LOG_INFO("Reload: changed metrics: " + join_names(diff.changed));
+        LOG_INFO("Config reloaded");
+    }
+
+    // upper bound on a single sleep so shutdown, reconnects and replay stay responsive
+    constexpr auto max_idle_sleep = std::chrono::milliseconds(100);
+    // readings the publisher may lag behind by before the sampler starts dropping
+    constexpr std::size_t min_queue_capacity = 1024;
+
+    // how stale the metrics endpoint's view of the publisher may get
+    constexpr auto snapshot_period = std::chrono::seconds(1);
+
+    using SampleQueue = SpscQueue<SampleEvent>;
+
+    void push_event(SampleQueue& queue, const SampleEvent& event, CounterRegistry& counters) {
+        if (!queue.try_push(event)) counters.add(Counter::QueueDropped);
+    }
+
+    // Owns the sensors, the schedule, the deadband filters and the aggregator and never touches
+    // the network. In the threaded loop it runs on its own thread, so a stalled broker connection
+    // cannot delay or skew sampling; the epoll loop calls run_due() from its sampling timer.
+    class Sampler {
+        public:
+            using Clock     = DeadlineScheduler::Clock;
+            using TimePoint = DeadlineScheduler::TimePoint;
+
+            Sampler(const AppConfig& cfg, SensorSet& sensors, SampleQueue& queue, Wakeup& wakeup,
+                    CounterRegistry& counters, LatencyHistogram& sample_latency)
+                : sensors_(sensors), queue_(queue), wakeup_(wakeup), counters_(counters),
+                  sample_latency_(sample_latency) {
+                // job ids 0..N-1 are the sensors (in config order), N is the health heartbeat,
+                // N+1.. close aggregation panes
+                const auto start = Clock::now();
+                for (const auto& metric : cfg.metrics) {
+                    scheduler_.add(std::chrono::milliseconds(effective_interval_ms(cfg, metric)), start);
+                }
+                health_job_ = scheduler_.add(std::chrono::milliseconds(cfg.health_interval_ms), start);
+
+                filters_.reserve(cfg.metrics.size());
+                for (const auto& metric : cfg.metrics) {
+                    filters_.emplace_back(metric.deadband_abs, metric.deadband_pct, std::chrono::milliseconds(metric.max_silence_ms));
+                }
+
+                // aggregated metrics feed the aggregator instead of the queue
+                agg_slot_.assign(cfg.metrics.size(), k_not_aggregated);
+                for (std::size_t i = 0; i < cfg.metrics.size(); ++i) {
+                    const auto& agg = cfg.metrics[i].aggregate;
+                    if (agg.window_ms == 0) continue;
+                    WindowAggregator::Spec spec;
+                    spec.window_ms = static_cast<std::uint32_t>(agg.window_ms);
+                    spec.slide_ms = static_cast<std::uint32_t>(agg.slide_ms);
+                    spec.interval_ms = static_cast<std::uint32_t>(effective_interval_ms(cfg, cfg.metrics[i]));
+                    spec.percentiles = agg.percentiles;
+                    spec.max_samples = static_cast<std::uint32_t>(agg.max_samples);
+                    agg_slot_[i] = aggregator_.add_metric(spec);
+                    (void)scheduler_.add(std::chrono::milliseconds(agg.slide_ms), start + std::chrono::milliseconds(agg.slide_ms));
+                    pane_job_metric_.push_back(static_cast<std::uint32_t>(i));
+                }
+
+                due_.reserve(scheduler_.size());
+
+                // records of the metrics due this tick, per device; reserved once so ticks don't allocate
+                staged_.resize(sensors.devices.size());
+                std::vector<std::size_t> per_device(sensors.devices.size(), 0);
+                for (const auto device : sensors.device_of) ++per_device[device];
+                for (std::size_t d = 0; d < staged_.size(); ++d) staged_[d].reserve(per_device[d]);
+                staged_pos_.assign(cfg.metrics.size(), 0);
+            }
+
+            TimePoint next_deadline() const noexcept { return scheduler_.next_deadline(); }
+
+            // continues from the sampler of the previous config (reload): seq and the suppressed
+            // and overrun counts carry on, and kept metrics (kept_from[i] >= 0) keep their deadband state
+            void adopt(const Sampler& previous, const std::vector<std::int32_t>& kept_from) {
+                seq_ = previous.seq_;
+                suppressed_ = previous.suppressed_;
+                overruns_base_ = previous.overruns_base_ + previous.scheduler_.overruns();
+                for (std::size_t i = 0; i < kept_from.size() && i < filters_.size(); ++i) {
+                    if (kept_from[i] >= 0) filters_[i] = previous.filters_[static_cast<std::size_t>(kept_from[i])];
+                }
+            }
+
+            // samples everything due at `now` and queues the resulting events
+            void run_due(TimePoint now) {
+                due_.clear();
+                scheduler_.collect_due(now, due_);
+                if (due_.empty()) return;
+                // one clock pair per tick; readings carry the steady time their device was read
+                wall_.refresh();
+
+                bool health_due = false;
+                bool sampled = false;
+                bool summarized = false;
+                // close panes first, so a sample taken on a window boundary starts the next window
+                for (const std::size_t job : due_) {
+                    if (job <= health_job_) continue;
+                    const std::uint32_t metric = pane_job_metric_[job - health_job_ - 1];
+                    SampleEvent event;
+                    event.kind = SampleEvent::Kind::Summary;
+                    event.summary = aggregator_.close_pane(agg_slot_[metric]);
+                    if (event.summary.count == 0) continue;
+                    event.reading = PendingReading{metric, event.summary.mean, seq_, wall_.unix_ms(now)};
+                    push_event(queue_, event, counters_);
+                    summarized = true;
+                }
+                for (auto& records : staged_) records.clear();
+                for (const std::size_t job : due_) {
+                    if (job == health_job_) { health_due = true; continue; }
+                    if (job > health_job_) continue;
+                    auto& records = staged_[sensors_.device_of[job]];
+                    staged_pos_[job] = records.size();
+                    records.push_back(SampleRecord{.metric = sensors_.channel_of[job]});
+                }
+                for (std::size_t d = 0; d < staged_.size(); ++d) {
+                    if (staged_[d].empty()) continue;
+                    const LatencyTimer timer(sample_latency_);
+                    sensors_.devices[d]->sample(staged_[d]);
+                }
+
+                for (const std::size_t job : due_) {
+                    if (job >= health_job_) continue;
+                    const auto& record = staged_[sensors_.device_of[job]][staged_pos_[job]];
+                    if (record.status != SampleStatus::Ok) continue;
+                    if (agg_slot_[job] != k_not_aggregated) {
+                        aggregator_.add(agg_slot_[job], record.value);
+                        continue;
+                    }
+                    if (!filters_[job].should_publish(record.value, now)) { ++suppressed_; continue; }
+
+                    SampleEvent event;
+                    event.reading = PendingReading{static_cast<std::uint32_t>(job), record.value, seq_, wall_.unix_ms(record.timestamp_ns)};
+                    push_event(queue_, event, counters_);
+                    sampled = true;
+                }
+                if (sampled) {
+                    SampleEvent event;
+                    event.kind = SampleEvent::Kind::EndTick;
+                    push_event(queue_, event, counters_);
+                }
+                if (health_due) {
+                    SampleEvent event;
+                    event.kind = SampleEvent::Kind::Health;
+                    event.reading.seq = seq_;
+                    counters_.set(Counter::Overruns, overruns_base_ + scheduler_.overruns());
+                    counters_.set(Counter::Suppressed, suppressed_);
+                    push_event(queue_, event, counters_);
+                }
+                if (sampled || summarized || health_due) wakeup_.notify();
+                ++seq_;
+            }
+
+        private:
+            static constexpr std::size_t k_not_aggregated = static_cast<std::size_t>(-1);
+
+            SensorSet& sensors_;
+            SampleQueue& queue_;
+            Wakeup& wakeup_;
+            CounterRegistry& counters_;
+            LatencyHistogram& sample_latency_;
+
+            DeadlineScheduler scheduler_;
+            std::uint64_t overruns_base_ = 0; // overruns of the schedulers before a reload
+            std::size_t health_job_ = 0;
+            std::vector<std::size_t> due_;
+            std::uint64_t seq_ = 0;
+
+            std::vector<DeadbandFilter> filters_;
+            std::uint64_t suppressed_ = 0;
+
+            WindowAggregator aggregator_;
+            std::vector<std::size_t> agg_slot_;
+            std::vector<std::uint32_t> pane_job_metric_;
+
+            std::vector<std::vector<SampleRecord>> staged_;
+            std::vector<std::size_t> staged_pos_;
+            WallClock wall_;
+    };
+
+    // sampler thread of the threaded loop; runs until `running` goes false (shutdown or reload)
+    void sample_loop(Sampler& sampler, Wakeup& wakeup, const std::atomic<bool>& running) {
+        while (running.load(std::memory_order_relaxed)) {
+            const auto now = Sampler::Clock::now();
+            const auto deadline = sampler.next_deadline();
+            if (deadline > now) {
+                std::this_thread::sleep_until(std::min(deadline, now + max_idle_sleep));
+                continue;
+            }
+            sampler.run_due(now);
+        }
+        wakeup.notify();
+    }
+
+    void drain(SampleQueue& queue, std::vector<SampleEvent>& events, TelemetryPublisher& publisher,
+               AppState& state) {
+        state.counters.raise(Counter::QueueDepth, queue.size_approx());
+        for (;;) {
+            const std::size_t count = queue.pop_bulk(events.data(), events.size());
+            if (count == 0) return;
+
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto& event = events[i];
+                switch (event.kind) {
+                    case SampleEvent::Kind::Reading:
+                        publisher.publish_reading(event.reading);
+                        break;
+                    case SampleEvent::Kind::Summary:
+                        publisher.publish_summary(event.reading, event.summary);
+                        break;
+                    case SampleEvent::Kind::EndTick:
+                        publisher.end_tick();
+                        break;
+                    case SampleEvent::Kind::Health:
+                        publisher.publish_health(state.uptime_s(), event.reading.seq, state.counters);
+                        break;
+                }
+            }
+        }
+    }
+
+    // Publisher side (this thread): drains the queue in batches and owns everything MQTT.
+    int run_loop(AppState& state, std::unique_ptr<MqttClient>& mqtt, Shards& shards, AppConfig& cfg, SensorSet& sensors,
+                 const std::string& config_path) {
+        TelemetryPublisher publisher(*mqtt, cfg);
+        publisher.set_shards(shard_clients(shards));
+
+        SampleQueue queue(std::max(min_queue_capacity, cfg.metrics.size() * 64));
+        std::vector<SampleEvent> events(256);
+        Wakeup wakeup;
+
+        auto sampler = std::make_unique<Sampler>(cfg, sensors, queue, wakeup, state.counters, publisher.sample_latency());
+        std::atomic<bool> sampling{true};
+        std::thread sampler_thread([&] { sample_loop(*sampler, wakeup, sampling); });
+
+        TelemetryPublisher::TimePoint next_snapshot{};
+        g_reload.store(false, std::memory_order_relaxed);
         while (g_running.load(std::memory_order_relaxed)) {
-            mqtt.tick();
+            mqtt->tick();
+            for (auto& shard : shards) shard->tick();
+            const auto now = TelemetryPublisher::Clock::now();
+            publisher.service(now);
+            if (cfg.metrics_endpoint.enabled && now >= next_snapshot) {
+                publisher.snapshot(state.snapshot);
+                next_snapshot = now + snapshot_period;
+            }
+
+            (void)wakeup.wait_for(max_idle_sleep);
+            drain(queue, events, publisher, state);
+
+            if (!g_reload.exchange(false, std::memory_order_relaxed)) continue;
+            ConfigDiff diff;
+            auto next = read_reload(config_path, cfg, diff);
+            if (!next) continue;
+            // the sampler thread reads the sensors; pause it while they are swapped
+            if (diff.schedule) {
+                sampling.store(false, std::memory_order_relaxed);
+                sampler_thread.join();
+                drain(queue, events, publisher, state);
+            }
+            try {
+                apply_reload(cfg, std::move(*next), diff, sensors, publisher, mqtt, shards, state.counters);
+                if (diff.schedule) {
+                    auto fresh = std::make_unique<Sampler>(cfg, sensors, queue, wakeup, state.counters, publisher.sample_latency());
+                    fresh->adopt(*sampler, diff.kept_from);
+                    sampler = std::move(fresh);
+                }
+            } catch (const std::exception& e) {
+                LOG_ERROR(std::string("Reload failed, keeping the running config: ") + e.what());
+            }
+            if (diff.schedule) {
+                sampling.store(true, std::memory_order_relaxed);
+                sampler_thread = std::thread([&] { sample_loop(*sampler, wakeup, sampling); });
+            }
+        }
+
+        sampling.store(false, std::memory_order_relaxed);
+        sampler_thread.join();
+        drain(queue, events, publisher, state);
+        publisher.flush();
+        return EXIT_SUCCESS;
+    }
+
+    // keepalive pings are checked at least this often by the epoll loop
+    constexpr auto keepalive_check_period = std::chrono::seconds(1);
+
+    // event_loop: "epoll". One thread and one epoll set: the broker socket (no mosquitto network
+    // thread), a timerfd at the sampler's next deadline, a timerfd for reconnect backoff, keepalive
+    // and replay pacing, and a signalfd. MQTT callbacks, sampling and publishing all run here, so
+    // connection state is never shared across threads.
+    int run_epoll_loop(AppState& state, std::unique_ptr<MqttClient>& mqtt, AppConfig& cfg, SensorSet& sensors,
+                       SignalFd& signals, const std::string& config_path) {
+        TelemetryPublisher publisher(*mqtt, cfg);
+
+        // sampler and publisher share this thread; the queue only carries one tick's events
+        SampleQueue queue(std::max(min_queue_capacity, cfg.metrics.size() * 64));
+        std::vector<SampleEvent> events(256);
+        Wakeup wakeup; // nobody waits on it here
+        auto sampler = std::make_unique<Sampler>(cfg, sensors, queue, wakeup, state.counters, publisher.sample_latency());
+
+        EventLoop loop;
+        TimerFd sample_timer;
+        TimerFd mqtt_timer;
+
+        loop.watch(sample_timer.fd(), EPOLLIN, [&](std::uint32_t) {
+            sample_timer.consume();
+            sampler->run_due(Sampler::Clock::now());
+            drain(queue, events, publisher, state);
+        });
+        loop.watch(mqtt_timer.fd(), EPOLLIN, [&](std::uint32_t) {
+            mqtt_timer.consume();
+            mqtt->tick();
+            mqtt->service_io(false, false);
+        });
+        bool reload = false;
+        loop.watch(signals.fd(), EPOLLIN, [&](std::uint32_t) {
+            while (const auto signo = signals.next()) {
+                if (*signo == SIGHUP) {
+                    reload = true;
+                    continue;
+                }
+                g_running.store(false, std::memory_order_relaxed);
+            }
+        });
+
+        // the broker socket changes on every reconnect; a reconnect may also reuse the fd number
+        int mqtt_fd = -1;
+        bool mqtt_want_write = false;
+        std::uint64_t mqtt_reconnects = mqtt->reconnects();
+        const auto sync_socket = [&] {
+            const int fd = mqtt->socket();
+            const bool want_write = fd >= 0 && mqtt->want_write();
+            const std::uint32_t mask = EPOLLIN | (want_write ? EPOLLOUT : 0u);
+            if (fd != mqtt_fd || mqtt->reconnects() != mqtt_reconnects) {
+                if (mqtt_fd >= 0) loop.unwatch(mqtt_fd);
+                if (fd >= 0) {
+                    loop.watch(fd, mask, [&](std::uint32_t ready) {
+                        mqtt->service_io(ready & (EPOLLIN | EPOLLHUP | EPOLLERR), ready & EPOLLOUT);
+                    });
+                }
+            } else if (fd >= 0 && want_write != mqtt_want_write) {
+                loop.modify(fd, mask);
+            }
+            mqtt_fd = fd;
+            mqtt_want_write = want_write;
+            mqtt_reconnects = mqtt->reconnects();
+        };
 
-            for (auto& entry : sensors) {
-                auto reading = entry.sensor->sample();
-                if (!reading) continue;
+        const auto reload_config = [&] {
+            ConfigDiff diff;
+            auto next = read_reload(config_path, cfg, diff);
+            if (!next) return;
+            drain(queue, events, publisher, state);
+            try {
+                MqttClient* const previous_client = mqtt.get();
+                Shards no_shards; // broker.connections > 1 needs the threads event loop
+                apply_reload(cfg, std::move(*next), diff, sensors, publisher, mqtt, no_shards, state.counters);
+                if (diff.schedule) {
+                    auto fresh = std::make_unique<Sampler>(cfg, sensors, queue, wakeup, state.counters, publisher.sample_latency());
+                    fresh->adopt(*sampler, diff.kept_from);
+                    sampler = std::move(fresh);
+                }
+                // the old socket is closed; the new client may reuse its fd number
+                if (mqtt.get() != previous_client && mqtt_fd >= 0) {
+                    loop.unwatch(mqtt_fd);
+                    mqtt_fd = -1;
+                }
+            } catch (const std::exception& e) {
+                LOG_ERROR(std::string("Reload failed, keeping the running config: ") + e.what());
+            }
+        };
 
-                auto payload = make_payload_v1(cfg.client_id,
-                                            reading->metric_name,
-                                            reading->unit,
-                                            reading->value,
-                                            seq);
-                
-                const bool ok = mqtt.publish(entry.topic, payload.dump(), cfg.qos, cfg.retain);
-                if (ok) ++state.publish_ok;
-                else { ++state.publish_fail; LOG_DEBUG("Failed to publish topic: " + entry.topic); }
+        TelemetryPublisher::TimePoint next_snapshot{};
+        while (g_running.load(std::memory_order_relaxed)) {
+            if (reload) {
+                reload = false;
+                reload_config();
+            }
+            const auto now = TelemetryPublisher::Clock::now();
+            publisher.service(now);
+            // the mqtt timer wakes this loop at least every keepalive_check_period
+            if (cfg.metrics_endpoint.enabled && now >= next_snapshot) {
+                publisher.snapshot(state.snapshot);
+                next_snapshot = now + snapshot_period;
             }
+            sync_socket();
 
-            if ((seq % health_every) == 0) publish_health(mqtt, health_topic, cfg, state, seq);
-            ++seq;
-            std::this_thread::sleep_for(std::chrono::milliseconds(cfg.interval_ms));
+            sample_timer.arm_at(sampler->next_deadline());
+            const auto housekeeping = publisher.backlogged() ? now + max_idle_sleep : now + keepalive_check_period;
+            mqtt_timer.arm_at(std::min(mqtt->reconnect_due(), housekeeping));
+            loop.run_once(-1);
         }
+
+        drain(queue, events, publisher, state);
+        publisher.flush();
         return EXIT_SUCCESS;
     }
 } // namespace
@@ -208,6 +814,9 @@ namespace {
 int main(int argc, char** argv) {
     std::signal(SIGINT, handle_signal);
     std::signal(SIGTERM, handle_signal);
+    // installed now so a reload during startup does not terminate the daemon; run_loop
+    // discards it, since the config it would re-read has only just been loaded
+    std::signal(SIGHUP, handle_reload);
 
     const auto cli = parse_cli(argc, argv);
 
@@ -225,25 +834,47 @@ int main(int argc, char** argv) {
             return EXIT_SUCCESS;
         }
         configure_logging_from_config(cfg);
+        // blocked before any thread starts, so only the signalfd sees them
+        std::unique_ptr<SignalFd> signals;
+        if (cfg.epoll_loop && cli.fleet_devices.empty()) {
+            signals = std::make_unique<SignalFd>(std::initializer_list<int>{SIGINT, SIGTERM, SIGHUP});
+        }
+        logger::AsyncGuard async_logging; // declared before the MQTT, sensor and endpoint objects below, so it outlives them and flushes last
         LOG_INFO("PID: " + std::to_string(getpid()));
         LOG_INFO("Starting embedded telemetry daemon");
         log_config_summary(cfg);
 
         MosquittoLibGuard mosq_guard;
 
+        if (!cli.fleet_devices.empty()) {
+            std::signal(SIGHUP, SIG_IGN); // fleet mode has no reload
+            const int rc = run_fleet(cfg, parse_fleet_devices(cli.fleet_devices), g_running);
+            LOG_INFO("Shutting down...");
+            return rc;
+        }
+
         auto sensors = build_sensors(cfg);
 
-        MqttClient mqtt(cfg.host, cfg.port, cfg.client_id, cfg.qos);
+        AppState state;
+        std::optional<MetricsEndpoint> metrics_endpoint;
+        if (cfg.metrics_endpoint.enabled) metrics_endpoint.emplace(cfg.metrics_endpoint, state.snapshot, state.counters, state.start);
+        // replaced by a reload that changes the broker settings
+        auto mqtt = make_mqtt_client(cfg, state.counters);
         LOG_INFO("Connecting MQTT...");
-        if (!mqtt.connect(cfg.keepalive_s)) {
+        if (!mqtt->connect(cfg.keepalive_s, !cfg.epoll_loop)) {
             LOG_ERROR("MQTT connect failed");
             return EXIT_FAILURE;
         }
+        auto shards = connect_shards(cfg, state.counters);
 
-        const int rc = run_loop(mqtt, cfg, sensors);
+        const int rc = cfg.epoll_loop ? run_epoll_loop(state, mqtt, cfg, sensors, *signals, cli.config_path)
+                                      : run_loop(state, mqtt, shards, cfg, sensors, cli.config_path);
 
         LOG_INFO("Shutting down...");
-        mqtt.stop();
+        // shards first, so the primary's "offline" status is the last word
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(cfg.drain_timeout_ms);
+        for (auto& shard : shards) close_client(*shard, deadline);
+        close_client(*mqtt, deadline);
         return rc;
 
     } catch (const std::exception& e) {
@@ -0,0 +1,313 @@
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "metrics_endpoint.h"
+
+namespace {
+
+    constexpr std::size_t k_max_clients = 8;
+    constexpr std::size_t k_max_request = 8192;
+    constexpr auto k_client_timeout = std::chrono::seconds(5);
+    constexpr int k_poll_timeout_ms = 1000;
+
+    constexpr std::string_view k_content_type = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+    void append_uint(std::string& out, std::uint64_t value) {
+        char buf[24];
+        const auto res = std::to_chars(buf, buf + sizeof(buf), value);
+        out.append(buf, res.ptr);
+    }
+
+    // exact decimal seconds of a microsecond count ("0.000015", "3", "1.5")
+    void append_us_as_seconds(std::string& out, std::uint64_t us) {
+        append_uint(out, us / 1000000);
+        std::uint64_t frac = us % 1000000;
+        if (frac == 0) return;
+        char digits[7] = "000000";
+        for (int i = 5; i >= 0; --i, frac /= 10) digits[i] = static_cast<char>('0' + frac % 10);
+        int len = 6;
+        while (digits[len - 1] == '0') --len;
+        out.push_back('.');
+        out.append(digits, static_cast<std::size_t>(len));
+    }
+
+    void append_header(std::string& out, std::string_view name, std::string_view type, std::string_view help) {
+        out.append("# TYPE ").append(name).push_back(' ');
+        out.append(type).push_back('\n');
+        out.append("# HELP ").append(name).push_back(' ');
+        out.append(help).push_back('\n');
+    }
+
+    void append_counter(std::string& out, std::string_view name, std::string_view help, std::uint64_t value) {
+        append_header(out, name, "counter", help);
+        out.append(name).append("_total ");
+        append_uint(out, value);
+        out.push_back('\n');
+    }
+
+    void append_gauge(std::string& out, std::string_view name, std::string_view help, std::uint64_t value) {
+        append_header(out, name, "gauge", help);
+        out.append(name).push_back(' ');
+        append_uint(out, value);
+        out.push_back('\n');
+    }
+
+    void append_seconds_counter(std::string& out, std::string_view name, std::string_view help, std::uint64_t us) {
+        append_header(out, name, "counter", help);
+        out.append(name).append("_total ");
+        append_us_as_seconds(out, us);
+        out.push_back('\n');
+    }
+
+    struct StageName {
+        MetricsSnapshot::Stage stage;
+        std::string_view label;
+    };
+
+    constexpr StageName k_stages[] = {
+        {MetricsSnapshot::Stage::Ack, "ack"},
+        {MetricsSnapshot::Stage::Publish, "publish"},
+        {MetricsSnapshot::Stage::Sample, "sample"},
+        {MetricsSnapshot::Stage::Serialize, "serialize"},
+    };
+
+    // cumulative buckets at every power of two (the histogram's exact sub-bucket boundaries),
+    // so the bucket set is the same on every scrape
+    void append_latency(std::string& out, const MetricsSnapshot& snapshot) {
+        constexpr std::string_view name = "telemetry_latency_seconds";
+        append_header(out, name, "histogram", "Per-stage latency: sample, serialize, publish (inside mosquitto_publish), ack (QoS > 0).");
+        LatencyHistogram::Counts counts;
+        for (const auto& stage : k_stages) {
+            snapshot.latency(stage.stage, counts);
+            std::uint64_t cumulative = 0;
+            for (std::size_t i = 0; i < counts.size(); ++i) {
+                cumulative += counts[i];
+                if (i % LatencyHistogram::k_sub_buckets != LatencyHistogram::k_sub_buckets - 1) continue;
+                out.append(name).append("_bucket{stage=\"").append(stage.label).append("\",le=\"");
+                append_us_as_seconds(out, LatencyHistogram::upper_bound_of(i));
+                out.append("\"} ");
+                append_uint(out, cumulative);
+                out.push_back('\n');
+            }
+            out.append(name).append("_bucket{stage=\"").append(stage.label).append("\",le=\"+Inf\"} ");
+            append_uint(out, cumulative);
+            out.push_back('\n');
+        }
+    }
+
+    struct Client {
+        int fd = -1;
+        std::string in;
+        std::string out;
+        std::size_t sent = 0;
+        std::chrono::steady_clock::time_point deadline;
+    };
+
+    // the path comes from the config and the daemon often runs as root: only ever remove a socket
+    bool is_socket(const std::string& path) {
+        struct stat st{};
+        return ::lstat(path.c_str(), &st) == 0 && S_ISSOCK(st.st_mode);
+    }
+
+    int bind_unix(const std::string& path) {
+        sockaddr_un addr{};
+        if (path.size() >= sizeof(addr.sun_path)) throw std::runtime_error("metrics_endpoint socket path too long: " + path);
+        addr.sun_family = AF_UNIX;
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+        struct stat st{};
+        if (::lstat(path.c_str(), &st) == 0) {
+            if (!S_ISSOCK(st.st_mode)) throw std::runtime_error("metrics_endpoint path exists and is not a socket: " + path);
+            ::unlink(path.c_str()); // stale socket from a previous run
+        }
+
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) throw std::runtime_error("metrics_endpoint socket() failed");
+        if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            const int err = errno;
+            ::close(fd);
+            throw std::runtime_error("metrics_endpoint bind(" + path + ") failed: " + std::strerror(err));
+        }
+        return fd;
+    }
+
+    int bind_loopback(int port) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<std::uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) throw std::runtime_error("metrics_endpoint socket() failed");
+        const int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (::bind(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            const int err = errno;
+            ::close(fd);
+            throw std::runtime_error("metrics_endpoint bind(127.0.0.1:" + std::to_string(port) + ") failed: " + std::strerror(err));
+        }
+        return fd;
+    }
+
+} // namespace
+
+std::string render_openmetrics(const MetricsSnapshot& snapshot, const CounterRegistry& registry,
+                               const ProcessStats& process, std::uint64_t uptime_s) {
+    const auto counters = snapshot.counters();
+    std::string out;
+    out.reserve(16384);
+
+    append_gauge(out, "telemetry_uptime_seconds", "Seconds since the daemon started.", uptime_s);
+    append_gauge(out, "telemetry_connected", "1 while the broker session is up.", snapshot.connected() ? 1 : 0);
+    append_counter(out, "telemetry_publish_ok", "Messages acked by the broker (QoS 1/2) or written to the socket (QoS 0).", counters.publish_ok);
+    append_counter(out, "telemetry_publish_fail", "Publishes the broker connection did not take.", counters.publish_fail);
+    append_counter(out, "telemetry_backpressure", "Publishes deferred because the in-flight window was full.", counters.backpressure);
+    append_counter(out, "telemetry_reconnects", "Broker reconnect attempts.", counters.reconnects);
+    append_gauge(out, "telemetry_inflight", "QoS > 0 messages awaiting their ack.", counters.inflight);
+    append_gauge(out, "telemetry_buffered", "Readings waiting for the broker (store-and-forward or spool).", counters.buffered);
+    append_counter(out, "telemetry_dropped", "Readings lost to buffer overflow.", counters.dropped);
+    append_counter(out, "telemetry_replayed", "Buffered readings published after a reconnect.", counters.replayed);
+    append_counter(out, "telemetry_compress_in_bytes", "Payload bytes before compression.", counters.compress_in_bytes);
+    append_counter(out, "telemetry_compress_out_bytes", "Payload bytes after compression.", counters.compress_out_bytes);
+    append_seconds_counter(out, "telemetry_compress_cpu_seconds", "Thread CPU time spent compressing.", counters.compress_cpu_us);
+
+    append_counter(out, "telemetry_sent_bytes", "Payload bytes handed to the broker connection.", registry.value(Counter::BytesSent));
+    append_counter(out, "telemetry_overruns", "Scheduler ticks that missed their deadline.", registry.value(Counter::Overruns));
+    append_counter(out, "telemetry_queue_dropped", "Samples lost because the publisher fell behind.", registry.value(Counter::QueueDropped));
+    append_counter(out, "telemetry_suppressed", "Readings held back by deadband filters.", registry.value(Counter::Suppressed));
+    append_gauge(out, "telemetry_queue_depth", "Sampler queue high-water mark since the last health message.", registry.value(Counter::QueueDepth));
+
+    append_seconds_counter(out, "telemetry_process_cpu_user_seconds", "User CPU time of all threads.", process.cpu_user_us);
+    append_seconds_counter(out, "telemetry_process_cpu_system_seconds", "System CPU time of all threads.", process.cpu_sys_us);
+    append_counter(out, "telemetry_process_voluntary_context_switches", "Context switches while waiting.", process.ctx_voluntary);
+    append_counter(out, "telemetry_process_involuntary_context_switches", "Context switches by preemption.", process.ctx_involuntary);
+    append_gauge(out, "telemetry_process_resident_memory_bytes", "Resident set size.", process.rss_kb * 1024);
+
+    append_latency(out, snapshot);
+    out.append("# EOF\n");
+    return out;
+}
+
+MetricsEndpoint::MetricsEndpoint(const MetricsEndpointConfig& cfg, const MetricsSnapshot& snapshot,
+                                 const CounterRegistry& registry, TimePoint start)
+    : snapshot_(snapshot), registry_(registry), start_(start) {
+    listen_fd_ = cfg.unix_path.empty() ? bind_loopback(cfg.port) : bind_unix(cfg.unix_path);
+    if (!cfg.unix_path.empty()) unix_path_ = cfg.unix_path;
+    if (::listen(listen_fd_, 16) != 0) {
+        ::close(listen_fd_);
+        throw std::runtime_error("metrics_endpoint listen() failed");
+    }
+    stop_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stop_fd_ < 0) {
+        ::close(listen_fd_);
+        throw std::runtime_error("metrics_endpoint eventfd() failed");
+    }
+    thread_ = std::thread([this] { run_(); });
+    LOG_INFO("Metrics endpoint listening on " + cfg.listen);
+}
+
+MetricsEndpoint::~MetricsEndpoint() {
+    const std::uint64_t one = 1;
+    (void)!::write(stop_fd_, &one, sizeof(one));
+    if (thread_.joinable()) thread_.join();
+    ::close(stop_fd_);
+    ::close(listen_fd_);
+    if (!unix_path_.empty() && is_socket(unix_path_)) ::unlink(unix_path_.c_str());
+}
+
+std::string MetricsEndpoint::respond_(std::string_view request) {
+    const auto line = request.substr(0, request.find_first_of("\r\n"));
+    const auto status = [](std::string_view code, std::string_view type, std::string_view body) {
+        std::string out = "HTTP/1.1 ";
+        out.append(code).append("\r\nContent-Type: ").append(type).append("\r\nContent-Length: ");
+        append_uint(out, body.size());
+        out.append("\r\nConnection: close\r\n\r\n").append(body);
+        return out;
+    };
+
+    if (!line.starts_with("GET ")) return status("405 Method Not Allowed", "text/plain", "GET only\n");
+    auto path = line.substr(4, line.find(' ', 4) - 4);
+    if (path != "/metrics" && path != "/") return status("404 Not Found", "text/plain", "try /metrics\n");
+
+    scrapes_.fetch_add(1, std::memory_order_relaxed);
+    const auto uptime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start_).count();
+    const auto body = render_openmetrics(snapshot_, registry_, process_stats_.read(), static_cast<std::uint64_t>(uptime));
+    return status("200 OK", k_content_type, body);
+}
+
+void MetricsEndpoint::run_() {
+    std::vector<Client> clients;
+    std::vector<pollfd> fds;
+    char buf[2048];
+
+    for (;;) {
+        fds.clear();
+        fds.push_back(pollfd{stop_fd_, POLLIN, 0});
+        fds.push_back(pollfd{listen_fd_, static_cast<short>(clients.size() < k_max_clients ? POLLIN : 0), 0});
+        for (const auto& client : clients) {
+            fds.push_back(pollfd{client.fd, static_cast<short>(client.out.empty() ? POLLIN : POLLOUT), 0});
+        }
+
+        const int ready = ::poll(fds.data(), fds.size(), k_poll_timeout_ms);
+        if (ready < 0 && errno != EINTR) break;
+        if (fds[0].revents & POLLIN) break;
+
+        const auto now = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < clients.size(); ++i) {
+            auto& client = clients[i];
+            const auto revents = fds[i + 2].revents;
+            bool done = now >= client.deadline || (revents & (POLLERR | POLLNVAL));
+
+            if (!done && (revents & (POLLIN | POLLHUP)) && client.out.empty()) {
+                const ssize_t n = ::recv(client.fd, buf, sizeof(buf), 0);
+                if (n > 0) {
+                    client.in.append(buf, static_cast<std::size_t>(n));
+                    if (client.in.find("\r\n\r\n") != std::string::npos || client.in.find("\n\n") != std::string::npos) {
+                        client.out = respond_(client.in);
+                    } else if (client.in.size() > k_max_request) {
+                        done = true;
+                    }
+                } else if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+                    done = true;
+                }
+            }
+            if (!done && !client.out.empty()) {
+                const ssize_t n = ::send(client.fd, client.out.data() + client.sent, client.out.size() - client.sent, MSG_NOSIGNAL);
+                if (n > 0) client.sent += static_cast<std::size_t>(n);
+                else if (n < 0 && errno != EAGAIN && errno != EINTR) done = true;
+                if (client.sent == client.out.size()) done = true;
+            }
+            if (done) {
+                ::close(client.fd);
+                client.fd = -1;
+            }
+        }
+        clients.erase(std::remove_if(clients.begin(), clients.end(), [](const Client& c) { return c.fd < 0; }), clients.end());
+
+        if (fds[1].revents & POLLIN) {
+            while (clients.size() < k_max_clients) {
+                const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if (fd < 0) break;
+                clients.push_back(Client{fd, {}, {}, 0, now + k_client_timeout});
+            }
+        }
+    }
+
+    for (const auto& client : clients) ::close(client.fd);
+}
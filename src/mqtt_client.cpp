@@ -5,17 +5,21 @@
 #include <thread>
 #include <algorithm>
 #include <random>
+#include <poll.h>
 
 #include "mqtt_client.h"
 #include "logger.h"
 #include "topic_builder.h"
-#include "status_payload.h"
+#include "time_utils.h"
 
-MqttClient::MqttClient(std::string host, int port, std::string client_id, int qos) 
+MqttClient::MqttClient(std::string host, int port, std::string client_id, int qos, std::string telemetry_content_type,
+                       Mqtt5Options v5)
     : host_(std::move(host)), 
       port_(port), 
       client_id_(std::move(client_id)), 
+      telemetry_content_type_(std::move(telemetry_content_type)),
       qos_(qos),
+      v5_(std::move(v5)),
       rng_(std::random_device{}())
     {
 
@@ -26,9 +30,19 @@ MqttClient::MqttClient(std::string host, int port, std::string client_id, int qo
             return;
         }
 
+        if (v5_.enabled) {
+            const int rc = mosquitto_int_option(mosq_, MOSQ_OPT_PROTOCOL_VERSION, MQTT_PROTOCOL_V5);
+            if (rc != MOSQ_ERR_SUCCESS) {
+                LOG_WARN(std::string("MQTT 5 not available, using 3.1.1: ") + mosquitto_strerror(rc));
+                v5_.enabled = false;
+            }
+        }
+
         // Call backs
-        mosquitto_connect_callback_set(mosq_, &MqttClient::on_connect);
+        if (v5_.enabled) mosquitto_connect_v5_callback_set(mosq_, &MqttClient::on_connect_v5);
+        else mosquitto_connect_callback_set(mosq_, &MqttClient::on_connect);
         mosquitto_disconnect_callback_set(mosq_, &MqttClient::on_disconnect);
+        mosquitto_publish_callback_set(mosq_, &MqttClient::on_publish);
 
         // LWT
         setup_lwt_();
@@ -57,39 +71,145 @@ void MqttClient::on_connect(struct mosquitto* /*mosq*/, void* obj, int rc) {
         self->reconnect_in_flight_.store(false, std::memory_order_relaxed);
         self->reconnect_started_ticks_.store(0, std::memory_order_relaxed);
         self->backoff_.reset();
+        if (self->selector_) self->failover_connected_(self->now_fn_());
 
-        LOG_INFO("Connected to broker");
+        LOG_INFO("Connected to broker " + self->broker());
         // mark online (retained)
-        self->publish_status_(self->online_payload_);
+        self->publish_status_(self->online_status_.write("online", unix_time_s()));
     } else {
         self->connected_.store(false, std::memory_order_relaxed);
-        LOG_ERROR("Connect failed rc=" + std::to_string(rc));
+        LOG_ERROR("Connect to " + self->broker() + " failed rc=" + std::to_string(rc));
+        if (self->selector_) self->failover_failed_(self->now_fn_());
+    }
+}
+
+void MqttClient::on_connect_v5(struct mosquitto* mosq, void* obj, int rc, int /*flags*/, const mosquitto_property* props) {
+    auto* self = static_cast<MqttClient*>(obj);
+
+    // aliases are per connection; absent Topic Alias Maximum means the broker accepts none
+    std::uint16_t alias_max = 0;
+    if (rc == 0 && self->v5_.topic_aliases) {
+        mosquitto_property_read_int16(props, MQTT_PROP_TOPIC_ALIAS_MAXIMUM, &alias_max, false);
     }
+    self->alias_max_.store(alias_max, std::memory_order_relaxed);
+    self->alias_generation_.fetch_add(1, std::memory_order_release);
+    if (rc == 0) LOG_DEBUG("Broker topic alias maximum: " + std::to_string(alias_max));
+
+    on_connect(mosq, obj, rc);
 }
 
 void MqttClient::on_disconnect(struct mosquitto* /*mosq*/, void* obj, int rc) {
     auto* self = static_cast<MqttClient*>(obj);
 
     self->connected_.store(false, std::memory_order_relaxed);
+    self->window_.reset(); // acks of the lost session may never come
     self->reconnect_in_flight_.store(false, std::memory_order_relaxed);
     self->reconnect_started_ticks_.store(0, std::memory_order_relaxed);
+    self->alias_max_.store(0, std::memory_order_relaxed);
+    self->alias_generation_.fetch_add(1, std::memory_order_release);
 
     if (self->stopping_.load(std::memory_order_relaxed)) {
         LOG_INFO("Disconnected cleanly rc=" + std::to_string(rc));
     } else {
         LOG_WARN("Disconnect rc=" + std::to_string(rc) + " (will reconnect)");
+        if (self->selector_) self->failover_failed_(self->now_fn_());
     }
 }
 
-bool MqttClient::connect(int keepalive_seconds) {
-    if (!has_mosq_()) return false;
+// QoS 1/2 ack (QoS 0: written to the socket); network thread
+void MqttClient::on_publish(struct mosquitto* /*mosq*/, void* obj, int mid) {
+    auto* self = static_cast<MqttClient*>(obj);
+    if (const auto rtt = self->ack_timer_.on_acked(mid, AckTimer::Clock::now())) self->ack_latency_.record(*rtt);
+    self->window_.on_complete(mid);
+}
 
-    int rc = mosquitto_connect_async(mosq_, host_.c_str(), port_, keepalive_seconds);
+void MqttClient::set_brokers(std::vector<BrokerEndpoint> endpoints, FailoverOptions opts) {
+    std::lock_guard<std::mutex> lock(failover_mutex_);
+    selector_ = std::make_unique<BrokerSelector>(std::move(endpoints), opts);
+    reconnect_timeout_ = opts.connect_timeout;
+}
+
+std::string MqttClient::broker() const {
+    std::lock_guard<std::mutex> lock(failover_mutex_);
+    if (!selector_) return host_ + ":" + std::to_string(port_);
+    const auto& endpoint = selector_->endpoint(attempt_index_);
+    return endpoint.host + ":" + std::to_string(endpoint.port);
+}
+
+void MqttClient::compact_tracking() {
+    const auto max_inflight = window_.max();
+    if (max_inflight == 0) return;
+    // waiting mids lie within a few windows of the newest one (status, QoS 0 and resent messages
+    // take mids too); the window never goes below InflightWindow::k_min_slots
+    window_.resize(max_inflight * 64);
+    ack_timer_.resize(max_inflight * 4);
+}
+
+void MqttClient::disable_status() noexcept {
+    status_enabled_ = false;
+    if (mosq_) mosquitto_will_clear(mosq_);
+}
+
+int MqttClient::connect_endpoint_(std::size_t index) {
+    const auto& endpoint = selector_->endpoint(index);
+    return mosquitto_connect_async(mosq_, endpoint.host.c_str(), endpoint.port, keepalive_s_);
+}
+
+bool MqttClient::begin_attempt_(TimePoint now) {
+    std::lock_guard<std::mutex> lock(failover_mutex_);
+    const auto index = selector_->pick(now);
+    if (!selector_->ready(index, now)) return false;
+    if (index != attempt_index_) {
+        const auto& endpoint = selector_->endpoint(index);
+        LOG_WARN("Failing over to broker " + endpoint.host + ":" + std::to_string(endpoint.port));
+    }
+    attempt_index_ = index;
+    attempt_open_ = true;
+    attempt_started_ = now;
+    return true;
+}
+
+void MqttClient::failover_connected_(TimePoint now) {
+    std::lock_guard<std::mutex> lock(failover_mutex_);
+    const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(now - attempt_started_);
+    selector_->on_connected(attempt_index_, std::max(latency, std::chrono::microseconds::zero()));
+    session_started_ = now;
+}
+
+// once per attempt or session: a failed CONNACK is followed by a disconnect
+void MqttClient::failover_failed_(TimePoint now) {
+    std::lock_guard<std::mutex> lock(failover_mutex_);
+    if (!attempt_open_) return;
+    attempt_open_ = false;
+    selector_->on_failed(attempt_index_, now);
+}
+
+bool MqttClient::connect(int keepalive_seconds, bool start_network_thread) {
+    if (!has_mosq_()) return false;
+    keepalive_s_ = keepalive_seconds;
+
+    int rc = MOSQ_ERR_NO_CONN;
+    if (selector_) {
+        // every endpoint once, in preference order, until one accepts the attempt
+        const auto now = now_fn_();
+        for (std::size_t i = 0; i < selector_->size() && rc != MOSQ_ERR_SUCCESS; ++i) {
+            if (!begin_attempt_(now)) break;
+            rc = reconnect_fn_();
+            if (rc != MOSQ_ERR_SUCCESS) {
+                LOG_ERROR("mosquitto_connect_async " + broker() + " error: " + mosquitto_strerror(rc));
+                failover_failed_(now);
+            }
+        }
+    } else {
+        rc = mosquitto_connect_async(mosq_, host_.c_str(), port_, keepalive_seconds);
+    }
     if (rc != MOSQ_ERR_SUCCESS) {
         LOG_ERROR(std::string("mosquitto_connect_async error: ") + mosquitto_strerror(rc));
         return false;
     }
 
+    if (!start_network_thread) return true;
+
     bool expected = false;
     if (loop_started_.compare_exchange_strong(expected, true, std::memory_order_relaxed)) {
         rc = mosquitto_loop_start(mosq_);
@@ -103,7 +223,95 @@ bool MqttClient::connect(int keepalive_seconds) {
     return true;
 }
 
-void MqttClient::tick() { tick_reconnect_(); }
+void MqttClient::tick() {
+    tick_failback_();
+    tick_reconnect_();
+}
+
+// Priority policy: once connected long enough, move back to a preferred broker that is out of
+// cooldown. A TCP probe checks it first, so the live session stays up while it is still down; a
+// failed probe puts it back on cooldown. The switch is then a fresh connect_async on the same
+// handle; until its CONNACK publishes are buffered as during any reconnect, and a failure fails
+// over again.
+void MqttClient::tick_failback_() {
+    if (!selector_ || stopping_.load(std::memory_order_relaxed)) return;
+
+    const auto now = now_fn_();
+    std::size_t target = BrokerSelector::npos;
+    BrokerEndpoint endpoint;
+    if (connected_.load(std::memory_order_relaxed) && has_mosq_()) {
+        std::lock_guard<std::mutex> lock(failover_mutex_);
+        target = selector_->fail_back_target(attempt_index_, session_started_, now);
+        if (target != BrokerSelector::npos) endpoint = selector_->endpoint(target);
+    }
+    if (target != probe_target_) {
+        probe_.cancel();
+        probe_target_ = target;
+    }
+    if (target == BrokerSelector::npos) return;
+
+    const auto probe = probe_fn_(endpoint, now);
+    if (probe == TcpProbe::Result::Pending) return;
+    probe_target_ = BrokerSelector::npos;
+    if (probe == TcpProbe::Result::Failed) {
+        LOG_DEBUG("Preferred broker " + endpoint.host + ":" + std::to_string(endpoint.port) + " still unreachable");
+        std::lock_guard<std::mutex> lock(failover_mutex_);
+        selector_->on_failed(target, now);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(failover_mutex_);
+        LOG_INFO("Failing back to preferred broker " + endpoint.host + ":" + std::to_string(endpoint.port));
+        attempt_index_ = target;
+        attempt_open_ = true;
+        attempt_started_ = now;
+    }
+
+    connected_.store(false, std::memory_order_relaxed);
+    const int rc = reconnect_fn_();
+    if (rc == MOSQ_ERR_SUCCESS) {
+        reconnects_.fetch_add(1, std::memory_order_relaxed);
+        reconnect_started_ticks_.store(to_ticks_(now), std::memory_order_relaxed);
+        reconnect_in_flight_.store(true, std::memory_order_relaxed);
+    } else {
+        LOG_ERROR("Fail back to " + broker() + " error: " + mosquitto_strerror(rc));
+        failover_failed_(now);
+    }
+}
+
+void MqttClient::service_io(bool readable, bool writable) noexcept {
+    if (!mosq_) return;
+    // errors surface through on_disconnect; tick() reconnects
+    if (readable) mosquitto_loop_read(mosq_, 1);
+    if (writable) mosquitto_loop_write(mosq_, 1);
+    mosquitto_loop_misc(mosq_);
+}
+
+TimePoint MqttClient::reconnect_due() const noexcept {
+    if (stopping_.load(std::memory_order_relaxed) || connected_.load(std::memory_order_relaxed)) return TimePoint::max();
+    if (reconnect_in_flight_.load(std::memory_order_relaxed)) {
+        const int64_t started_ticks = reconnect_started_ticks_.load(std::memory_order_relaxed);
+        if (started_ticks == 0) return now_fn_();
+        return TimePoint{TimePoint::duration{started_ticks}} + reconnect_timeout_;
+    }
+    if (selector_) {
+        std::lock_guard<std::mutex> lock(failover_mutex_);
+        return selector_->retry_at(selector_->pick(now_fn_()));
+    }
+    return backoff_.next_time();
+}
+
+void MqttClient::wait_io_(std::chrono::milliseconds timeout) noexcept {
+    const int fd = socket();
+    if (loop_started_.load(std::memory_order_relaxed) || fd < 0) {
+        std::this_thread::sleep_for(timeout);
+        return;
+    }
+    pollfd pfd{fd, static_cast<short>(POLLIN | (want_write() ? POLLOUT : 0)), 0};
+    if (::poll(&pfd, 1, static_cast<int>(timeout.count())) < 0) return;
+    service_io(pfd.revents & (POLLIN | POLLHUP | POLLERR), pfd.revents & POLLOUT);
+}
 
 void MqttClient::tick_reconnect_() {
     if (stopping_.load(std::memory_order_relaxed)) return;
@@ -115,11 +323,17 @@ void MqttClient::tick_reconnect_() {
     // if attempt is stuck, clear in-flight so we can try again
     if (in_flight_timed_out_(now)) { 
         LOG_WARN("Reconnect attempt timed out. Allowing another attempt"); 
-        backoff_.schedule_attempt(now);
+        if (selector_) failover_failed_(now);
+        else backoff_.schedule_attempt(now);
     }
     if (reconnect_in_flight_.load(std::memory_order_relaxed)) return;
 
-    if (!backoff_.can_attempt(now)) return;
+    // with several brokers the per-endpoint cooldowns pace attempts instead of the backoff
+    if (selector_) {
+        if (!begin_attempt_(now)) return;
+    } else if (!backoff_.can_attempt(now)) {
+        return;
+    }
 
     int rc = reconnect_fn_();
     if (rc == MOSQ_ERR_SUCCESS) {
@@ -128,10 +342,11 @@ void MqttClient::tick_reconnect_() {
         reconnect_in_flight_.store(true, std::memory_order_relaxed);
     } else {
         LOG_ERROR(std::string("reconnect_async error: ") + mosquitto_strerror(rc));
+        if (selector_) failover_failed_(now);
     }
 
     // Always schedule next attempt
-    backoff_.schedule_attempt(now);
+    if (!selector_) backoff_.schedule_attempt(now);
 }
 
 bool MqttClient::in_flight_timed_out_(TimePoint now) noexcept {
@@ -147,7 +362,7 @@ bool MqttClient::in_flight_timed_out_(TimePoint now) noexcept {
     }
 
     const TimePoint started{TimePoint::duration{started_ticks}};
-    if (now - started >= k_reconnect_in_flight_timeout) {
+    if (now - started >= reconnect_timeout_) {
         reconnect_in_flight_.store(false, std::memory_order_relaxed);
         reconnect_started_ticks_.store(0, std::memory_order_relaxed);
         return true;
@@ -162,21 +377,63 @@ bool MqttClient::ensure_connected() {
     return connected_.load(std::memory_order_relaxed);
 }
 
-bool MqttClient::publish(std::string_view topic, std::string_view payload, int qos, bool retain) {
-    if (!ensure_connected()) return false;
+void MqttClient::sync_aliases_() {
+    const auto generation = alias_generation_.load(std::memory_order_acquire);
+    if (generation == aliases_generation_) return;
+    aliases_generation_ = generation;
+    aliases_.reset(alias_max_.load(std::memory_order_relaxed));
+}
+
+bool MqttClient::publish(std::string_view topic, std::string_view payload, int qos, bool retain, const char* content_encoding) {
+    if (!ensure_connected()) {
+        failed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (window_.full()) return false;
 
     int payload_len = static_cast<int>(payload.size());
-    std::string topic_str(topic);
-    int rc = mosquitto_publish(
-        mosq_,
-        nullptr,
-        topic_str.c_str(),
+    // mosquitto needs a NUL-terminated topic; reuse a per-thread buffer instead of allocating per message
+    thread_local std::string topic_str;
+    topic_str.assign(topic);
+
+    MessageProps props;
+    const char* topic_arg = topic_str.c_str();
+    std::uint16_t new_alias = 0;
+    if (v5_.enabled) {
+        props.message_expiry_s = v5_.message_expiry_s;
+        if (content_encoding) {
+            props.content_type = "application/zlib"; // RFC 6713; zlib is the only content encoding
+        } else if (!v5_.content_type.empty()) {
+            props.content_type = v5_.content_type.c_str();
+        }
+        props.content_encoding = content_encoding;
+        // QoS 1/2 messages stay queued in libmosquitto and are resent after a reconnect, where
+        // an alias of the old connection would be a protocol error; they always carry the topic
+        if (v5_.topic_aliases && qos == 0) {
+            sync_aliases_();
+            if (const auto alias = aliases_.find(topic)) {
+                props.topic_alias = alias;
+                topic_arg = nullptr; // the 2-byte alias replaces the topic string
+            } else if ((new_alias = aliases_.next())) {
+                props.topic_alias = new_alias; // sent with the topic once to establish it
+            }
+        }
+    }
+
+    int mid = 0;
+    const auto sent_at = AckTimer::Clock::now();
+    int rc = publish_fn_(
+        &mid,
+        topic_arg,
         payload_len,
         payload.data(),
         qos,
-        retain
+        retain,
+        props
     );
+    publish_latency_.record(AckTimer::Clock::now() - sent_at);
 
+    if (rc != MOSQ_ERR_SUCCESS) failed_.fetch_add(1, std::memory_order_relaxed);
     if (rc == MOSQ_ERR_NO_CONN) {
         connected_.store(false, std::memory_order_relaxed);
         tick_reconnect_();
@@ -187,6 +444,45 @@ bool MqttClient::publish(std::string_view topic, std::string_view payload, int q
         LOG_ERROR(std::string("mosquitto publish error: ") + mosquitto_strerror(rc));
         return false;
     }
+    if (new_alias) aliases_.add(topic, new_alias);
+    if (counters_) counters_->add(Counter::BytesSent, payload.size());
+    window_.on_sent(mid, qos);
+    if (qos > 0) {
+        if (const auto rtt = ack_timer_.on_sent(mid, sent_at)) ack_latency_.record(*rtt);
+    }
+    return true;
+}
+
+int MqttClient::mosquitto_publish_(int* mid, const char* topic, int payload_len, const void* payload, int qos, bool retain,
+                                   const MessageProps& props) {
+    if (!v5_.enabled) return mosquitto_publish(mosq_, mid, topic, payload_len, payload, qos, retain);
+
+    mosquitto_property* list = nullptr;
+    int rc = MOSQ_ERR_SUCCESS;
+    if (props.topic_alias) rc = mosquitto_property_add_int16(&list, MQTT_PROP_TOPIC_ALIAS, props.topic_alias);
+    if (rc == MOSQ_ERR_SUCCESS && props.message_expiry_s) {
+        rc = mosquitto_property_add_int32(&list, MQTT_PROP_MESSAGE_EXPIRY_INTERVAL, props.message_expiry_s);
+    }
+    if (rc == MOSQ_ERR_SUCCESS && props.content_type) {
+        rc = mosquitto_property_add_string(&list, MQTT_PROP_CONTENT_TYPE, props.content_type);
+    }
+    if (rc == MOSQ_ERR_SUCCESS && props.content_encoding) {
+        rc = mosquitto_property_add_string_pair(&list, MQTT_PROP_USER_PROPERTY, "content-encoding", props.content_encoding);
+    }
+    if (rc == MOSQ_ERR_SUCCESS) rc = mosquitto_publish_v5(mosq_, mid, topic, payload_len, payload, qos, retain, list);
+    mosquitto_property_free_all(&list);
+    return rc;
+}
+
+bool MqttClient::drain(std::chrono::milliseconds timeout) {
+    const auto deadline = Clock::now() + timeout;
+    while (unacked() > 0) {
+        // acks can only arrive while connected; a reconnect within the deadline resends what the
+        // lost session released, and those acks count too
+        if (Clock::now() >= deadline) return false;
+        tick_reconnect_();
+        wait_io_(std::chrono::milliseconds(10));
+    }
     return true;
 }
 
@@ -195,7 +491,7 @@ void MqttClient::stop() noexcept {
     if (!has_mosq_()) return;
 
     // mark offline (retained)
-    publish_status_(will_payload_);
+    publish_status_(offline_status_.write("offline", unix_time_s()));
 
     mosquitto_disconnect(mosq_);
 
@@ -209,8 +505,7 @@ void MqttClient::stop() noexcept {
 void MqttClient::setup_lwt_() {
     status_topic_ = make_status_topic(client_id_);
 
-    will_payload_   = make_status_payload_v1(client_id_, "offline").dump();
-    online_payload_ = make_status_payload_v1(client_id_, "online").dump();
+    will_payload_ = std::string(offline_status_.write("offline", unix_time_s()));
 
     const bool retain = true;
 
@@ -228,22 +523,31 @@ void MqttClient::setup_lwt_() {
     }
 }
 
-void MqttClient::publish_status_(const std::string& payload) {
-    if (!has_mosq_()) return;
+void MqttClient::publish_status_(std::string_view payload) {
+    if (!status_enabled_ || !has_mosq_()) return;
     if (!connected_.load(std::memory_order_relaxed)) return;
     const bool retain = true;
 
-    int rc = mosquitto_publish(
-        mosq_,
-        nullptr,
+    // status is published from both the network thread and stop(), so it never uses an alias
+    MessageProps props;
+    if (v5_.enabled) props.content_type = "application/json";
+
+    int mid = 0;
+    int rc = publish_fn_(
+        &mid,
         status_topic_.c_str(),
         static_cast<int>(payload.size()),
         payload.data(),
         qos_,
-        retain
+        retain,
+        props
     );
 
     if (rc != MOSQ_ERR_SUCCESS) {
+        failed_.fetch_add(1, std::memory_order_relaxed);
         LOG_DEBUG(std::string("status publish failed: ") + mosquitto_strerror(rc));
+        return;
     }
+    // tracked so its ack finds the mid, but without taking a slot of the telemetry window
+    window_.on_sent(mid, 0);
 }
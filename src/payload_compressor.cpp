@@ -0,0 +1,118 @@
+#include <array>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include <zlib.h>
+
+#include "payload_compressor.h"
+
+namespace {
+
+    constexpr std::size_t k_max_dictionary = 32 * 1024; // deflate window; earlier bytes are never referenced
+
+    std::uint64_t thread_cpu_ns() {
+        timespec ts{};
+        ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(ts.tv_nsec);
+    }
+
+    const Bytef* bytes(std::string_view str) { return reinterpret_cast<const Bytef*>(str.data()); }
+
+} // namespace
+
+PayloadCompressor::PayloadCompressor(Options opts) : opts_(std::move(opts)) {
+    if (opts_.dictionary.size() > k_max_dictionary) {
+        opts_.dictionary.erase(0, opts_.dictionary.size() - k_max_dictionary);
+    }
+
+    auto* zs = new z_stream{};
+    if (deflateInit(zs, opts_.level) != Z_OK) {
+        delete zs;
+        throw std::runtime_error("deflateInit failed");
+    }
+    stream_ = zs;
+
+    content_encoding_ = "zlib";
+    if (!opts_.dictionary.empty()) {
+        dictionary_id_ = static_cast<std::uint32_t>(adler32(adler32(0, nullptr, 0), bytes(opts_.dictionary),
+                                                            static_cast<uInt>(opts_.dictionary.size())));
+        std::array<char, 16> hex{};
+        std::snprintf(hex.data(), hex.size(), "%08x", dictionary_id_);
+        content_encoding_ += "; dict=";
+        content_encoding_ += hex.data();
+    }
+}
+
+PayloadCompressor::~PayloadCompressor() {
+    auto* zs = static_cast<z_stream*>(stream_);
+    deflateEnd(zs);
+    delete zs;
+}
+
+std::string_view PayloadCompressor::compress(std::string_view payload) {
+    if (payload.size() < opts_.min_bytes) return payload;
+
+    const auto start = thread_cpu_ns();
+    auto* zs = static_cast<z_stream*>(stream_);
+    deflateReset(zs);
+    if (!opts_.dictionary.empty()) {
+        deflateSetDictionary(zs, bytes(opts_.dictionary), static_cast<uInt>(opts_.dictionary.size()));
+    }
+
+    out_.resize(deflateBound(zs, static_cast<uLong>(payload.size())));
+    zs->next_in = const_cast<Bytef*>(bytes(payload));
+    zs->avail_in = static_cast<uInt>(payload.size());
+    zs->next_out = reinterpret_cast<Bytef*>(out_.data());
+    zs->avail_out = static_cast<uInt>(out_.size());
+    const int rc = deflate(zs, Z_FINISH);
+    cpu_ns_ += thread_cpu_ns() - start;
+
+    if (rc != Z_STREAM_END || zs->total_out >= payload.size()) return payload;
+    out_.resize(zs->total_out);
+    bytes_in_ += payload.size();
+    bytes_out_ += out_.size();
+    return out_;
+}
+
+std::string decompress_payload(std::string_view payload, std::string_view dictionary) {
+    if (dictionary.size() > k_max_dictionary) dictionary.remove_prefix(dictionary.size() - k_max_dictionary);
+
+    z_stream zs{};
+    if (inflateInit(&zs) != Z_OK) throw std::runtime_error("inflateInit failed");
+    zs.next_in = const_cast<Bytef*>(bytes(payload));
+    zs.avail_in = static_cast<uInt>(payload.size());
+
+    std::string out;
+    std::array<char, 4096> chunk{};
+    int rc = Z_OK;
+    while (rc != Z_STREAM_END) {
+        zs.next_out = reinterpret_cast<Bytef*>(chunk.data());
+        zs.avail_out = static_cast<uInt>(chunk.size());
+        rc = inflate(&zs, Z_NO_FLUSH);
+        if (rc == Z_NEED_DICT) {
+            rc = dictionary.empty() ? Z_DATA_ERROR : inflateSetDictionary(&zs, bytes(dictionary), static_cast<uInt>(dictionary.size()));
+        }
+        if (rc != Z_OK && rc != Z_STREAM_END) {
+            inflateEnd(&zs);
+            throw std::runtime_error("invalid compressed payload");
+        }
+        out.append(chunk.data(), chunk.size() - zs.avail_out);
+        if (rc == Z_OK && zs.avail_in == 0 && zs.avail_out != 0) {
+            inflateEnd(&zs);
+            throw std::runtime_error("truncated compressed payload");
+        }
+    }
+    inflateEnd(&zs);
+    return out;
+}
+
+std::string load_compression_dictionary(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Failed to open compression dictionary: " + path);
+    std::string dictionary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (dictionary.empty()) throw std::runtime_error("Compression dictionary is empty: " + path);
+    return dictionary;
+}
@@ -1,17 +1,156 @@
 #include <memory>
+#include <stdexcept>
 
 #include "app_config.h"
 #include "simulated_sensor.h"
+#include "system_sensors.h"
 #include "sensor.h"
+#include "sensor_device.h"
 #include "logger.h"
 
-std::unique_ptr<ISensor> make_sensor(const MetricConfig& metric) {
-    if (metric.type == "simulated") {
+namespace {
+
+    double scale_or(const MetricConfig& metric, double fallback) {
+        return metric.scale != 0.0 ? metric.scale : fallback;
+    }
+
+    std::string or_default(const std::string& value, const char* fallback) {
+        return value.empty() ? std::string(fallback) : value;
+    }
+
+    std::unique_ptr<SimulatedSensor> make_simulated(const MetricConfig& metric) {
         return std::make_unique<SimulatedSensor>(metric.name, metric.unit, metric.start, metric.step);
     }
 
+    std::unique_ptr<CpuUsageSensor> make_cpu(const MetricConfig& metric) {
+        return std::make_unique<CpuUsageSensor>(metric.name, metric.unit, or_default(metric.source, "cpu"));
+    }
+
+    std::unique_ptr<MemInfoSensor> make_meminfo(const MetricConfig& metric) {
+        return std::make_unique<MemInfoSensor>(metric.name, metric.unit, or_default(metric.source, "MemAvailable"), scale_or(metric, 1.0));
+    }
+
+    std::unique_ptr<NetDevSensor> make_netdev(const MetricConfig& metric) {
+        return std::make_unique<NetDevSensor>(metric.name, metric.unit, metric.source, or_default(metric.field, "rx_bytes"));
+    }
+
+    std::unique_ptr<SysfsValueSensor> make_sysfs(const MetricConfig& metric) {
+        if (metric.type == "thermal") {
+            // a zone name ("thermal_zone0") or a full path to its temp file; millidegrees
+            const std::string zone = or_default(metric.source, "thermal_zone0");
+            const std::string path = zone.front() == '/' ? zone : "/sys/class/thermal/" + zone + "/temp";
+            return std::make_unique<SysfsValueSensor>(metric.name, metric.unit, path, scale_or(metric, 0.001));
+        }
+        // hwmon, e.g. /sys/class/hwmon/hwmon0/temp1_input; temp/in/curr inputs are in milli-units
+        return std::make_unique<SysfsValueSensor>(metric.name, metric.unit, metric.source, scale_or(metric, 0.001));
+    }
+
+    // the device for one sensor type, created on first use
+    template <typename S>
+    class GroupSlot {
+        public:
+            explicit GroupSlot(const char* name) : name_(name) {}
+
+            void add(SensorSet& set, std::uint32_t metric, std::unique_ptr<S> sensor) {
+                if (!group_) {
+                    auto group = std::make_unique<SensorGroup<S>>(name_);
+                    group_ = group.get();
+                    index_ = static_cast<std::uint32_t>(set.devices.size());
+                    set.devices.push_back(std::move(group));
+                }
+                group_->add(metric, std::move(sensor));
+                set.device_of[metric] = index_;
+            }
+
+        private:
+            const char* name_;
+            SensorGroup<S>* group_ = nullptr;
+            std::uint32_t index_ = 0;
+    };
+
+} // namespace
+
+std::unique_ptr<ISensor> make_sensor(const MetricConfig& metric) {
+    if (metric.type == "simulated") return make_simulated(metric);
+    if (metric.type == "cpu") return make_cpu(metric);
+    if (metric.type == "meminfo") return make_meminfo(metric);
+    if (metric.type == "netdev") return make_netdev(metric);
+    if (metric.type == "thermal" || metric.type == "hwmon") return make_sysfs(metric);
+
     // Future: if (metric.type == "device_name") return std::make_unique<deviceSensor>(...)
 
     LOG_WARN("Unkown sensor type: " + metric.type + " (falling back to simulated)");
-    return std::make_unique<SimulatedSensor>(metric.name, metric.unit, metric.start, metric.step);
-}
\ No newline at end of file
+    return make_simulated(metric);
+}
+
+SensorSet make_sensor_devices(const std::vector<MetricConfig>& metrics) {
+    SensorSet set;
+    set.device_of.resize(metrics.size(), 0);
+    set.channel_of.resize(metrics.size(), 0);
+    for (std::uint32_t id = 0; id < metrics.size(); ++id) set.channel_of[id] = id;
+
+    GroupSlot<SimulatedSensor> simulated("simulated");
+    GroupSlot<CpuUsageSensor> cpu("cpu");
+    GroupSlot<MemInfoSensor> meminfo("meminfo");
+    GroupSlot<NetDevSensor> netdev("netdev");
+    GroupSlot<SysfsValueSensor> sysfs("sysfs");
+    GroupSlot<ISensor> legacy("legacy"); // ISensor adapter for types without a batched device
+
+    for (std::uint32_t id = 0; id < metrics.size(); ++id) {
+        const auto& metric = metrics[id];
+        if (metric.type == "simulated") simulated.add(set, id, make_simulated(metric));
+        else if (metric.type == "cpu") cpu.add(set, id, make_cpu(metric));
+        else if (metric.type == "meminfo") meminfo.add(set, id, make_meminfo(metric));
+        else if (metric.type == "netdev") netdev.add(set, id, make_netdev(metric));
+        else if (metric.type == "thermal" || metric.type == "hwmon") sysfs.add(set, id, make_sysfs(metric));
+        else legacy.add(set, id, make_sensor(metric));
+    }
+    return set;
+}
+
+SensorSet rebuild_sensor_devices(SensorSet& running, const std::vector<MetricConfig>& metrics,
+                                 const std::vector<std::int32_t>& kept_from) {
+    std::vector<MetricConfig> fresh_metrics;
+    std::vector<std::uint32_t> fresh_pos(metrics.size(), 0);
+    for (std::size_t i = 0; i < metrics.size(); ++i) {
+        if (kept_from[i] >= 0) continue;
+        fresh_pos[i] = static_cast<std::uint32_t>(fresh_metrics.size());
+        fresh_metrics.push_back(metrics[i]);
+    }
+    auto fresh = make_sensor_devices(fresh_metrics);
+    for (const auto& device : fresh.devices) {
+        if (!device->init()) throw std::runtime_error("Sensor init failed: " + std::string(device->name()));
+    }
+
+    // nothing below throws, so `running` is only consumed once the new sensors are ready
+    SensorSet set;
+    set.device_of.resize(metrics.size(), 0);
+    set.channel_of.resize(metrics.size(), 0);
+    constexpr std::uint32_t unused = static_cast<std::uint32_t>(-1);
+    std::vector<std::uint32_t> kept_index(running.devices.size(), unused);
+    std::vector<std::vector<std::uint32_t>> kept_channels; // per kept device
+    for (std::size_t i = 0; i < metrics.size(); ++i) {
+        if (kept_from[i] < 0) continue;
+        const auto old = static_cast<std::size_t>(kept_from[i]);
+        auto& index = kept_index[running.device_of[old]];
+        if (index == unused) {
+            index = static_cast<std::uint32_t>(set.devices.size());
+            set.devices.push_back(std::move(running.devices[running.device_of[old]]));
+            kept_channels.emplace_back();
+        }
+        set.device_of[i] = index;
+        set.channel_of[i] = running.channel_of[old];
+        kept_channels[index].push_back(running.channel_of[old]);
+    }
+    // a kept device may also serve removed metrics; their sensors (and open files) go now
+    for (std::size_t d = 0; d < kept_channels.size(); ++d) set.devices[d]->retain(kept_channels[d]);
+
+    const auto base = static_cast<std::uint32_t>(set.devices.size());
+    for (auto& device : fresh.devices) set.devices.push_back(std::move(device));
+    for (std::size_t i = 0; i < metrics.size(); ++i) {
+        if (kept_from[i] >= 0) continue;
+        set.device_of[i] = base + fresh.device_of[fresh_pos[i]];
+        set.channel_of[i] = fresh.channel_of[fresh_pos[i]];
+    }
+    return set;
+}
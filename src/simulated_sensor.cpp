@@ -5,11 +5,15 @@ SimulatedSensor::SimulatedSensor(std::string metric, std::string unit, double st
 
 bool SimulatedSensor::init() { return true; }
 
+std::optional<double> SimulatedSensor::read() noexcept {
+    return start_ * step_ * static_cast<double>(n_++);
+}
+
 std::optional<Reading> SimulatedSensor::sample() {
     return Reading {
         .metric_name = metric_,
         .unit = unit_,
-        .value = start_ * step_ * static_cast<double>(n_++)
+        .value = *read()
     };
 }
 
@@ -0,0 +1,170 @@
+#include <array>
+
+#include "system_sensors.h"
+#include "logger.h"
+
+// ---------- CpuUsageSensor ----------
+
+CpuUsageSensor::CpuUsageSensor(std::string metric, std::string unit, std::string cpu, std::string path)
+    : metric_(std::move(metric)), unit_(std::move(unit)), cpu_(std::move(cpu)), path_(std::move(path)) {}
+
+bool CpuUsageSensor::read_(std::uint64_t& busy, std::uint64_t& total) {
+    const auto line = proc_parse::find_line(file_.read(), cpu_);
+    if (!line) return false;
+
+    // user nice system idle iowait irq softirq steal (guest time is already included in user)
+    std::array<std::uint64_t, 8> f{};
+    if (proc_parse::parse_u64s(*line, f.data(), f.size()) < 4) return false;
+    const std::uint64_t idle = f[3] + f[4];
+    total = 0;
+    for (const auto v : f) total += v;
+    busy = total - idle;
+    return true;
+}
+
+bool CpuUsageSensor::init() {
+    if (!file_.open(path_)) {
+        LOG_ERROR("cpu sensor: cannot open " + path_);
+        return false;
+    }
+    if (!read_(prev_busy_, prev_total_)) {
+        LOG_ERROR("cpu sensor: no '" + cpu_ + "' line in " + path_);
+        return false;
+    }
+    return true;
+}
+
+std::optional<double> CpuUsageSensor::read() {
+    std::uint64_t busy = 0;
+    std::uint64_t total = 0;
+    if (!read_(busy, total)) return std::nullopt;
+
+    const bool ticked = total > prev_total_ && busy >= prev_busy_;
+    const std::uint64_t d_busy = busy - prev_busy_;
+    const std::uint64_t d_total = total - prev_total_;
+    prev_busy_ = busy;
+    prev_total_ = total;
+    if (!ticked) return std::nullopt; // no jiffies elapsed (sampling faster than USER_HZ) or counters reset
+
+    return 100.0 * static_cast<double>(d_busy) / static_cast<double>(d_total);
+}
+
+std::optional<Reading> CpuUsageSensor::sample() {
+    const auto value = read();
+    if (!value) return std::nullopt;
+    return Reading{metric_, unit_, *value};
+}
+
+// ---------- MemInfoSensor ----------
+
+MemInfoSensor::MemInfoSensor(std::string metric, std::string unit, std::string key, double scale, std::string path)
+    : metric_(std::move(metric)), unit_(std::move(unit)), key_(std::move(key)), scale_(scale), path_(std::move(path)) {}
+
+bool MemInfoSensor::init() {
+    if (!file_.open(path_)) {
+        LOG_ERROR("meminfo sensor: cannot open " + path_);
+        return false;
+    }
+    if (!read()) {
+        LOG_ERROR("meminfo sensor: no '" + key_ + "' entry in " + path_);
+        return false;
+    }
+    return true;
+}
+
+std::optional<double> MemInfoSensor::read() {
+    const auto line = proc_parse::find_line(file_.read(), key_);
+    std::uint64_t kb = 0;
+    if (!line || proc_parse::parse_u64s(*line, &kb, 1) != 1) return std::nullopt;
+    return static_cast<double>(kb) * scale_;
+}
+
+std::optional<Reading> MemInfoSensor::sample() {
+    const auto value = read();
+    if (!value) return std::nullopt;
+    return Reading{metric_, unit_, *value};
+}
+
+// ---------- NetDevSensor ----------
+
+NetDevSensor::NetDevSensor(std::string metric, std::string unit, std::string iface, std::string field, std::string path)
+    : metric_(std::move(metric)), unit_(std::move(unit)), iface_(std::move(iface)), index_(field_index(field)), path_(std::move(path)) {}
+
+int NetDevSensor::field_index(std::string_view field) noexcept {
+    // receive: bytes packets errs drop fifo frame compressed multicast | transmit: bytes packets errs drop ...
+    constexpr std::array<std::string_view, 8> fields{
+        "rx_bytes", "rx_packets", "rx_errs", "rx_drop", "tx_bytes", "tx_packets", "tx_errs", "tx_drop"
+    };
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+        if (fields[i] == field) return static_cast<int>(i < 4 ? i : i + 4);
+    }
+    return -1;
+}
+
+std::optional<std::uint64_t> NetDevSensor::read_() {
+    const auto line = proc_parse::find_line(file_.read(), iface_);
+    std::array<std::uint64_t, 16> f{};
+    if (!line || proc_parse::parse_u64s(*line, f.data(), f.size()) <= static_cast<std::size_t>(index_)) return std::nullopt;
+    return f[static_cast<std::size_t>(index_)];
+}
+
+bool NetDevSensor::init() {
+    if (index_ < 0) {
+        LOG_ERROR("netdev sensor: unknown field for " + metric_);
+        return false;
+    }
+    if (!file_.open(path_)) {
+        LOG_ERROR("netdev sensor: cannot open " + path_);
+        return false;
+    }
+    const auto counter = read_();
+    if (!counter) {
+        LOG_ERROR("netdev sensor: no interface '" + iface_ + "' in " + path_);
+        return false;
+    }
+    (void)rate_.update(*counter, CounterRate::Clock::now());
+    return true;
+}
+
+std::optional<double> NetDevSensor::read() {
+    const auto counter = read_();
+    if (!counter) return std::nullopt;
+    const auto rate = rate_.update(*counter, CounterRate::Clock::now());
+    if (!rate) return std::nullopt;
+    return *rate;
+}
+
+std::optional<Reading> NetDevSensor::sample() {
+    const auto value = read();
+    if (!value) return std::nullopt;
+    return Reading{metric_, unit_, *value};
+}
+
+// ---------- SysfsValueSensor ----------
+
+SysfsValueSensor::SysfsValueSensor(std::string metric, std::string unit, std::string path, double scale)
+    : metric_(std::move(metric)), unit_(std::move(unit)), path_(std::move(path)), scale_(scale) {}
+
+bool SysfsValueSensor::init() {
+    if (!file_.open(path_)) {
+        LOG_ERROR("sysfs sensor: cannot open " + path_);
+        return false;
+    }
+    if (!read()) {
+        LOG_ERROR("sysfs sensor: no integer value in " + path_);
+        return false;
+    }
+    return true;
+}
+
+std::optional<double> SysfsValueSensor::read() {
+    const auto raw = proc_parse::parse_i64(file_.read());
+    if (!raw) return std::nullopt;
+    return static_cast<double>(*raw) * scale_;
+}
+
+std::optional<Reading> SysfsValueSensor::sample() {
+    const auto value = read();
+    if (!value) return std::nullopt;
+    return Reading{metric_, unit_, *value};
+}
@@ -0,0 +1,436 @@
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+#include "telemetry_publisher.h"
+#include "mqtt_client.h"
+#include "logger.h"
+#include "payload_format.h"
+#include "telemetry_payload.h"
+#include "time_utils.h"
+#include "topic_builder.h"
+
+namespace {
+    // a sharded session down this long is logged
+    constexpr auto k_outage_report_after = std::chrono::seconds(60);
+}
+
+TelemetryPublisher::Batch::Batch(const AppConfig& cfg, std::size_t max_readings)
+    : writer(cfg.client_id, cfg.schema_version) {
+    for (const auto& metric : cfg.metrics) writer.add_metric(metric.name, metric.unit);
+    writer.reserve(static_cast<std::size_t>(cfg.batch.max_bytes));
+    readings.reserve(max_readings);
+}
+
+TelemetryPublisher::TelemetryPublisher(MqttClient& mqtt, const AppConfig& cfg)
+    : mqtt_(&mqtt),
+      cfg_(cfg),
+      batch_topic_(make_batch_topic(cfg.client_id)),
+      health_topic_(make_health_topic(cfg.client_id)),
+      health_writer_(cfg.client_id),
+      pending_(static_cast<std::size_t>(cfg.store_forward.capacity), cfg.store_forward.policy)
+    {
+        build_metrics_();
+        compressor_ = make_compressor_(cfg);
+
+        if (cfg.spool.enabled) {
+            DiskSpool::Options opts;
+            opts.dir = cfg.spool.dir;
+            opts.max_bytes = static_cast<std::uint64_t>(cfg.spool.max_mb) * 1024 * 1024;
+            opts.max_age_s = static_cast<std::int64_t>(cfg.spool.max_age_h) * 3600;
+            opts.segment_bytes = static_cast<std::uint64_t>(cfg.spool.segment_kb) * 1024;
+            opts.flush_records = static_cast<std::size_t>(cfg.spool.flush_records);
+            opts.flush_interval = std::chrono::milliseconds(cfg.spool.flush_interval_ms);
+            try {
+                spool_ = std::make_unique<DiskSpool>(std::move(opts));
+            } catch (const std::exception& e) {
+                LOG_ERROR(std::string("Spool disabled, using the in-memory buffer: ") + e.what());
+            }
+        }
+    }
+
+void TelemetryPublisher::build_metrics_() {
+    metrics_.clear();
+    metrics_.reserve(cfg_.metrics.size());
+    for (const auto& metric : cfg_.metrics) {
+        metrics_.push_back(MetricEntry{
+            make_topic(cfg_.client_id, metric.topic_suffix),
+            TelemetryPayloadWriter(cfg_.client_id, metric.name, metric.unit, cfg_.schema_version)
+        });
+    }
+
+    batch_.reset();
+    replay_batch_.reset();
+    if (cfg_.batch.enabled) {
+        const std::size_t per_batch = cfg_.metrics.size() * static_cast<std::size_t>(cfg_.batch.max_ticks);
+        batch_ = std::make_unique<Batch>(cfg_, per_batch);
+        replay_batch_ = std::make_unique<Batch>(cfg_, per_batch);
+    }
+}
+
+std::unique_ptr<PayloadCompressor> TelemetryPublisher::make_compressor_(const AppConfig& cfg) {
+    if (!cfg.compression.enabled) return nullptr;
+    PayloadCompressor::Options opts;
+    opts.level = cfg.compression.level;
+    opts.min_bytes = static_cast<std::size_t>(cfg.compression.min_bytes);
+    if (!cfg.compression.dictionary.empty()) opts.dictionary = load_compression_dictionary(cfg.compression.dictionary);
+    return std::make_unique<PayloadCompressor>(std::move(opts));
+}
+
+void TelemetryPublisher::reconfigure(const AppConfig& previous) {
+    // may throw (dictionary file); nothing has changed yet if it does
+    auto compressor = cfg_.compression == previous.compression ? std::move(compressor_) : make_compressor_(cfg_);
+
+    // buffered readings follow their metric by name; those of removed metrics are dropped
+    std::unordered_map<std::string_view, std::uint32_t> index_of;
+    for (std::size_t i = 0; i < cfg_.metrics.size(); ++i) index_of.emplace(cfg_.metrics[i].name, static_cast<std::uint32_t>(i));
+    std::vector<PendingReading> kept;
+    kept.reserve(pending_.size());
+    for (; !pending_.empty(); pending_.pop()) {
+        auto reading = pending_.front();
+        const auto it = index_of.find(previous.metrics[reading.metric].name);
+        if (it == index_of.end()) continue;
+        reading.metric = it->second;
+        kept.push_back(reading);
+    }
+    for (const auto& reading : kept) pending_.push(reading);
+
+    compressor_ = std::move(compressor);
+    if (cfg_.client_id != previous.client_id) {
+        batch_topic_ = make_batch_topic(cfg_.client_id);
+        health_topic_ = make_health_topic(cfg_.client_id);
+        health_writer_ = HealthPayloadWriter(cfg_.client_id);
+    }
+    build_metrics_();
+}
+
+MqttClient& TelemetryPublisher::client_for_(std::string_view topic) const {
+    if (shards_.empty()) return *mqtt_;
+    const auto shard = topic_shard(topic, shards_.size() + 1);
+    return shard == 0 ? *mqtt_ : *shards_[shard - 1];
+}
+
+bool TelemetryPublisher::any_connected_() const {
+    return mqtt_->connected() ||
+           std::any_of(shards_.begin(), shards_.end(), [](const MqttClient* shard) { return shard->connected(); });
+}
+
+void TelemetryPublisher::watch_sessions_(TimePoint now) {
+    for (std::size_t i = 0; i < outages_.size(); ++i) {
+        const MqttClient& session = i == 0 ? *mqtt_ : *shards_[i - 1];
+        auto& outage = outages_[i];
+        if (session.connected()) {
+            if (outage.reported) LOG_INFO(session.client_id() + " reconnected, replaying the readings of its topics");
+            outage = Outage{};
+        } else if (outage.since == TimePoint{}) {
+            outage.since = now;
+        } else if (!outage.reported && now - outage.since >= k_outage_report_after) {
+            outage.reported = true;
+            LOG_WARN(session.client_id() + " disconnected for " +
+                     std::to_string(std::chrono::duration_cast<std::chrono::seconds>(now - outage.since).count()) +
+                     " s; the readings of its topics are held back while the other sessions replay theirs");
+        }
+    }
+}
+
+LatencyHistogram::Counts TelemetryPublisher::merged_latency_(const LatencyHistogram& (MqttClient::*histogram)() const noexcept) const {
+    LatencyHistogram::Counts counts{};
+    (mqtt_->*histogram)().accumulate(counts);
+    for (const auto* shard : shards_) (shard->*histogram)().accumulate(counts);
+    return counts;
+}
+
+bool TelemetryPublisher::publish_(std::string_view topic, std::string_view payload, int qos, bool retain) {
+    auto& mqtt = client_for_(topic);
+    // a full in-flight window defers the message to the store-and-forward buffer/spool
+    if (mqtt.window_full()) {
+        ++backpressure_;
+        return false;
+    }
+    const char* encoding = (compressor_ && is_zlib_payload(payload)) ? compressor_->content_encoding().c_str() : nullptr;
+    return mqtt.publish(topic, payload, qos, retain, encoding);
+}
+
+// compressed before spooling, so the spool stores (and replays) the smaller payload
+std::string_view TelemetryPublisher::compress_(std::string_view payload) {
+    return compressor_ ? compressor_->compress(payload) : payload;
+}
+
+std::string_view TelemetryPublisher::render_single_(const PendingReading& reading) {
+    const LatencyTimer timer(serialize_latency_);
+    if (cfg_.payload_format == PayloadFormat::JsonV1) {
+        // metric name/unit are baked into the writer at construction
+        return compress_(metrics_[reading.metric].writer.write(reading.value, reading.seq, reading.timestamp_s(), reading.timestamp_ms));
+    }
+
+    const auto& metric = cfg_.metrics[reading.metric];
+    const auto payload = cfg_.schema_version >= 2
+        ? make_payload_v2(cfg_.client_id, metric.name, metric.unit, reading.value, reading.seq, reading.timestamp_ms)
+        : make_payload_v1(cfg_.client_id, metric.name, metric.unit, reading.value, reading.seq, reading.timestamp_s());
+    encoded_ = encode_payload(payload, cfg_.payload_format);
+    return compress_(encoded_);
+}
+
+std::string_view TelemetryPublisher::render_batch_(Batch& batch) {
+    const LatencyTimer timer(serialize_latency_);
+    if (cfg_.payload_format == PayloadFormat::JsonV1) return compress_(batch.writer.finish());
+
+    std::vector<BatchReading> readings;
+    readings.reserve(batch.readings.size());
+    for (const auto& reading : batch.readings) {
+        const auto& metric = cfg_.metrics[reading.metric];
+        readings.push_back(BatchReading{metric.name, metric.unit, reading.value, reading.seq, reading.timestamp_s(), reading.timestamp_ms});
+    }
+    const auto payload = cfg_.schema_version >= 2 ? make_batch_payload_v2(cfg_.client_id, readings)
+                                                  : make_batch_payload_v1(cfg_.client_id, readings);
+    encoded_ = encode_payload(payload, cfg_.payload_format);
+    return compress_(encoded_);
+}
+
+bool TelemetryPublisher::publish_single_(const PendingReading& reading) {
+    return publish_(metrics_[reading.metric].topic, render_single_(reading), cfg_.qos, cfg_.retain);
+}
+
+bool TelemetryPublisher::publish_batch_(Batch& batch) {
+    return publish_(batch_topic_, render_batch_(batch), cfg_.qos, cfg_.retain);
+}
+
+void TelemetryPublisher::flush_batch_(Batch& batch) {
+    batch.ticks = 0;
+    if (batch.writer.empty()) return;
+
+    const auto payload = render_batch_(batch);
+    if (!publish_(batch_topic_, payload, cfg_.qos, cfg_.retain)) {
+        LOG_DEBUG("Failed to publish batch of " + std::to_string(batch.readings.size()) + " readings");
+        if (spool_) {
+            spool_message_(batch_topic_, payload, batch.readings.front().timestamp_s());
+        } else {
+            for (const auto& reading : batch.readings) buffer_(reading);
+        }
+    }
+    batch.writer.clear();
+    batch.readings.clear();
+}
+
+bool TelemetryPublisher::batch_has_room_(const Batch& batch, std::uint32_t metric) const {
+    return batch.writer.empty() ||
+        batch.writer.size_bytes() + batch.writer.reading_size_bound(metric) <= static_cast<std::size_t>(cfg_.batch.max_bytes);
+}
+
+void TelemetryPublisher::add_to_batch_(const PendingReading& reading) {
+    if (!batch_has_room_(*batch_, reading.metric)) flush_batch_(*batch_);
+
+    batch_->writer.append(reading.metric, reading.value, reading.seq, reading.timestamp_s(), reading.timestamp_ms);
+    batch_->readings.push_back(reading);
+}
+
+void TelemetryPublisher::buffer_(const PendingReading& reading) {
+    if (!pending_.push(reading)) {
+        LOG_DEBUG("Store-and-forward buffer full, dropped reading seq=" + std::to_string(reading.seq));
+    }
+}
+
+void TelemetryPublisher::spool_message_(std::string_view topic, std::string_view payload, std::int64_t timestamp_s) {
+    if (!spool_->append(topic, payload, timestamp_s)) {
+        LOG_DEBUG("Spool rejected message for topic: " + std::string(topic));
+    }
+}
+
+bool TelemetryPublisher::has_backlog_() const {
+    return !pending_.empty() || (spool_ && !spool_->empty());
+}
+
+void TelemetryPublisher::publish_reading(const PendingReading& reading) {
+    if (batch_) {
+        add_to_batch_(reading);
+        if (!cfg_.batch.per_metric_topics) return;
+    }
+
+    const auto& topic = metrics_[reading.metric].topic;
+    const auto payload = render_single_(reading);
+    if (!publish_(topic, payload, cfg_.qos, cfg_.retain)) {
+        LOG_DEBUG("Failed to publish topic: " + topic);
+        // in batch mode the reading is already covered by the batch
+        if (batch_) return;
+        if (spool_) spool_message_(topic, payload, reading.timestamp_s());
+        else buffer_(reading);
+    }
+}
+
+void TelemetryPublisher::publish_summary(const PendingReading& reading, const WindowSummary& summary) {
+    std::string_view payload;
+    {
+        const LatencyTimer timer(serialize_latency_);
+        const auto& metric = cfg_.metrics[reading.metric];
+        const auto json = cfg_.schema_version >= 2
+            ? make_summary_payload_v2(cfg_.client_id, metric.name, metric.unit, summary, reading.seq, reading.timestamp_ms)
+            : make_summary_payload_v1(cfg_.client_id, metric.name, metric.unit, summary, reading.seq, reading.timestamp_s());
+        encoded_ = cfg_.payload_format == PayloadFormat::JsonV1 ? json.dump() : encode_payload(json, cfg_.payload_format);
+        payload = compress_(encoded_);
+    }
+
+    const auto& topic = metrics_[reading.metric].topic;
+    if (!publish_(topic, payload, cfg_.qos, cfg_.retain)) {
+        LOG_DEBUG("Failed to publish summary on topic: " + topic);
+        // the in-memory buffer holds plain readings, which would replay the summary as its mean
+        if (spool_) spool_message_(topic, payload, reading.timestamp_s());
+        else ++summaries_dropped_;
+    }
+}
+
+void TelemetryPublisher::end_tick() {
+    if (batch_ && ++batch_->ticks >= cfg_.batch.max_ticks) flush_batch_(*batch_);
+}
+
+void TelemetryPublisher::flush() {
+    if (batch_) flush_batch_(*batch_);
+    if (spool_) spool_->flush();
+}
+
+void TelemetryPublisher::service(TimePoint now) {
+    const auto elapsed = std::chrono::duration<double>(now - replay_last_).count();
+    replay_last_ = now;
+    if (spool_) spool_->tick(now);
+
+    watch_sessions_(now);
+    // readings replay through their own session (client_for_), each as soon as it is connected
+    if (!has_backlog_() || !any_connected_()) {
+        replay_tokens_ = 0.0;
+        return;
+    }
+
+    // token bucket: replay_per_s readings per second, at most one second of burst
+    const double rate = static_cast<double>(cfg_.store_forward.replay_per_s);
+    replay_tokens_ = std::min(rate, replay_tokens_ + elapsed * rate);
+
+    const auto budget = static_cast<std::size_t>(replay_tokens_);
+    if (budget == 0) return;
+    replay_(budget);
+}
+
+void TelemetryPublisher::replay_(std::size_t budget) {
+    if (spool_) {
+        replay_spool_(budget);
+        return;
+    }
+
+    if (!replay_batch_) {
+        // readings of a disconnected shard are skipped and keep their place, so every topic
+        // stays in order
+        replay_ready_.resize(metrics_.size());
+        for (std::size_t i = 0; i < metrics_.size(); ++i) replay_ready_[i] = client_for_(metrics_[i].topic).connected();
+        std::size_t sent = 0;
+        pending_.take_front_if([&](const PendingReading& reading) {
+            if (sent == budget) return RingVisit::Stop;
+            if (!replay_ready_[reading.metric]) return RingVisit::Skip;
+            if (!publish_single_(reading)) return RingVisit::Stop;
+            ++sent;
+            return RingVisit::Take;
+        });
+        replayed_ += sent;
+        replay_tokens_ -= static_cast<double>(sent);
+        return;
+    }
+
+    // batch mode: replay as batch messages; readings leave the buffer only once their batch is published
+    if (!client_for_(batch_topic_).connected()) return;
+    std::size_t sent = 0;
+    while (sent < budget && !pending_.empty()) {
+        auto& batch = *replay_batch_;
+        std::size_t taken = 0;
+        while (sent + taken < budget && taken < pending_.size()) {
+            const auto& reading = pending_.at(taken);
+            if (!batch_has_room_(batch, reading.metric)) break;
+            batch.writer.append(reading.metric, reading.value, reading.seq, reading.timestamp_s(), reading.timestamp_ms);
+            batch.readings.push_back(reading);
+            ++taken;
+        }
+        if (taken == 0) break;
+
+        const bool ok = publish_batch_(batch);
+        batch.writer.clear();
+        batch.readings.clear();
+        if (!ok) break;
+
+        pending_.pop(taken);
+        sent += taken;
+    }
+    replayed_ += sent;
+    replay_tokens_ -= static_cast<double>(sent);
+}
+
+// spooled messages are already rendered; each one (single reading or whole batch) costs one token.
+// The spool drains in order, so it waits for the session of its oldest message.
+void TelemetryPublisher::replay_spool_(std::size_t budget) {
+    std::size_t sent = 0;
+    DiskSpool::Record record;
+    while (sent < budget && spool_->peek(record)) {
+        if (!client_for_(record.topic).connected()) break;
+        if (!publish_(record.topic, record.payload, cfg_.qos, cfg_.retain)) break;
+        spool_->pop();
+        ++sent;
+    }
+    replayed_ += sent;
+    replay_tokens_ -= static_cast<double>(sent);
+}
+
+void TelemetryPublisher::publish_health(std::uint64_t uptime_s, std::uint64_t seq, CounterRegistry& registry) {
+    auto health = counters();
+    health.overruns = registry.value(Counter::Overruns);
+    health.queue_dropped = registry.value(Counter::QueueDropped);
+    health.queue_depth = registry.take(Counter::QueueDepth);
+    health.suppressed = registry.value(Counter::Suppressed);
+    health.bytes_sent = registry.value(Counter::BytesSent);
+    const auto process = process_stats_.read();
+    const auto now_s = static_cast<std::uint64_t>(unix_time_s());
+
+    LatencyReport latency;
+    latency.sample = sample_window_.update(sample_latency_);
+    latency.serialize = serialize_window_.update(serialize_latency_);
+    latency.publish = publish_window_.update(merged_latency_(&MqttClient::publish_latency));
+    latency.ack = ack_window_.update(merged_latency_(&MqttClient::ack_latency));
+
+    // health is retained and superseded by the next one, so it is never buffered
+    if (cfg_.payload_format == PayloadFormat::JsonV1) {
+        (void)mqtt_->publish(health_topic_, health_writer_.write(uptime_s, seq, health, now_s, &latency, &process), /*qos*/ 1, /*retain*/ true);
+        return;
+    }
+    const auto payload = make_health_payload_v1(cfg_.client_id, uptime_s, seq, health, now_s, &latency, &process);
+    (void)mqtt_->publish(health_topic_, encode_payload(payload, cfg_.payload_format), /*qos*/ 1, /*retain*/ true);
+}
+
+HealthCounters TelemetryPublisher::counters() const {
+    HealthCounters out;
+    out.publish_ok = mqtt_->delivered();
+    out.publish_fail = mqtt_->failed();
+    out.inflight = mqtt_->inflight();
+    out.backpressure = backpressure_;
+    out.reconnects = mqtt_->reconnects();
+    for (const auto* shard : shards_) {
+        out.publish_ok += shard->delivered();
+        out.publish_fail += shard->failed();
+        out.inflight += shard->inflight();
+        out.reconnects += shard->reconnects();
+    }
+    out.buffered = pending_.size();
+    out.dropped = pending_.dropped() + summaries_dropped_;
+    if (spool_) {
+        out.buffered += spool_->pending();
+        out.dropped += spool_->dropped();
+    }
+    out.replayed = replayed_;
+    if (compressor_) {
+        out.compress_in_bytes = compressor_->bytes_in();
+        out.compress_out_bytes = compressor_->bytes_out();
+        out.compress_cpu_us = compressor_->cpu_us();
+    }
+    return out;
+}
+
+void TelemetryPublisher::snapshot(MetricsSnapshot& out) const {
+    out.store(counters(), mqtt_->connected());
+    out.store(MetricsSnapshot::Stage::Sample, sample_latency_);
+    out.store(MetricsSnapshot::Stage::Serialize, serialize_latency_);
+    out.store(MetricsSnapshot::Stage::Publish, merged_latency_(&MqttClient::publish_latency));
+    out.store(MetricsSnapshot::Stage::Ack, merged_latency_(&MqttClient::ack_latency));
+}
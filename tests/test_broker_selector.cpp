@@ -0,0 +1,350 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "app_config.h"
+#include "broker_selector.h"
+#include "mqtt_client.h"
+#include "tcp_probe.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    std::vector<BrokerEndpoint> two_brokers() {
+        return {{"primary", 1883, 0}, {"backup", 1884, 1}};
+    }
+
+    // loopback socket bound to a free port; connections are refused until listen()
+    int bind_loopback(int& port) {
+        const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&addr), len) != 0 ||
+            ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+            throw std::runtime_error("cannot bind a loopback port");
+        }
+        port = ntohs(addr.sin_port);
+        return fd;
+    }
+
+    TcpProbe::Result probe_until_done(TcpProbe& probe) {
+        for (int i = 0; i < 200; ++i) {
+            const auto result = probe.poll(TcpProbe::Clock::now());
+            if (result != TcpProbe::Result::Pending) return result;
+            std::this_thread::sleep_for(5ms);
+        }
+        return TcpProbe::Result::Pending;
+    }
+
+    // A "preferred broker" that is down until start(): then it relays the latest connection on
+    // its loopback port to the real broker.
+    class BrokerProxy {
+        public:
+            BrokerProxy(std::string host, int port) : host_(std::move(host)), port_(port), listen_fd_(bind_loopback(local_port_)) {}
+            ~BrokerProxy() {
+                running_.store(false);
+                if (thread_.joinable()) thread_.join();
+                close_pair_();
+                ::close(listen_fd_);
+            }
+
+            int port() const noexcept { return local_port_; }
+
+            void start() {
+                ASSERT_EQ(::listen(listen_fd_, 4), 0);
+                running_.store(true);
+                thread_ = std::thread([this] { run_(); });
+            }
+
+        private:
+            void run_() {
+                char buf[4096];
+                while (running_.load()) {
+                    pollfd fds[3] = {{listen_fd_, POLLIN, 0}, {client_fd_, POLLIN, 0}, {upstream_fd_, POLLIN, 0}};
+                    if (::poll(fds, 3, 50) <= 0) continue;
+                    if (fds[0].revents & POLLIN) {
+                        close_pair_();
+                        client_fd_ = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+                        upstream_fd_ = connect_upstream_();
+                        continue;
+                    }
+                    for (int i = 1; i < 3; ++i) {
+                        if (!fds[i].revents) continue;
+                        const int to = i == 1 ? upstream_fd_ : client_fd_;
+                        const auto n = ::read(fds[i].fd, buf, sizeof(buf));
+                        if (n <= 0 || ::write(to, buf, static_cast<std::size_t>(n)) != n) {
+                            close_pair_();
+                            break;
+                        }
+                    }
+                }
+            }
+
+            int connect_upstream_() const {
+                addrinfo hints{};
+                hints.ai_socktype = SOCK_STREAM;
+                addrinfo* found = nullptr;
+                if (::getaddrinfo(host_.c_str(), std::to_string(port_).c_str(), &hints, &found) != 0) return -1;
+                int fd = ::socket(found->ai_family, found->ai_socktype | SOCK_CLOEXEC, found->ai_protocol);
+                if (fd >= 0 && ::connect(fd, found->ai_addr, found->ai_addrlen) != 0) {
+                    ::close(fd);
+                    fd = -1;
+                }
+                ::freeaddrinfo(found);
+                return fd;
+            }
+
+            void close_pair_() {
+                if (client_fd_ >= 0) ::close(client_fd_);
+                if (upstream_fd_ >= 0) ::close(upstream_fd_);
+                client_fd_ = upstream_fd_ = -1;
+            }
+
+            std::string host_;
+            int port_;
+            int local_port_ = 0;
+            int listen_fd_;
+            int client_fd_ = -1;
+            int upstream_fd_ = -1;
+            std::atomic<bool> running_{false};
+            std::thread thread_;
+    };
+}
+
+TEST(BrokerSelector, picks_by_priority_and_skips_cooling_down_endpoints) {
+    BrokerSelector selector(two_brokers(), FailoverOptions{});
+    const auto now = BrokerSelector::Clock::now();
+
+    EXPECT_EQ(selector.pick(now), 0u);
+    selector.on_failed(0, now);
+    EXPECT_EQ(selector.pick(now), 1u);
+
+    // the cooldown doubles with consecutive failures
+    EXPECT_EQ(selector.retry_at(0), now + 1s);
+    selector.on_failed(0, now);
+    EXPECT_EQ(selector.retry_at(0), now + 2s);
+    EXPECT_EQ(selector.pick(now + 2s), 0u);
+
+    // all cooling down: the one that recovers first
+    selector.on_failed(1, now);
+    EXPECT_EQ(selector.pick(now), 1u);
+    EXPECT_FALSE(selector.ready(1, now));
+}
+
+TEST(BrokerSelector, equal_priority_prefers_lower_connect_latency) {
+    BrokerSelector selector({{"a", 1883, 0}, {"b", 1883, 0}}, FailoverOptions{});
+    const auto now = BrokerSelector::Clock::now();
+
+    selector.on_connected(0, 80ms);
+    selector.on_connected(1, 5ms);
+    EXPECT_EQ(selector.pick(now), 1u);
+    EXPECT_LT(selector.score(1), selector.score(0));
+}
+
+TEST(BrokerSelector, fails_back_only_under_priority_policy_after_failback_after) {
+    FailoverOptions opts;
+    opts.failback_after = 30s;
+    BrokerSelector selector(two_brokers(), opts);
+    const auto now = BrokerSelector::Clock::now();
+
+    EXPECT_EQ(selector.fail_back_target(1, now, now + 10s), BrokerSelector::npos);
+    EXPECT_EQ(selector.fail_back_target(1, now, now + 30s), 0u);
+    EXPECT_EQ(selector.fail_back_target(0, now, now + 30s), BrokerSelector::npos);
+    selector.on_failed(0, now + 30s);
+    EXPECT_EQ(selector.fail_back_target(1, now, now + 30s), BrokerSelector::npos);
+
+    opts.policy = FailoverPolicy::Sticky;
+    BrokerSelector sticky(two_brokers(), opts);
+    sticky.on_connected(1, 1ms);
+    EXPECT_EQ(sticky.pick(now), 1u);
+    EXPECT_EQ(sticky.fail_back_target(1, now, now + 1h), BrokerSelector::npos);
+}
+
+TEST(BrokerSelector, config_parses_brokers_and_failover) {
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"broker", {{"failover", {{"policy", "sticky"}, {"failback_after_s", 10}}}}},
+        {"brokers", nlohmann::json::array({
+            {{"host", "10.0.0.3"}, {"port", 1884}, {"priority", 1}},
+            {{"host", "10.0.0.2"}, {"priority", 0}}
+        })},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"topic_suffix", "temp"}} })}
+    };
+    auto cfg = parse_config_or_throw(jsn);
+    ASSERT_EQ(cfg.brokers.size(), 2u);
+    EXPECT_EQ(cfg.host, "10.0.0.2");
+    EXPECT_EQ(cfg.port, 1883);
+    EXPECT_EQ(cfg.failover.policy, FailoverPolicy::Sticky);
+    EXPECT_EQ(cfg.failover.failback_after_s, 10);
+    EXPECT_EQ(cfg.failover.connect_timeout_s, 5);
+
+    jsn["brokers"][0]["port"] = 0;
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+    jsn["brokers"] = nlohmann::json::array();
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+
+    // without a list, broker.host/port is the only entry
+    jsn.erase("brokers");
+    jsn["broker"]["host"] = "mqtt.local";
+    cfg = parse_config_or_throw(jsn);
+    ASSERT_EQ(cfg.brokers.size(), 1u);
+    EXPECT_EQ(cfg.brokers[0].host, "mqtt.local");
+}
+
+TEST(BrokerSelector, client_fails_over_and_back) {
+    #ifdef UNIT_TESTS
+        MqttClient mqtt("primary", 1883, "client_id", 0);
+        mqtt.set_mosq_present_for_test(true);
+        FailoverOptions opts;
+        opts.failback_after = 30s;
+        mqtt.set_brokers(two_brokers(), opts);
+
+        TimePoint now = Clock::now();
+        mqtt.set_now_fn_for_test([&] { return now; });
+        int attempts = 0;
+        mqtt.set_reconnect_fn_for_test([&] { ++attempts; return MOSQ_ERR_SUCCESS; });
+
+        mqtt.tick();
+        EXPECT_EQ(attempts, 1);
+        EXPECT_EQ(mqtt.broker(), "primary:1883");
+
+        // refused: the next attempt goes to the backup right away
+        mqtt.simulate_connect_for_test(5);
+        mqtt.simulate_disconnect_for_test(5);
+        mqtt.tick();
+        EXPECT_EQ(attempts, 2);
+        EXPECT_EQ(mqtt.broker(), "backup:1884");
+        mqtt.simulate_connect_for_test(0);
+        EXPECT_TRUE(mqtt.connected());
+
+        // no fail back before failback_after
+        auto probe = TcpProbe::Result::Pending;
+        int probes = 0;
+        mqtt.set_probe_fn_for_test([&](const BrokerEndpoint& endpoint, TimePoint) {
+            EXPECT_EQ(endpoint.host, "primary");
+            ++probes;
+            return probe;
+        });
+        now += 10s;
+        mqtt.tick();
+        EXPECT_EQ(probes, 0);
+
+        // the primary is probed first; the live session stays while it is still down
+        now += 20s;
+        mqtt.tick();
+        mqtt.tick();
+        EXPECT_EQ(probes, 2);
+        probe = TcpProbe::Result::Failed;
+        mqtt.tick();
+        EXPECT_EQ(probes, 3);
+        EXPECT_EQ(attempts, 2);
+        EXPECT_TRUE(mqtt.connected());
+        EXPECT_EQ(mqtt.broker(), "backup:1884");
+
+        // and it waits out its cooldown (its second failure: 2 s) before the next probe
+        now += 1s;
+        mqtt.tick();
+        EXPECT_EQ(probes, 3);
+        now += 1s;
+        probe = TcpProbe::Result::Open;
+        mqtt.tick();
+        EXPECT_EQ(probes, 4);
+        EXPECT_EQ(attempts, 3);
+        EXPECT_FALSE(mqtt.connected());
+        EXPECT_EQ(mqtt.broker(), "primary:1883");
+        mqtt.simulate_connect_for_test(0);
+        EXPECT_TRUE(mqtt.connected());
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
+
+TEST(TcpProbe, reports_open_and_refused_ports) {
+    int port = 0;
+    const int fd = bind_loopback(port);
+    TcpProbe probe;
+
+    // bound but not listening: refused
+    probe.start("127.0.0.1", port, TcpProbe::Clock::now() + 2s);
+    EXPECT_TRUE(probe.active());
+    EXPECT_EQ(probe_until_done(probe), TcpProbe::Result::Failed);
+    EXPECT_FALSE(probe.active());
+
+    ASSERT_EQ(::listen(fd, 1), 0);
+    probe.start("127.0.0.1", port, TcpProbe::Clock::now() + 2s);
+    EXPECT_EQ(probe_until_done(probe), TcpProbe::Result::Open);
+
+    probe.start("no-such-host.invalid", port, TcpProbe::Clock::now() + 2s);
+    EXPECT_EQ(probe.poll(TcpProbe::Clock::now()), TcpProbe::Result::Failed);
+    ::close(fd);
+}
+
+// Runs against a real broker: TELEMETRY_TEST_BROKER=localhost:1883. The preferred broker is a
+// relay to it that stays down for a while: the client waits on the backup without flapping,
+// then fails back once the relay is up.
+TEST(BrokerFailover, fails_back_only_once_the_preferred_broker_is_up) {
+    #ifdef UNIT_TESTS
+        const char* broker = std::getenv("TELEMETRY_TEST_BROKER");
+        if (!broker) GTEST_SKIP() << "Set TELEMETRY_TEST_BROKER=host:port to run against a local mosquitto";
+
+        std::string host = broker;
+        int port = 1883;
+        if (const auto colon = host.rfind(':'); colon != std::string::npos) {
+            port = std::stoi(host.substr(colon + 1));
+            host.resize(colon);
+        }
+
+        mosquitto_lib_init();
+        {
+            BrokerProxy preferred(host, port);
+            const std::string preferred_name = "127.0.0.1:" + std::to_string(preferred.port());
+            MqttClient mqtt("127.0.0.1", preferred.port(), "failback-test", 1);
+            FailoverOptions opts;
+            opts.failback_after = 1s;
+            opts.connect_timeout = 2s;
+            mqtt.set_brokers({{"127.0.0.1", preferred.port(), 0}, {host, port, 1}}, opts);
+            ASSERT_TRUE(mqtt.connect(5));
+
+            const auto tick_for = [&](auto duration, auto done) {
+                const auto until = std::chrono::steady_clock::now() + duration;
+                while (std::chrono::steady_clock::now() < until && !done()) {
+                    mqtt.tick();
+                    std::this_thread::sleep_for(20ms);
+                }
+            };
+            tick_for(10s, [&] { return mqtt.connected(); });
+            ASSERT_TRUE(mqtt.connected());
+            EXPECT_EQ(mqtt.broker(), host + ":" + std::to_string(port));
+
+            // past failback_after the preferred broker is probed, but the session stays
+            const auto reconnects = mqtt.reconnects();
+            bool dropped = false;
+            tick_for(4s, [&] { dropped = dropped || !mqtt.connected(); return false; });
+            EXPECT_FALSE(dropped);
+            EXPECT_EQ(mqtt.reconnects(), reconnects);
+
+            preferred.start();
+            tick_for(30s, [&] { return mqtt.connected() && mqtt.broker() == preferred_name; });
+            EXPECT_TRUE(mqtt.connected());
+            EXPECT_EQ(mqtt.broker(), preferred_name);
+            mqtt.stop();
+        }
+        mosquitto_lib_cleanup();
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "app_config.h"
+#include "mqtt_client.h"
+#include "payload_compressor.h"
+#include "payload_format.h"
+#include "payload_writer.h"
+#include "telemetry_publisher.h"
+
+namespace {
+    // a batch-sized JSON payload built from the same fragments the dictionary is trained on
+    std::string sample_batch(int seq) {
+        std::string out = R"({"device":{"client_id":"pi-sim-01"},"readings":[)";
+        for (int i = 0; i < 8; ++i) {
+            if (i) out += ",";
+            out += R"({"name":"temperature","seq":)" + std::to_string(seq + i) +
+                   R"(,"timestamp_s":17713757)" + std::to_string(10 + i) +
+                   R"(,"unit":"C","value":)" + std::to_string(20 + i) + ".25}";
+        }
+        return out + R"(],"schema_version":1})";
+    }
+}
+
+TEST(PayloadCompressor, small_payloads_pass_through) {
+    PayloadCompressor::Options opts;
+    opts.min_bytes = 1024;
+    PayloadCompressor comp(opts);
+
+    const std::string payload = sample_batch(1);
+    const auto out = comp.compress(payload);
+    EXPECT_EQ(out.data(), payload.data());
+    EXPECT_FALSE(is_zlib_payload(out));
+    EXPECT_EQ(comp.bytes_in(), 0u);
+}
+
+TEST(PayloadCompressor, round_trip_without_dictionary) {
+    PayloadCompressor comp(PayloadCompressor::Options{});
+    EXPECT_EQ(comp.dictionary_id(), 0u);
+    EXPECT_EQ(comp.content_encoding(), "zlib");
+
+    const std::string payload = sample_batch(1);
+    const std::string out(comp.compress(payload));
+    ASSERT_TRUE(is_zlib_payload(out));
+    EXPECT_LT(out.size(), payload.size());
+    EXPECT_EQ(decompress_payload(out), payload);
+    EXPECT_EQ(comp.bytes_in(), payload.size());
+    EXPECT_EQ(comp.bytes_out(), out.size());
+}
+
+TEST(PayloadCompressor, dictionary_shrinks_output_and_is_identified_in_header) {
+    PayloadCompressor plain(PayloadCompressor::Options{});
+    PayloadCompressor::Options opts;
+    opts.dictionary = sample_batch(100) + sample_batch(200);
+    PayloadCompressor dict(opts);
+
+    const std::string payload = sample_batch(300);
+    const std::string without(plain.compress(payload));
+    const std::string with(dict.compress(payload));
+    EXPECT_LT(with.size(), without.size());
+
+    // FLG.FDICT set, DICTID (big-endian) follows the two header bytes
+    ASSERT_TRUE(is_zlib_payload(with));
+    EXPECT_NE(static_cast<std::uint8_t>(with[1]) & 0x20, 0);
+    std::uint32_t dictid = 0;
+    for (int i = 2; i < 6; ++i) dictid = (dictid << 8) | static_cast<std::uint8_t>(with[i]);
+    EXPECT_EQ(dictid, dict.dictionary_id());
+    EXPECT_EQ(dict.content_encoding().rfind("zlib; dict=", 0), 0u);
+
+    EXPECT_EQ(decompress_payload(with, opts.dictionary), payload);
+    EXPECT_THROW(decompress_payload(with), std::runtime_error);
+    EXPECT_THROW(decompress_payload(with, "wrong dictionary"), std::runtime_error);
+}
+
+TEST(PayloadCompressor, other_payload_formats_are_not_mistaken_for_zlib) {
+    nlohmann::json payload = {{"schema_version", 1}, {"seq", 120}};
+    for (const auto fmt : {PayloadFormat::JsonV1, PayloadFormat::Cbor, PayloadFormat::MsgPack}) {
+        EXPECT_FALSE(is_zlib_payload(encode_payload(payload, fmt)));
+    }
+}
+
+TEST(PayloadCompressor, publisher_compresses_telemetry_and_tags_mqtt5_messages) {
+    #ifdef UNIT_TESTS
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"batch", {{"enabled", true}, {"max_ticks", 8}}},
+        {"compression", {{"enabled", true}, {"min_bytes", 64}}},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"unit", "C"}, {"topic_suffix", "temp"}} })}
+    };
+    const auto cfg = parse_config_or_throw(jsn);
+
+    struct Sent { std::string topic; std::string payload; std::string encoding; std::string content_type; };
+    std::vector<Sent> sent;
+    Mqtt5Options v5;
+    v5.enabled = true;
+    v5.content_type = "application/json";
+    MqttClient mqtt("host", 1883, "pi-sim-01", 1, {}, v5);
+    mqtt.set_mosq_present_for_test(true);
+    mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+    mqtt.set_publish_fn_for_test([&](int*, const char* topic, int len, const void* data, int, bool, const MessageProps& props) {
+        sent.push_back(Sent{topic ? topic : "", std::string(static_cast<const char*>(data), static_cast<std::size_t>(len)),
+                            props.content_encoding ? props.content_encoding : "",
+                            props.content_type ? props.content_type : ""});
+        return MOSQ_ERR_SUCCESS;
+    });
+    mqtt.simulate_connect_v5_for_test(0, 0);
+    sent.clear();
+
+    {
+        TelemetryPublisher publisher(mqtt, cfg);
+        for (std::uint64_t seq = 0; seq < 8; ++seq) {
+            publisher.publish_reading(PendingReading{0, 20.0 + static_cast<double>(seq), seq, 1771375777000});
+            publisher.end_tick();
+        }
+        CounterRegistry registry;
+        publisher.publish_health(10, 8, registry);
+
+        ASSERT_EQ(sent.size(), 2u);
+        EXPECT_EQ(sent[0].topic, "devices/pi-sim-01/batch");
+        EXPECT_EQ(sent[0].encoding, "zlib");
+        EXPECT_EQ(sent[0].content_type, "application/zlib");
+        const auto batch = nlohmann::json::parse(decompress_payload(sent[0].payload));
+        EXPECT_EQ(batch["readings"].size(), 8u);
+
+        // health stays plain JSON
+        EXPECT_EQ(sent[1].payload.front(), '{');
+        EXPECT_EQ(sent[1].encoding, "");
+        EXPECT_EQ(sent[1].content_type, "application/json");
+        const auto health = nlohmann::json::parse(sent[1].payload);
+        EXPECT_EQ(health["counters"]["compress_out_bytes"], sent[0].payload.size());
+        EXPECT_GT(health["counters"]["compress_in_bytes"].get<std::uint64_t>(), sent[0].payload.size());
+    }
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
+
+TEST(PayloadCompressor, config_validation) {
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"compression", {{"enabled", true}, {"level", 0}}},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"topic_suffix", "temp"}} })}
+    };
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+    EXPECT_THROW(load_compression_dictionary("/nonexistent/payload.dict"), std::runtime_error);
+}
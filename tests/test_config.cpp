@@ -33,6 +33,8 @@ TEST(Config, applies_defaults) {
     EXPECT_EQ(cfg.port, 1883);
     EXPECT_EQ(cfg.keepalive_s, 60);
     EXPECT_EQ(cfg.client_id, "pi-sim-01");
+    EXPECT_EQ(cfg.health_interval_ms, 10000);
+    EXPECT_EQ(cfg.schema_version, 1);
     EXPECT_EQ(cfg.interval_ms, 100);
     EXPECT_EQ(cfg.qos, 1);
     EXPECT_EQ(cfg.retain, false);
@@ -79,4 +81,79 @@ TEST(Config, qos_out_of_range_neg) {
     };
     EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
     SUCCEED();
-}
\ No newline at end of file
+}
+
+TEST(Config, metric_interval_overrides_global) {
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"interval_ms", 1000},
+        {"metrics", nlohmann::json::array({
+            {{"name", "vibration"}, {"topic_suffix", "vib"}, {"interval_ms", 100}},
+            {{"name", "temperature"}, {"topic_suffix", "temp"}}
+        })}
+    };
+    auto cfg = parse_config_or_throw(jsn);
+    EXPECT_EQ(effective_interval_ms(cfg, cfg.metrics[0]), 100);
+    EXPECT_EQ(effective_interval_ms(cfg, cfg.metrics[1]), 1000);
+}
+
+TEST(Config, reject_negative_metric_interval) {
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"topic_suffix", "temp"}, {"interval_ms", -5}} })}
+    };
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+}
+
+TEST(Config, reject_spool_segment_larger_than_half_the_cap) {
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"spool", {{"enabled", true}, {"max_mb", 1}, {"segment_kb", 1024}}},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"topic_suffix", "temp"}} })}
+    };
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+}
+
+TEST(Config, broker_protocol_mqtt5) {
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"broker", {{"protocol", "mqtt5"}, {"message_expiry_s", 60}}},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"topic_suffix", "temp"}} })}
+    };
+    const auto cfg = parse_config_or_throw(jsn);
+    EXPECT_TRUE(cfg.mqtt5);
+    EXPECT_TRUE(cfg.topic_aliases);
+    EXPECT_EQ(cfg.message_expiry_s, 60);
+
+    jsn["broker"]["protocol"] = "mqtt4";
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+}
+
+TEST(Config, reject_drain_timeout_beyond_systemd_stop_timeout) {
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"broker", {{"drain_timeout_ms", 12000}}},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"topic_suffix", "temp"}} })}
+    };
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+
+    jsn["broker"]["drain_timeout_ms"] = 2000;
+    jsn["broker"]["max_inflight"] = 5;
+    const auto cfg = parse_config_or_throw(jsn);
+    EXPECT_EQ(cfg.drain_timeout_ms, 2000);
+    EXPECT_EQ(cfg.max_inflight, 5);
+}
+
+TEST(Config, event_loop_mode) {
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"topic_suffix", "temp"}} })}
+    };
+    EXPECT_FALSE(parse_config_or_throw(jsn).epoll_loop);
+
+    jsn["event_loop"] = "epoll";
+    EXPECT_TRUE(parse_config_or_throw(jsn).epoll_loop);
+
+    jsn["event_loop"] = "poll";
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "app_config.h"
+#include "config_diff.h"
+#include "counter_registry.h"
+#include "mqtt_client.h"
+#include "telemetry_publisher.h"
+
+namespace {
+    nlohmann::json base_config() {
+        return {
+            {"client_id", "pi-sim-01"},
+            {"interval_ms", 1000},
+            {"broker", {{"host", "localhost"}, {"port", 1883}}},
+            {"metrics", nlohmann::json::array({
+                {{"name", "temperature"}, {"unit", "C"}, {"topic_suffix", "temp"}},
+                {{"name", "humidity"}, {"unit", "%"}, {"topic_suffix", "hum"}},
+                {{"name", "pressure"}, {"unit", "hPa"}, {"topic_suffix", "press"}}
+            })}
+        };
+    }
+}
+
+TEST(ConfigDiff, identical_configs_have_no_changes) {
+    const auto cfg = parse_config_or_throw(base_config());
+    const auto diff = diff_config(cfg, cfg);
+    EXPECT_TRUE(diff.empty());
+    EXPECT_EQ(diff.kept_from, (std::vector<std::int32_t>{0, 1, 2}));
+}
+
+TEST(ConfigDiff, metrics_are_matched_by_name) {
+    const auto running = parse_config_or_throw(base_config());
+    auto jsn = base_config();
+    jsn["metrics"].erase(0);                          // temperature removed
+    jsn["metrics"][1]["interval_ms"] = 5000;          // pressure changed
+    jsn["metrics"].push_back({{"name", "voltage"}, {"unit", "V"}, {"topic_suffix", "volt"}});
+    const auto diff = diff_config(running, parse_config_or_throw(jsn));
+
+    EXPECT_TRUE(diff.schedule);
+    EXPECT_FALSE(diff.reconnect);
+    EXPECT_TRUE(diff.restart_only.empty());
+    EXPECT_EQ(diff.kept_from, (std::vector<std::int32_t>{1, -1, -1}));
+    EXPECT_EQ(diff.removed, std::vector<std::string>{"temperature"});
+    EXPECT_EQ(diff.changed, std::vector<std::string>{"pressure"});
+    EXPECT_EQ(diff.added, std::vector<std::string>{"voltage"});
+}
+
+TEST(ConfigDiff, only_session_settings_reconnect) {
+    const auto running = parse_config_or_throw(base_config());
+
+    auto jsn = base_config();
+    jsn["log_level"] = "debug";
+    jsn["retain"] = true;
+    auto diff = diff_config(running, parse_config_or_throw(jsn));
+    EXPECT_TRUE(diff.log_level);
+    EXPECT_TRUE(diff.publishing);
+    EXPECT_FALSE(diff.reconnect);
+    EXPECT_FALSE(diff.schedule);
+
+    jsn = base_config();
+    jsn["broker"]["drain_timeout_ms"] = 1500;
+    diff = diff_config(running, parse_config_or_throw(jsn));
+    EXPECT_TRUE(diff.drain_timeout);
+    EXPECT_FALSE(diff.empty());
+    EXPECT_FALSE(diff.reconnect);
+
+    jsn = base_config();
+    jsn["broker"]["host"] = "broker.example";
+    diff = diff_config(running, parse_config_or_throw(jsn));
+    EXPECT_TRUE(diff.reconnect);
+    EXPECT_FALSE(diff.schedule);
+
+    jsn = base_config();
+    jsn["interval_ms"] = 2000;
+    diff = diff_config(running, parse_config_or_throw(jsn));
+    EXPECT_TRUE(diff.schedule);
+    EXPECT_EQ(diff.changed.size(), 3u); // metrics without their own interval follow it
+
+    jsn = base_config();
+    jsn["health_interval_ms"] = 60000;
+    diff = diff_config(running, parse_config_or_throw(jsn));
+    EXPECT_TRUE(diff.schedule);
+    EXPECT_TRUE(diff.changed.empty());
+}
+
+TEST(ConfigDiff, restart_only_settings_are_reported) {
+    const auto running = parse_config_or_throw(base_config());
+    auto jsn = base_config();
+    jsn["event_loop"] = "epoll";
+    jsn["store_forward"] = {{"capacity", 7}};
+    const auto diff = diff_config(running, parse_config_or_throw(jsn));
+    EXPECT_EQ(diff.restart_only, (std::vector<std::string>{"event_loop", "store_forward"}));
+    EXPECT_FALSE(diff.empty());
+}
+
+TEST(ConfigDiff, publisher_remaps_buffered_readings) {
+    #ifdef UNIT_TESTS
+        AppConfig cfg = parse_config_or_throw(base_config());
+        std::vector<std::string> topics; // outlives mqtt, whose destructor publishes offline status
+        MqttClient mqtt("host", 1883, "pi-sim-01", 1);
+        mqtt.set_mosq_present_for_test(true);
+        mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+        mqtt.set_publish_fn_for_test([&](int*, const char* topic, int, const void*, int, bool, const MessageProps&) {
+            topics.emplace_back(topic);
+            return MOSQ_ERR_SUCCESS;
+        });
+
+        TelemetryPublisher publisher(mqtt, cfg);
+        for (std::uint32_t metric = 0; metric < 3; ++metric) publisher.publish_reading(PendingReading{metric, 1.0, metric, 100});
+        EXPECT_EQ(publisher.counters().buffered, 3u);
+
+        // humidity removed, pressure moves to index 0
+        auto jsn = base_config();
+        jsn["metrics"] = nlohmann::json::array({
+            {{"name", "pressure"}, {"unit", "hPa"}, {"topic_suffix", "press"}},
+            {{"name", "temperature"}, {"unit", "C"}, {"topic_suffix", "temp"}}
+        });
+        const AppConfig previous = std::exchange(cfg, parse_config_or_throw(jsn));
+        publisher.reconfigure(previous);
+        EXPECT_EQ(publisher.counters().buffered, 2u);
+
+        mqtt.simulate_connect_for_test(0);
+        topics.clear(); // online status
+        const auto start = TelemetryPublisher::Clock::now();
+        publisher.service(start);
+        publisher.service(start + std::chrono::seconds(1));
+        EXPECT_EQ(topics, (std::vector<std::string>{"devices/pi-sim-01/temp", "devices/pi-sim-01/press"}));
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
+
+TEST(ConfigDiff, publisher_follows_a_new_client_id) {
+    #ifdef UNIT_TESTS
+        auto jsn = base_config();
+        jsn["batch"] = {{"enabled", true}, {"max_ticks", 4}};
+        AppConfig cfg = parse_config_or_throw(jsn);
+        std::vector<std::string> topics; // outlives mqtt, whose destructor publishes offline status
+        std::string last_payload;
+        MqttClient mqtt("host", 1883, "pi-sim-02", 1);
+        mqtt.set_mosq_present_for_test(true);
+        mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+        mqtt.set_publish_fn_for_test([&](int*, const char* topic, int len, const void* payload, int, bool, const MessageProps&) {
+            topics.emplace_back(topic);
+            last_payload.assign(static_cast<const char*>(payload), static_cast<std::size_t>(len));
+            return MOSQ_ERR_SUCCESS;
+        });
+        mqtt.simulate_connect_for_test(0);
+
+        TelemetryPublisher publisher(mqtt, cfg);
+        jsn["client_id"] = "pi-sim-02";
+        const AppConfig previous = std::exchange(cfg, parse_config_or_throw(jsn));
+        EXPECT_TRUE(diff_config(previous, cfg).reconnect);
+        publisher.flush();
+        publisher.reconfigure(previous);
+
+        topics.clear(); // online status
+        publisher.publish_reading(PendingReading{0, 1.0, 1, 100});
+        publisher.flush();
+        CounterRegistry registry;
+        publisher.publish_health(1, 2, registry);
+        EXPECT_EQ(topics, (std::vector<std::string>{"devices/pi-sim-02/batch", "devices/pi-sim-02/health"}));
+        EXPECT_NE(last_payload.find("\"client_id\":\"pi-sim-02\""), std::string::npos);
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
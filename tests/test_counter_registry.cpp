@@ -0,0 +1,37 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "counter_registry.h"
+
+TEST(CounterRegistry, slots_do_not_share_cache_lines) {
+    EXPECT_GE(sizeof(CounterRegistry), static_cast<std::size_t>(Counter::Count) * 64);
+}
+
+TEST(CounterRegistry, concurrent_adds_are_not_lost) {
+    CounterRegistry registry;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([&] {
+            for (int i = 0; i < 10000; ++i) registry.add(Counter::BytesSent, 3);
+        });
+    }
+    for (auto& writer : writers) writer.join();
+    EXPECT_EQ(registry.value(Counter::BytesSent), 120000u);
+    EXPECT_EQ(registry.value(Counter::QueueDropped), 0u);
+}
+
+TEST(CounterRegistry, high_water_gauge_resets_when_taken) {
+    CounterRegistry registry;
+    registry.raise(Counter::QueueDepth, 5);
+    registry.raise(Counter::QueueDepth, 2);
+    EXPECT_EQ(registry.value(Counter::QueueDepth), 5u);
+    EXPECT_EQ(registry.take(Counter::QueueDepth), 5u);
+    EXPECT_EQ(registry.value(Counter::QueueDepth), 0u);
+
+    registry.set(Counter::Overruns, 7);
+    registry.set(Counter::Overruns, 9);
+    EXPECT_EQ(registry.value(Counter::Overruns), 9u);
+}
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cmath>
+
+#include "app_config.h"
+#include "deadband_filter.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    const DeadbandFilter::TimePoint t0{};
+}
+
+TEST(DeadbandFilter, default_filter_passes_everything) {
+    DeadbandFilter filter;
+    EXPECT_FALSE(filter.enabled());
+    for (int i = 0; i < 3; ++i) EXPECT_TRUE(filter.should_publish(1.0, t0 + i * 1s));
+}
+
+TEST(DeadbandFilter, absolute_band_is_measured_from_last_published_value) {
+    DeadbandFilter filter(0.5, 0.0, 0ms);
+    EXPECT_TRUE(filter.should_publish(20.0, t0));        // first reading always goes out
+    EXPECT_FALSE(filter.should_publish(20.3, t0 + 1s));
+    EXPECT_FALSE(filter.should_publish(20.5, t0 + 2s));  // on the edge is still inside
+    EXPECT_TRUE(filter.should_publish(20.6, t0 + 3s));   // slow drift is caught against 20.0
+    EXPECT_FALSE(filter.should_publish(20.2, t0 + 4s));
+    EXPECT_TRUE(filter.should_publish(19.9, t0 + 5s));
+}
+
+TEST(DeadbandFilter, percent_band_with_absolute_floor) {
+    DeadbandFilter filter(0.1, 10.0, 0ms);
+    EXPECT_TRUE(filter.should_publish(100.0, t0));
+    EXPECT_FALSE(filter.should_publish(109.0, t0 + 1s)); // 10% of 100 = 10
+    EXPECT_TRUE(filter.should_publish(111.0, t0 + 2s));
+
+    EXPECT_TRUE(filter.should_publish(0.0, t0 + 3s));
+    EXPECT_FALSE(filter.should_publish(0.05, t0 + 4s));  // 10% of 0 is 0, the floor applies
+    EXPECT_TRUE(filter.should_publish(0.2, t0 + 5s));
+}
+
+TEST(DeadbandFilter, max_silence_forces_a_heartbeat) {
+    DeadbandFilter filter(1.0, 0.0, 5s);
+    EXPECT_TRUE(filter.should_publish(5.0, t0));
+    EXPECT_FALSE(filter.should_publish(5.0, t0 + 4s));
+    EXPECT_TRUE(filter.should_publish(5.0, t0 + 5s));
+    EXPECT_FALSE(filter.should_publish(5.0, t0 + 9s));   // silence restarts at the heartbeat
+    EXPECT_TRUE(filter.should_publish(5.0, t0 + 10s));
+}
+
+TEST(DeadbandFilter, max_silence_alone_suppresses_only_unchanged_values) {
+    DeadbandFilter filter(0.0, 0.0, 60s);
+    EXPECT_TRUE(filter.enabled());
+    EXPECT_TRUE(filter.should_publish(1.0, t0));
+    EXPECT_FALSE(filter.should_publish(1.0, t0 + 1s));
+    EXPECT_TRUE(filter.should_publish(1.01, t0 + 2s));
+}
+
+TEST(DeadbandFilter, nan_transitions_are_published) {
+    DeadbandFilter filter(1.0, 0.0, 0ms);
+    EXPECT_TRUE(filter.should_publish(1.0, t0));
+    EXPECT_TRUE(filter.should_publish(std::nan(""), t0 + 1s));
+    EXPECT_FALSE(filter.should_publish(std::nan(""), t0 + 2s));
+    EXPECT_TRUE(filter.should_publish(1.0, t0 + 3s));
+}
+
+TEST(DeadbandFilter, config_parses_and_validates) {
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"topic_suffix", "temp"},
+                                             {"deadband_abs", 0.25}, {"deadband_pct", 1.5}, {"max_silence_ms", 60000}} })}
+    };
+    const auto cfg = parse_config_or_throw(jsn);
+    EXPECT_DOUBLE_EQ(cfg.metrics[0].deadband_abs, 0.25);
+    EXPECT_DOUBLE_EQ(cfg.metrics[0].deadband_pct, 1.5);
+    EXPECT_EQ(cfg.metrics[0].max_silence_ms, 60000);
+
+    jsn["metrics"][0]["deadband_abs"] = -1.0;
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+    jsn["metrics"][0]["deadband_abs"] = 0.0;
+    jsn["metrics"][0]["max_silence_ms"] = -1;
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+}
@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "disk_spool.h"
+#include "time_utils.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+    struct TempDir {
+        TempDir() {
+            char tmpl[] = "/tmp/spool_test_XXXXXX";
+            path = ::mkdtemp(tmpl);
+        }
+        ~TempDir() { fs::remove_all(path); }
+        std::string path;
+    };
+
+    DiskSpool::Options options(const std::string& dir) {
+        DiskSpool::Options opts;
+        opts.dir = dir;
+        opts.flush_records = 1000; // tests flush explicitly
+        return opts;
+    }
+
+    std::string drain_one(DiskSpool& spool) {
+        DiskSpool::Record record;
+        if (!spool.peek(record)) return "<empty>";
+        std::string out = std::string(record.topic) + "=" + std::string(record.payload);
+        spool.pop();
+        return out;
+    }
+
+    fs::path only_segment(const std::string& dir) {
+        fs::path found;
+        for (const auto& entry : fs::directory_iterator(dir)) {
+            if (entry.path().extension() == ".seg") found = entry.path();
+        }
+        return found;
+    }
+} // namespace
+
+TEST(DiskSpool, fifo_order_and_buffered_records_are_readable) {
+    TempDir dir;
+    DiskSpool spool(options(dir.path));
+    const auto now = unix_time_s();
+
+    for (int i = 0; i < 3; ++i) EXPECT_TRUE(spool.append("t/" + std::to_string(i), "p" + std::to_string(i), now));
+    EXPECT_EQ(spool.pending(), 3u);
+
+    // peek flushes on demand when draining catches up with the write buffer
+    EXPECT_EQ(drain_one(spool), "t/0=p0");
+    EXPECT_EQ(drain_one(spool), "t/1=p1");
+    EXPECT_EQ(drain_one(spool), "t/2=p2");
+    EXPECT_EQ(drain_one(spool), "<empty>");
+    EXPECT_TRUE(spool.empty());
+}
+
+TEST(DiskSpool, recovers_undelivered_records_after_reopen) {
+    TempDir dir;
+    const auto now = unix_time_s();
+    {
+        DiskSpool spool(options(dir.path));
+        for (int i = 0; i < 4; ++i) spool.append("t", std::to_string(i), now);
+        spool.flush();
+        EXPECT_EQ(drain_one(spool), "t=0");
+        EXPECT_EQ(drain_one(spool), "t=1");
+    } // destructor persists the cursor
+
+    DiskSpool spool(options(dir.path));
+    EXPECT_EQ(spool.pending(), 2u);
+    EXPECT_EQ(drain_one(spool), "t=2");
+    EXPECT_EQ(drain_one(spool), "t=3");
+    EXPECT_TRUE(spool.empty());
+}
+
+TEST(DiskSpool, binary_payloads_round_trip) {
+    TempDir dir;
+    const std::string payload("\xD9\xD9\xF7\x00\xFF\x00", 6);
+    {
+        DiskSpool spool(options(dir.path));
+        spool.append("bin", payload, unix_time_s());
+    }
+    DiskSpool spool(options(dir.path));
+    DiskSpool::Record record;
+    ASSERT_TRUE(spool.peek(record));
+    EXPECT_EQ(record.payload, payload);
+}
+
+TEST(DiskSpool, torn_tail_is_truncated_on_recovery) {
+    TempDir dir;
+    const auto now = unix_time_s();
+    {
+        DiskSpool spool(options(dir.path));
+        spool.append("t", "first", now);
+        spool.append("t", "second", now);
+    }
+
+    // simulate power loss mid-write: chop the last record in half
+    const auto seg = only_segment(dir.path);
+    const auto full = fs::file_size(seg);
+    fs::resize_file(seg, full - 4);
+
+    DiskSpool spool(options(dir.path));
+    EXPECT_EQ(spool.pending(), 1u);
+    EXPECT_LT(fs::file_size(seg), full - 4);
+    EXPECT_EQ(drain_one(spool), "t=first");
+    EXPECT_EQ(drain_one(spool), "<empty>");
+}
+
+TEST(DiskSpool, corrupt_record_fails_crc_and_is_discarded) {
+    TempDir dir;
+    const auto now = unix_time_s();
+    {
+        DiskSpool spool(options(dir.path));
+        spool.append("t", "good", now);
+        spool.append("t", "evil", now);
+    }
+
+    // flip the last payload byte
+    const auto seg = only_segment(dir.path);
+    FILE* file = std::fopen(seg.c_str(), "r+b");
+    ASSERT_NE(file, nullptr);
+    std::fseek(file, -1, SEEK_END);
+    std::fputc('X', file);
+    std::fclose(file);
+
+    DiskSpool spool(options(dir.path));
+    EXPECT_EQ(drain_one(spool), "t=good");
+    EXPECT_EQ(drain_one(spool), "<empty>");
+}
+
+TEST(DiskSpool, rotates_segments_and_drops_oldest_over_size_cap) {
+    TempDir dir;
+    auto opts = options(dir.path);
+    opts.segment_bytes = 256;
+    opts.max_bytes = 1024;
+    DiskSpool spool(opts);
+
+    const std::string payload(100, 'x');
+    for (int i = 0; i < 40; ++i) spool.append("t/" + std::to_string(i), payload, unix_time_s());
+
+    EXPECT_LE(spool.bytes(), opts.max_bytes);
+    EXPECT_GT(spool.dropped(), 0u);
+    EXPECT_EQ(spool.pending() + spool.dropped(), 40u);
+
+    // what is left is the newest, still in order
+    DiskSpool::Record record;
+    ASSERT_TRUE(spool.peek(record));
+    const auto first = std::stoi(std::string(record.topic.substr(2)));
+    EXPECT_EQ(first, static_cast<int>(spool.dropped()));
+}
+
+TEST(DiskSpool, expired_records_are_skipped) {
+    TempDir dir;
+    auto opts = options(dir.path);
+    opts.max_age_s = 60;
+    DiskSpool spool(opts);
+
+    spool.append("old", "a", unix_time_s() - 3600);
+    spool.append("new", "b", unix_time_s());
+
+    EXPECT_EQ(drain_one(spool), "new=b");
+    EXPECT_EQ(spool.dropped(), 1u);
+    EXPECT_TRUE(spool.empty());
+}
+
+TEST(DiskSpool, records_spooled_after_a_drained_restart_survive_the_next_restart) {
+    TempDir dir;
+    const auto now = unix_time_s();
+    {
+        DiskSpool spool(options(dir.path));
+        spool.append("t", "a", now);
+        spool.append("t", "b", now);
+        while (drain_one(spool) != "<empty>") {}
+    }
+    {
+        DiskSpool spool(options(dir.path));
+        EXPECT_TRUE(spool.empty());
+        spool.append("t", "c", now);
+        spool.append("t", "d", now);
+    }
+
+    DiskSpool spool(options(dir.path));
+    EXPECT_EQ(spool.pending(), 2u);
+    EXPECT_EQ(drain_one(spool), "t=c");
+    EXPECT_EQ(drain_one(spool), "t=d");
+}
+
+TEST(DiskSpool, drained_segments_are_removed) {
+    TempDir dir;
+    auto opts = options(dir.path);
+    opts.segment_bytes = 64;
+    {
+        DiskSpool spool(opts);
+        for (int i = 0; i < 5; ++i) spool.append("t", std::string(40, 'a' + i), unix_time_s());
+        while (drain_one(spool) != "<empty>") {}
+    }
+
+    DiskSpool spool(opts);
+    EXPECT_TRUE(spool.empty());
+    std::size_t segments = 0;
+    for (const auto& entry : fs::directory_iterator(dir.path)) segments += entry.path().extension() == ".seg";
+    EXPECT_LE(segments, 1u);
+}
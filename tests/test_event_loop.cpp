@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <csignal>
+#include <thread>
+
+#include "event_loop.h"
+
+using namespace std::chrono_literals;
+
+TEST(EventLoop, timerfd_fires_at_its_deadline) {
+    EventLoop loop;
+    TimerFd timer;
+    int fired = 0;
+    loop.watch(timer.fd(), EPOLLIN, [&](std::uint32_t) {
+        timer.consume();
+        ++fired;
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    timer.arm_at(start + 30ms);
+    EXPECT_EQ(loop.run_once(1000), 1);
+    EXPECT_EQ(fired, 1);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 30ms);
+
+    // a past deadline fires at once; a disarmed timer never does
+    timer.arm_at(start);
+    EXPECT_EQ(loop.run_once(1000), 1);
+    EXPECT_EQ(fired, 2);
+    timer.arm_at(std::chrono::steady_clock::now() + 10ms);
+    timer.disarm();
+    EXPECT_EQ(loop.run_once(50), 0);
+    EXPECT_EQ(fired, 2);
+}
+
+TEST(EventLoop, unwatched_fd_is_not_dispatched) {
+    EventLoop loop;
+    TimerFd first;
+    TimerFd second;
+    int calls = 0;
+    // whichever runs first unwatches the other
+    loop.watch(first.fd(), EPOLLIN, [&](std::uint32_t) { ++calls; first.consume(); loop.unwatch(second.fd()); });
+    loop.watch(second.fd(), EPOLLIN, [&](std::uint32_t) { ++calls; second.consume(); loop.unwatch(first.fd()); });
+
+    const auto now = std::chrono::steady_clock::now();
+    first.arm_at(now);
+    second.arm_at(now);
+    std::this_thread::sleep_for(5ms);
+    loop.run_once(100);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(EventLoop, signalfd_receives_blocked_signals) {
+    SignalFd signals({SIGUSR1});
+    EventLoop loop;
+    int received = 0;
+    loop.watch(signals.fd(), EPOLLIN, [&](std::uint32_t) {
+        while (const auto signo = signals.next()) {
+            if (*signo == SIGUSR1) ++received;
+        }
+    });
+
+    ::raise(SIGUSR1); // blocked, so it stays pending for the signalfd instead of killing the test
+    EXPECT_EQ(loop.run_once(1000), 1);
+    EXPECT_EQ(received, 1);
+    EXPECT_FALSE(signals.next().has_value());
+}
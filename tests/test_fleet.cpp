@@ -0,0 +1,170 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "app_config.h"
+#include "fleet.h"
+#include "latency_histogram.h"
+#include "mqtt_client.h"
+#include "time_utils.h"
+
+using namespace std::chrono_literals;
+
+TEST(Fleet, client_ids_are_distinct_and_sort_in_index_order) {
+    EXPECT_EQ(fleet_client_id("sim", 0, 1), "sim-0");
+    EXPECT_EQ(fleet_client_id("sim", 7, 1000), "sim-007");
+    EXPECT_EQ(fleet_client_id("sim", 999, 1000), "sim-999");
+    EXPECT_EQ(fleet_client_id("sim", 1000, 1001), "sim-1000");
+
+    std::set<std::string> ids;
+    for (std::size_t i = 0; i < 250; ++i) ids.insert(fleet_client_id("sim", i, 250));
+    EXPECT_EQ(ids.size(), 250u);
+    EXPECT_EQ(*ids.begin(), "sim-000");
+    EXPECT_EQ(*ids.rbegin(), "sim-249");
+}
+
+TEST(Fleet, connections_ramp_and_publish_phases_spread) {
+    // 100 connections/s: one every 10 ms
+    EXPECT_EQ(fleet_slot(0, 1000, 100, 0).connect_at, 0ms);
+    EXPECT_EQ(fleet_slot(5, 1000, 100, 0).connect_at, 50ms);
+    EXPECT_EQ(fleet_slot(999, 1000, 100, 0).connect_at, 9990ms);
+
+    // phases spread evenly over 1 s on top of the connect time
+    const auto slot = fleet_slot(500, 1000, 1000, 1000);
+    EXPECT_EQ(slot.connect_at, 500ms);
+    EXPECT_EQ(slot.first_publish, 1000ms);
+    EXPECT_EQ(fleet_slot(999, 1000, 1000, 1000).first_publish - fleet_slot(999, 1000, 1000, 1000).connect_at, 999ms);
+}
+
+TEST(Fleet, config_block_is_validated) {
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"fleet", {{"threads", 8}, {"ramp_per_s", 500}, {"phase_spread_ms", 250}}},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"topic_suffix", "temp"}} })}
+    };
+    const auto cfg = parse_config_or_throw(jsn);
+    EXPECT_EQ(cfg.fleet.threads, 8);
+    EXPECT_EQ(cfg.fleet.ramp_per_s, 500);
+    EXPECT_EQ(cfg.fleet.phase_spread_ms, 250);
+    EXPECT_EQ(cfg.fleet.report_interval_s, 10);
+
+    jsn["fleet"]["threads"] = 0;
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+    jsn["fleet"]["threads"] = 4;
+    jsn["fleet"]["ramp_per_s"] = 0;
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+}
+
+TEST(Fleet, latency_window_merges_many_histograms) {
+    LatencyHistogram a;
+    LatencyHistogram b;
+    for (int i = 0; i < 99; ++i) a.record(std::uint64_t{10});
+    b.record(std::uint64_t{5000});
+
+    LatencyHistogram::Counts merged{};
+    a.accumulate(merged);
+    b.accumulate(merged);
+    LatencyWindow window;
+    const auto summary = window.update(merged);
+    EXPECT_EQ(summary.count, 100u);
+    EXPECT_EQ(summary.p50, 10u);
+    EXPECT_GE(summary.max, 5000u);
+}
+
+TEST(Fleet, payloads_use_the_configured_schema_and_the_sample_time) {
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"schema_version", 2},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"unit", "C"}, {"topic_suffix", "temp"}} })}
+    };
+    auto cfg = parse_config_or_throw(jsn);
+    const WallClock wall;
+    const auto sampled_at = std::chrono::steady_clock::now() - 1500ms;
+    const auto expected_ms = wall.unix_ms(sampled_at);
+
+    FleetPayloads v2(cfg, "pi-sim-01-007");
+    const auto payload = nlohmann::json::parse(v2.write(0, 21.5, 3, wall, sampled_at));
+    EXPECT_EQ(payload["schema_version"], 2);
+    EXPECT_EQ(payload["device"]["client_id"], "pi-sim-01-007");
+    EXPECT_EQ(payload["timestamp_ms"], expected_ms);
+    EXPECT_EQ(payload["timestamp_s"], expected_ms / 1000);
+    // stamped when sampled, not when serialized
+    const auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    EXPECT_NEAR(static_cast<double>(now_ms - payload["timestamp_ms"].get<std::int64_t>()), 1500.0, 100.0);
+
+    cfg.schema_version = 1;
+    FleetPayloads v1(cfg, "pi-sim-01-007");
+    const auto legacy = nlohmann::json::parse(v1.write(0, 21.5, 3, wall, sampled_at));
+    EXPECT_EQ(legacy["schema_version"], 1);
+    EXPECT_FALSE(legacy.contains("timestamp_ms"));
+    EXPECT_EQ(legacy["timestamp_s"], expected_ms / 1000);
+}
+
+TEST(Fleet, runs_and_stops_without_a_broker) {
+    nlohmann::json jsn = {
+        {"client_id", "fleet-test"},
+        {"broker", {{"host", "127.0.0.1"}, {"port", 1}}},
+        {"interval_ms", 20},
+        {"fleet", {{"threads", 2}, {"ramp_per_s", 1000}}},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"topic_suffix", "temp"}} })}
+    };
+    const auto cfg = parse_config_or_throw(jsn);
+
+    std::atomic<bool> running{true};
+    std::thread stopper([&] {
+        std::this_thread::sleep_for(300ms);
+        running.store(false);
+    });
+    EXPECT_EQ(run_fleet(cfg, 20, running), EXIT_SUCCESS);
+    stopper.join();
+
+    EXPECT_THROW(run_fleet(cfg, 0, running), std::runtime_error);
+}
+
+// Runs against a real broker: TELEMETRY_TEST_BROKER=localhost:1883. Every device connects and
+// QoS 1 readings get acked with the compact per-client mid tracking.
+TEST(FleetBroker, devices_connect_and_deliver) {
+    const char* broker = std::getenv("TELEMETRY_TEST_BROKER");
+    if (!broker) GTEST_SKIP() << "Set TELEMETRY_TEST_BROKER=host:port to run against a local mosquitto";
+
+    std::string host = broker;
+    int port = 1883;
+    if (const auto colon = host.rfind(':'); colon != std::string::npos) {
+        port = std::stoi(host.substr(colon + 1));
+        host.resize(colon);
+    }
+
+    nlohmann::json jsn = {
+        {"client_id", "fleet-broker-test"},
+        {"broker", {{"host", host}, {"port", port}}},
+        {"qos", 1},
+        {"interval_ms", 50},
+        {"fleet", {{"threads", 2}, {"ramp_per_s", 1000}, {"report_interval_s", 1}}},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"topic_suffix", "temp"}} })}
+    };
+    const auto cfg = parse_config_or_throw(jsn);
+    constexpr std::size_t devices = 50;
+
+    mosquitto_lib_init();
+    std::atomic<bool> running{true};
+    std::thread stopper([&] {
+        std::this_thread::sleep_for(3s);
+        running.store(false);
+    });
+    FleetTotals totals;
+    const int rc = run_fleet(cfg, devices, running, &totals);
+    stopper.join();
+    mosquitto_lib_cleanup();
+
+    EXPECT_EQ(rc, EXIT_SUCCESS);
+    EXPECT_EQ(totals.connected, devices);
+    EXPECT_GT(totals.delivered, 0u);
+    EXPECT_LE(totals.delivered, totals.published);
+}
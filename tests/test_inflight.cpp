@@ -0,0 +1,281 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <thread>
+
+#include "app_config.h"
+#include "inflight_window.h"
+#include "mqtt_client.h"
+#include "telemetry_publisher.h"
+
+using namespace std::chrono_literals;
+
+TEST(InflightWindow, counts_qos1_until_acked) {
+    InflightWindow window(2);
+    window.on_sent(1, 1);
+    window.on_sent(2, 1);
+    EXPECT_EQ(window.inflight(), 2u);
+    EXPECT_TRUE(window.full());
+
+    window.on_complete(1);
+    EXPECT_EQ(window.inflight(), 1u);
+    EXPECT_FALSE(window.full());
+    EXPECT_EQ(window.completed(), 1u);
+
+    window.on_complete(1); // duplicate callback
+    EXPECT_EQ(window.inflight(), 1u);
+    EXPECT_EQ(window.completed(), 1u);
+}
+
+TEST(InflightWindow, ack_before_sent_is_not_lost) {
+    InflightWindow window(4);
+    window.on_complete(9); // callback beat publish() returning the mid
+    EXPECT_EQ(window.completed(), 0u);
+    window.on_sent(9, 1);
+    EXPECT_EQ(window.inflight(), 0u);
+    EXPECT_EQ(window.completed(), 1u);
+}
+
+TEST(InflightWindow, qos0_completes_without_using_the_window) {
+    InflightWindow window(1);
+    window.on_sent(3, 0);
+    EXPECT_EQ(window.inflight(), 0u);
+    EXPECT_FALSE(window.full());
+    window.on_complete(3);
+    EXPECT_EQ(window.completed(), 1u);
+
+    // a later QoS 1 message reusing the mid is tracked normally
+    window.on_sent(3, 1);
+    EXPECT_EQ(window.inflight(), 1u);
+}
+
+TEST(InflightWindow, zero_max_is_unbounded) {
+    InflightWindow window(0);
+    for (int mid = 1; mid <= 100; ++mid) window.on_sent(mid, 1);
+    EXPECT_FALSE(window.full());
+}
+
+TEST(InflightWindow, reset_releases_the_window_and_ignores_late_acks) {
+    InflightWindow window(2);
+    window.on_sent(1, 1);
+    window.on_sent(2, 1);
+    EXPECT_TRUE(window.full());
+
+    window.reset();
+    EXPECT_EQ(window.inflight(), 0u);
+    EXPECT_EQ(window.released(), 2u);
+    EXPECT_FALSE(window.full());
+
+    window.on_complete(1); // resent after the reconnect and acked
+    EXPECT_EQ(window.completed(), 1u);
+    EXPECT_EQ(window.inflight(), 0u);
+    EXPECT_EQ(window.released(), 1u);
+
+    // no early-completion mark is left: a message reusing the mid waits for its own ack
+    window.on_sent(1, 1);
+    EXPECT_EQ(window.inflight(), 1u);
+    window.on_complete(1);
+    EXPECT_EQ(window.inflight(), 0u);
+    EXPECT_EQ(window.completed(), 2u);
+
+    // mid 2 was never acked; its slot is taken over once the mid comes round again
+    window.on_sent(2, 1);
+    EXPECT_EQ(window.released(), 0u);
+    EXPECT_EQ(window.inflight(), 1u);
+}
+
+TEST(InflightWindow, compact_slots_tell_mids_apart) {
+    InflightWindow window(4, 100);
+    EXPECT_EQ(window.slots(), InflightWindow::k_min_slots);
+
+    window.on_sent(5, 1);
+    window.on_complete(5 + 2048); // shares the slot; nothing of its own is waiting
+    EXPECT_EQ(window.inflight(), 1u);
+    EXPECT_EQ(window.completed(), 0u);
+    window.on_complete(5);
+    EXPECT_EQ(window.inflight(), 0u);
+    EXPECT_EQ(window.completed(), 1u);
+
+    // a newer mid takes the slot of one still waiting, which stops counting
+    window.on_sent(7, 1);
+    window.on_sent(7 + 2048, 1);
+    EXPECT_EQ(window.inflight(), 1u);
+    window.on_complete(7);
+    EXPECT_EQ(window.inflight(), 1u);
+    window.on_complete(7 + 2048);
+    EXPECT_EQ(window.inflight(), 0u);
+    EXPECT_EQ(window.completed(), 2u);
+
+    // early acks work as with a slot per mid
+    window.on_complete(9 + 4096);
+    window.on_sent(9 + 4096, 1);
+    EXPECT_EQ(window.inflight(), 0u);
+    EXPECT_EQ(window.completed(), 3u);
+}
+
+TEST(MqttClientInflight, status_acks_leave_no_stale_mark) {
+    #ifdef UNIT_TESTS
+        MqttClient mqtt("host", 1883, "pi-sim-01", 1);
+        mqtt.set_mosq_present_for_test(true);
+        mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+        int next_mid = 7;
+        int rc = MOSQ_ERR_SUCCESS;
+        mqtt.set_publish_fn_for_test([&](int* mid, const char*, int, const void*, int, bool, const MessageProps&) {
+            if (mid) *mid = next_mid++;
+            return rc;
+        });
+        mqtt.set_max_inflight(1);
+        mqtt.simulate_connect_for_test(0); // online status, mid 7
+        EXPECT_EQ(mqtt.inflight(), 0u);    // status does not take a window slot
+        mqtt.simulate_publish_ack_for_test(7);
+        EXPECT_EQ(mqtt.delivered(), 1u);
+
+        // the mid wraps around to 7: the window waits for this message's own ack
+        next_mid = 7;
+        EXPECT_TRUE(mqtt.publish("t", "1", 1));
+        EXPECT_EQ(mqtt.inflight(), 1u);
+        EXPECT_TRUE(mqtt.window_full());
+
+        // a lost session releases the window
+        mqtt.simulate_disconnect_for_test(7);
+        EXPECT_EQ(mqtt.inflight(), 0u);
+
+        // failed status and telemetry publishes are counted alike
+        rc = MOSQ_ERR_NOMEM;
+        mqtt.simulate_connect_for_test(0);
+        EXPECT_EQ(mqtt.failed(), 1u);
+        EXPECT_FALSE(mqtt.publish("t", "2", 1));
+        EXPECT_EQ(mqtt.failed(), 2u);
+        rc = MOSQ_ERR_SUCCESS; // destructor's offline status
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
+
+TEST(MqttClientInflight, window_applies_backpressure_and_drains) {
+    #ifdef UNIT_TESTS
+    MqttClient mqtt("host", 1883, "pi-sim-01", 1);
+    mqtt.set_mosq_present_for_test(true);
+    mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+    int next_mid = 1;
+    int sent = 0;
+    mqtt.set_publish_fn_for_test([&](int* mid, const char*, int, const void*, int, bool, const MessageProps&) {
+        if (mid) *mid = next_mid++;
+        ++sent;
+        return MOSQ_ERR_SUCCESS;
+    });
+    mqtt.set_max_inflight(2);
+    mqtt.simulate_connect_for_test(0);
+    sent = 0; // online status, mid 1
+
+    EXPECT_TRUE(mqtt.publish("t", "1", 1));
+    EXPECT_TRUE(mqtt.publish("t", "2", 1));
+    EXPECT_TRUE(mqtt.window_full());
+    EXPECT_FALSE(mqtt.publish("t", "3", 1));
+    EXPECT_EQ(sent, 2);
+    EXPECT_EQ(mqtt.delivered(), 0u);
+
+    mqtt.simulate_publish_ack_for_test(2);
+    EXPECT_TRUE(mqtt.publish("t", "3", 1));
+    EXPECT_EQ(mqtt.delivered(), 1u);
+
+    EXPECT_FALSE(mqtt.drain(30ms)); // mids 3 and 4 still outstanding
+
+    std::thread acker([&] {
+        std::this_thread::sleep_for(20ms);
+        mqtt.simulate_publish_ack_for_test(3);
+        mqtt.simulate_publish_ack_for_test(4);
+    });
+    EXPECT_TRUE(mqtt.drain(2s));
+    acker.join();
+    EXPECT_EQ(mqtt.inflight(), 0u);
+    EXPECT_EQ(mqtt.delivered(), 3u);
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
+
+TEST(MqttClientInflight, drain_waits_for_messages_a_lost_connection_released) {
+    #ifdef UNIT_TESTS
+    MqttClient mqtt("host", 1883, "pi-sim-01", 1);
+    mqtt.set_mosq_present_for_test(true);
+    mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+    int next_mid = 1;
+    mqtt.set_publish_fn_for_test([&](int* mid, const char*, int, const void*, int, bool, const MessageProps&) {
+        if (mid) *mid = next_mid++;
+        return MOSQ_ERR_SUCCESS;
+    });
+    mqtt.simulate_connect_for_test(0); // online status, mid 1
+    mqtt.simulate_publish_ack_for_test(1);
+
+    EXPECT_TRUE(mqtt.publish("t", "1", 1));
+    EXPECT_TRUE(mqtt.publish("t", "2", 1));
+    mqtt.simulate_disconnect_for_test(7);
+    EXPECT_EQ(mqtt.inflight(), 0u);
+    EXPECT_EQ(mqtt.unacked(), 2u);
+
+    // no reconnect before the deadline: both messages are reported as unacked
+    EXPECT_FALSE(mqtt.drain(30ms));
+    EXPECT_EQ(mqtt.unacked(), 2u);
+
+    // the reconnected session resends them and the broker acks
+    std::thread broker([&] {
+        std::this_thread::sleep_for(20ms);
+        mqtt.simulate_connect_for_test(0); // online status, mid 4
+        mqtt.simulate_publish_ack_for_test(2);
+        mqtt.simulate_publish_ack_for_test(3);
+    });
+    EXPECT_TRUE(mqtt.drain(2s));
+    broker.join();
+    EXPECT_EQ(mqtt.unacked(), 0u);
+    EXPECT_EQ(mqtt.delivered(), 3u);
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
+
+TEST(MqttClientInflight, publisher_buffers_under_backpressure_and_counts_acks_as_ok) {
+    #ifdef UNIT_TESTS
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"broker", {{"max_inflight", 1}}},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"unit", "C"}, {"topic_suffix", "temp"}} })}
+    };
+    const auto cfg = parse_config_or_throw(jsn);
+
+    MqttClient mqtt("host", 1883, "pi-sim-01", 1);
+    mqtt.set_mosq_present_for_test(true);
+    mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+    int next_mid = 1;
+    mqtt.set_publish_fn_for_test([&](int* mid, const char*, int, const void*, int, bool, const MessageProps&) {
+        if (mid) *mid = next_mid++;
+        return MOSQ_ERR_SUCCESS;
+    });
+    mqtt.set_max_inflight(static_cast<std::size_t>(cfg.max_inflight));
+    mqtt.simulate_connect_for_test(0); // the online status takes mid 1
+
+    TelemetryPublisher publisher(mqtt, cfg);
+    publisher.publish_reading(PendingReading{0, 1.0, 0, 100});
+    publisher.publish_reading(PendingReading{0, 2.0, 1, 100});
+
+    auto counters = publisher.counters();
+    EXPECT_EQ(counters.publish_ok, 0u); // queued, not acked yet
+    EXPECT_EQ(counters.inflight, 1u);
+    EXPECT_EQ(counters.backpressure, 1u);
+    EXPECT_EQ(counters.publish_fail, 0u);
+    EXPECT_EQ(counters.buffered, 1u);
+
+    mqtt.simulate_publish_ack_for_test(2);
+    const auto start = TelemetryPublisher::Clock::now();
+    publisher.service(start);
+    publisher.service(start + 1s);
+
+    counters = publisher.counters();
+    EXPECT_EQ(counters.publish_ok, 1u);
+    EXPECT_EQ(counters.buffered, 0u);
+    EXPECT_EQ(counters.replayed, 1u);
+    EXPECT_EQ(counters.inflight, 1u);
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
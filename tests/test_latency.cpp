@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <vector>
+
+#include "ack_timer.h"
+#include "latency_histogram.h"
+#include "mqtt_client.h"
+
+using namespace std::chrono_literals;
+
+TEST(LatencyHistogram, buckets_are_exact_below_16_and_within_precision_above) {
+    for (std::uint64_t v = 0; v < 16; ++v) {
+        EXPECT_EQ(LatencyHistogram::upper_bound_of(LatencyHistogram::bucket_of(v)), v);
+    }
+    for (std::uint64_t v : {16ull, 17ull, 100ull, 1000ull, 12345ull, 999999ull, 1ull << 31}) {
+        const auto upper = LatencyHistogram::upper_bound_of(LatencyHistogram::bucket_of(v));
+        EXPECT_GE(upper, v);
+        EXPECT_LE(static_cast<double>(upper), static_cast<double>(v) * 1.0625 + 1.0) << v;
+    }
+    EXPECT_EQ(LatencyHistogram::bucket_of(~0ull), LatencyHistogram::k_buckets - 1);
+}
+
+TEST(LatencyHistogram, window_reports_percentiles_per_interval) {
+    LatencyHistogram histogram;
+    LatencyWindow window;
+
+    for (std::uint64_t v = 1; v <= 1000; ++v) histogram.record(v);
+    const auto first = window.update(histogram);
+    EXPECT_EQ(first.count, 1000u);
+    EXPECT_NEAR(static_cast<double>(first.p50), 500.0, 500.0 * 0.0625);
+    EXPECT_NEAR(static_cast<double>(first.p99), 990.0, 990.0 * 0.0625);
+    EXPECT_NEAR(static_cast<double>(first.p999), 999.0, 999.0 * 0.0625);
+    EXPECT_GE(first.max, 1000u);
+
+    // the next interval only sees new samples
+    histogram.record(5);
+    const auto second = window.update(histogram);
+    EXPECT_EQ(second.count, 1u);
+    EXPECT_EQ(second.p50, 5u);
+    EXPECT_EQ(second.max, 5u);
+
+    EXPECT_EQ(window.update(histogram).count, 0u);
+}
+
+TEST(AckTimer, measures_round_trip_in_either_order) {
+    AckTimer timer;
+    const auto t0 = AckTimer::Clock::now();
+
+    EXPECT_FALSE(timer.on_sent(7, t0));
+    const auto rtt = timer.on_acked(7, t0 + 3ms);
+    ASSERT_TRUE(rtt);
+    EXPECT_EQ(std::chrono::duration_cast<std::chrono::milliseconds>(*rtt).count(), 3);
+
+    // ack callback runs before publish() has recorded the mid
+    EXPECT_FALSE(timer.on_acked(8, t0 + 5ms));
+    const auto early = timer.on_sent(8, t0 + 1ms);
+    ASSERT_TRUE(early);
+    EXPECT_EQ(std::chrono::duration_cast<std::chrono::milliseconds>(*early).count(), 4);
+
+    // a stale ack from an earlier use of the mid is ignored
+    EXPECT_FALSE(timer.on_acked(9, t0));
+    EXPECT_FALSE(timer.on_sent(9, t0 + 10ms));
+}
+
+TEST(MqttClientLatency, records_publish_and_ack_latency) {
+    #ifdef UNIT_TESTS
+    MqttClient mqtt("host", 1883, "pi-sim-01", 1);
+    mqtt.set_mosq_present_for_test(true);
+    mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+    int next_mid = 100;
+    mqtt.set_publish_fn_for_test([&](int* mid, const char*, int, const void*, int, bool, const MessageProps&) {
+        if (mid) *mid = next_mid++;
+        return MOSQ_ERR_SUCCESS;
+    });
+    mqtt.simulate_connect_for_test(0); // the online status takes mid 100
+
+    LatencyWindow publish_window;
+    LatencyWindow ack_window;
+
+    ASSERT_TRUE(mqtt.publish("devices/pi-sim-01/temp", "1", 1));
+    ASSERT_TRUE(mqtt.publish("devices/pi-sim-01/temp", "2", 0)); // QoS 0 is not ack-timed
+    mqtt.simulate_publish_ack_for_test(101);
+
+    EXPECT_EQ(publish_window.update(mqtt.publish_latency()).count, 2u);
+    EXPECT_EQ(ack_window.update(mqtt.ack_latency()).count, 1u);
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+namespace {
+    // redirects stderr into a temp file for the lifetime of the object
+    struct CaptureStderr {
+        CaptureStderr() {
+            char tmpl[] = "/tmp/logger_test_XXXXXX";
+            const int fd = ::mkstemp(tmpl);
+            path = tmpl;
+            saved = ::dup(STDERR_FILENO);
+            ::dup2(fd, STDERR_FILENO);
+            ::close(fd);
+        }
+        ~CaptureStderr() {
+            ::dup2(saved, STDERR_FILENO);
+            ::close(saved);
+            std::remove(path.c_str());
+        }
+        std::vector<std::string> lines() const {
+            std::ifstream in(path);
+            std::vector<std::string> out;
+            for (std::string line; std::getline(in, line);) out.push_back(line);
+            return out;
+        }
+        std::string path;
+        int saved = -1;
+    };
+
+    struct LevelGuard {
+        explicit LevelGuard(logger::Level lvl) : saved(logger::current_level().load()) { logger::set_level(lvl); }
+        ~LevelGuard() { logger::set_level(saved); }
+        logger::Level saved;
+    };
+} // namespace
+
+TEST(Logger, disabled_level_does_not_evaluate_message) {
+    LevelGuard level(logger::Level::Info);
+    int evaluated = 0;
+    auto expensive = [&] { ++evaluated; return std::string("debug detail"); };
+
+    LOG_DEBUG(expensive());
+    EXPECT_EQ(evaluated, 0);
+
+    CaptureStderr capture;
+    LOG_INFO(expensive());
+    EXPECT_EQ(evaluated, logger::compiled_in(logger::Level::Info) ? 1 : 0);
+}
+
+TEST(Logger, sync_line_format) {
+    LevelGuard level(logger::Level::Debug);
+    CaptureStderr capture;
+    logger::write(logger::Level::Warn, "src/x.cpp", 42, "hello");
+
+    const auto lines = capture.lines();
+    ASSERT_EQ(lines.size(), 1u);
+    // "YYYY-mm-dd HH:MM:SS [warn] src/x.cpp:42 - hello"
+    EXPECT_EQ(lines[0].size(), 19u + std::string(" [warn] src/x.cpp:42 - hello").size());
+    EXPECT_NE(lines[0].find(" [warn] src/x.cpp:42 - hello"), std::string::npos);
+}
+
+TEST(Logger, async_keeps_per_thread_order_and_truncates_long_messages) {
+    LevelGuard level(logger::Level::Debug);
+    CaptureStderr capture;
+    logger::start_async();
+
+    constexpr int threads = 4;
+    constexpr int per_thread = 50; // fits the per-thread buffer even if the writer never runs
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([t] {
+            for (int i = 0; i < per_thread; ++i) {
+                logger::write(logger::Level::Info, "t.cpp", t, "T" + std::to_string(t) + " #" + std::to_string(i));
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    logger::write(logger::Level::Info, "t.cpp", 0, std::string(logger::max_message_len + 100, 'x'));
+    logger::stop_async();
+
+    const auto lines = capture.lines();
+    ASSERT_EQ(lines.size(), static_cast<std::size_t>(threads * per_thread + 1));
+
+    std::vector<int> next(threads, 0);
+    for (const auto& line : lines) {
+        const auto pos = line.find(" - T");
+        if (pos == std::string::npos) continue;
+        int t = 0;
+        int i = 0;
+        ASSERT_EQ(std::sscanf(line.c_str() + pos, " - T%d #%d", &t, &i), 2);
+        EXPECT_EQ(i, next[static_cast<std::size_t>(t)]++);
+    }
+    for (int t = 0; t < threads; ++t) EXPECT_EQ(next[static_cast<std::size_t>(t)], per_thread);
+
+    const auto& last = lines.back();
+    EXPECT_EQ(last.substr(last.find(" - ") + 3), std::string(logger::max_message_len, 'x'));
+    EXPECT_EQ(logger::dropped(), 0u);
+}
+
+TEST(Logger, records_pushed_while_stopping_are_written) {
+    LevelGuard level(logger::Level::Debug);
+    CaptureStderr capture;
+    const auto dropped_before = logger::dropped();
+
+    constexpr int threads = 4;
+    constexpr int rounds = 20;
+    std::atomic<int> written{0};
+    for (int round = 0; round < rounds; ++round) {
+        logger::start_async();
+        std::atomic<bool> go{false};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&] {
+                while (!go.load()) {}
+                for (int i = 0; i < 20; ++i) {
+                    logger::write(logger::Level::Info, "t.cpp", 0, "S");
+                    written.fetch_add(1);
+                }
+            });
+        }
+        go.store(true);
+        logger::stop_async(); // races the workers' pushes
+        for (auto& worker : workers) worker.join();
+    }
+
+    std::size_t lines = 0;
+    for (const auto& line : capture.lines()) {
+        if (line.ends_with(" - S")) ++lines;
+    }
+    EXPECT_EQ(lines + (logger::dropped() - dropped_before), static_cast<std::size_t>(written.load()));
+}
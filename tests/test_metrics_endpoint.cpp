@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "app_config.h"
+#include "metrics_endpoint.h"
+
+namespace {
+    AppConfig config_with_endpoint(const nlohmann::json& endpoint) {
+        nlohmann::json jsn = {
+            {"client_id", "pi-sim-01"},
+            {"metrics_endpoint", endpoint},
+            {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"topic_suffix", "temp"}} })}
+        };
+        return parse_config_or_throw(jsn);
+    }
+
+    std::string scrape_unix(const std::string& path, const std::string& request) {
+        const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            return {};
+        }
+        (void)!::write(fd, request.data(), request.size());
+        std::string response;
+        char buf[4096];
+        ssize_t n;
+        while ((n = ::read(fd, buf, sizeof(buf))) > 0) response.append(buf, static_cast<std::size_t>(n));
+        ::close(fd);
+        return response;
+    }
+}
+
+TEST(MetricsEndpoint, listen_address_is_validated) {
+    const auto unix_cfg = config_with_endpoint({{"enabled", true}, {"listen", "unix:/run/telemetry/metrics.sock"}});
+    EXPECT_EQ(unix_cfg.metrics_endpoint.unix_path, "/run/telemetry/metrics.sock");
+
+    const auto tcp_cfg = config_with_endpoint({{"enabled", true}, {"listen", "127.0.0.1:9100"}});
+    EXPECT_TRUE(tcp_cfg.metrics_endpoint.unix_path.empty());
+    EXPECT_EQ(tcp_cfg.metrics_endpoint.port, 9100);
+
+    EXPECT_THROW(config_with_endpoint({{"listen", "0.0.0.0:9100"}}), std::runtime_error);
+    EXPECT_THROW(config_with_endpoint({{"listen", "127.0.0.1:0"}}), std::runtime_error);
+    EXPECT_THROW(config_with_endpoint({{"listen", "unix:"}}), std::runtime_error);
+}
+
+TEST(MetricsEndpoint, renders_openmetrics_text) {
+    MetricsSnapshot snapshot;
+    HealthCounters counters;
+    counters.publish_ok = 18;
+    counters.compress_cpu_us = 1500;
+    snapshot.store(counters, true);
+    LatencyHistogram ack;
+    ack.record(std::uint64_t{20});
+    ack.record(std::uint64_t{5000});
+    snapshot.store(MetricsSnapshot::Stage::Ack, ack);
+
+    CounterRegistry registry;
+    registry.add(Counter::BytesSent, 4096);
+    ProcessStats process;
+    process.rss_kb = 2;
+
+    const auto text = render_openmetrics(snapshot, registry, process, 42);
+    EXPECT_NE(text.find("# TYPE telemetry_publish_ok counter\n"), std::string::npos);
+    EXPECT_NE(text.find("\ntelemetry_publish_ok_total 18\n"), std::string::npos);
+    EXPECT_NE(text.find("\ntelemetry_connected 1\n"), std::string::npos);
+    EXPECT_NE(text.find("\ntelemetry_uptime_seconds 42\n"), std::string::npos);
+    EXPECT_NE(text.find("\ntelemetry_sent_bytes_total 4096\n"), std::string::npos);
+    EXPECT_NE(text.find("\ntelemetry_compress_cpu_seconds_total 0.0015\n"), std::string::npos);
+    EXPECT_NE(text.find("\ntelemetry_process_resident_memory_bytes 2048\n"), std::string::npos);
+
+    // cumulative power-of-two buckets: 20 us falls below 31 us, 5000 us below 8191 us
+    EXPECT_NE(text.find("telemetry_latency_seconds_bucket{stage=\"ack\",le=\"0.000015\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("telemetry_latency_seconds_bucket{stage=\"ack\",le=\"0.000031\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("telemetry_latency_seconds_bucket{stage=\"ack\",le=\"0.008191\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("telemetry_latency_seconds_bucket{stage=\"ack\",le=\"+Inf\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("telemetry_latency_seconds_bucket{stage=\"sample\",le=\"+Inf\"} 0\n"), std::string::npos);
+    EXPECT_TRUE(text.ends_with("# EOF\n"));
+}
+
+TEST(MetricsEndpoint, serves_scrapes_over_a_unix_socket) {
+    const auto path = (std::filesystem::temp_directory_path() / ("telemetry-metrics-" + std::to_string(::getpid()) + ".sock")).string();
+    const auto cfg = config_with_endpoint({{"enabled", true}, {"listen", "unix:" + path}});
+
+    MetricsSnapshot snapshot;
+    CounterRegistry registry;
+    registry.add(Counter::QueueDropped, 3);
+    {
+        MetricsEndpoint endpoint(cfg.metrics_endpoint, snapshot, registry, std::chrono::steady_clock::now());
+
+        const auto response = scrape_unix(path, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        EXPECT_TRUE(response.starts_with("HTTP/1.1 200 OK\r\n"));
+        EXPECT_NE(response.find("Content-Type: application/openmetrics-text; version=1.0.0"), std::string::npos);
+        EXPECT_NE(response.find("\ntelemetry_queue_dropped_total 3\n"), std::string::npos);
+        EXPECT_TRUE(response.ends_with("# EOF\n"));
+
+        EXPECT_TRUE(scrape_unix(path, "GET /nope HTTP/1.1\r\n\r\n").starts_with("HTTP/1.1 404"));
+        EXPECT_EQ(endpoint.scrapes(), 1u);
+    }
+    EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+TEST(MetricsEndpoint, refuses_to_replace_a_file_that_is_not_a_socket) {
+    const auto path = (std::filesystem::temp_directory_path() / ("telemetry-metrics-" + std::to_string(::getpid()) + ".txt")).string();
+    std::ofstream(path) << "keep me\n";
+    const auto cfg = config_with_endpoint({{"enabled", true}, {"listen", "unix:" + path}});
+
+    MetricsSnapshot snapshot;
+    CounterRegistry registry;
+    EXPECT_THROW(MetricsEndpoint(cfg.metrics_endpoint, snapshot, registry, std::chrono::steady_clock::now()), std::runtime_error);
+    EXPECT_TRUE(std::filesystem::is_regular_file(path));
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,250 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <linux/tcp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "mqtt_client.h"
+#include "topic_alias.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    struct Sent {
+        bool has_topic = false;
+        std::string topic;
+        MessageProps props;
+    };
+
+    // property block of a telemetry publish: optional alias (3 bytes) + content type (1 + 2 + len)
+    std::size_t props_len(bool alias, std::string_view content_type) {
+        return (alias ? 3 : 0) + (content_type.empty() ? 0 : 3 + content_type.size());
+    }
+}
+
+TEST(TopicAliasTable, assigns_in_order_up_to_max) {
+    TopicAliasTable table;
+    table.reset(2);
+
+    EXPECT_EQ(table.find("a"), 0);
+    EXPECT_EQ(table.next(), 1);
+    table.add("a", 1);
+    EXPECT_EQ(table.find("a"), 1);
+    EXPECT_EQ(table.next(), 2);
+    table.add("b", 2);
+    EXPECT_EQ(table.next(), 0); // full
+
+    table.reset(0);
+    EXPECT_EQ(table.find("a"), 0);
+    EXPECT_EQ(table.next(), 0);
+}
+
+TEST(TopicAliasTable, publish_size_accounts_for_alias) {
+    const std::string topic = "devices/pi-sim-01/temp";
+    const auto full = mqtt5_publish_size(topic.size(), 200, 1, props_len(false, "application/json"));
+    const auto aliased = mqtt5_publish_size(0, 200, 1, props_len(true, "application/json"));
+    EXPECT_EQ(full - aliased, topic.size() - 3);
+}
+
+TEST(Mqtt5Client, topic_aliases_replace_topic_after_first_publish) {
+    #ifdef UNIT_TESTS
+    std::vector<Sent> sent; // outlives mqtt, whose destructor publishes offline status
+    Mqtt5Options v5;
+    v5.enabled = true;
+    v5.message_expiry_s = 600;
+    v5.content_type = "application/cbor";
+    MqttClient mqtt("host", 1883, "pi-sim-01", 1, "application/cbor", v5);
+    mqtt.set_mosq_present_for_test(true);
+    mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+    mqtt.set_publish_fn_for_test([&](int*, const char* topic, int, const void*, int, bool, const MessageProps& props) {
+        sent.push_back(Sent{topic != nullptr, topic ? topic : "", props});
+        return MOSQ_ERR_SUCCESS;
+    });
+
+    mqtt.simulate_connect_v5_for_test(0, 2);
+    ASSERT_EQ(sent.size(), 1u); // online status: full topic, no alias
+    EXPECT_EQ(sent[0].props.topic_alias, 0);
+    EXPECT_STREQ(sent[0].props.content_type, "application/json");
+    sent.clear();
+
+    const std::string temp = "devices/pi-sim-01/temp";
+    const std::string hum = "devices/pi-sim-01/hum";
+    const std::string vib = "devices/pi-sim-01/vib";
+    ASSERT_TRUE(mqtt.publish(temp, "1", 0));
+    ASSERT_TRUE(mqtt.publish(temp, "2", 0));
+    ASSERT_TRUE(mqtt.publish(hum, "3", 0));
+    ASSERT_TRUE(mqtt.publish(vib, "4", 0)); // broker allows 2 aliases
+    ASSERT_TRUE(mqtt.publish(hum, "5", 0));
+    ASSERT_EQ(sent.size(), 5u);
+
+    EXPECT_TRUE(sent[0].has_topic);  EXPECT_EQ(sent[0].props.topic_alias, 1);
+    EXPECT_FALSE(sent[1].has_topic); EXPECT_EQ(sent[1].props.topic_alias, 1);
+    EXPECT_TRUE(sent[2].has_topic);  EXPECT_EQ(sent[2].props.topic_alias, 2);
+    EXPECT_TRUE(sent[3].has_topic);  EXPECT_EQ(sent[3].props.topic_alias, 0);
+    EXPECT_FALSE(sent[4].has_topic); EXPECT_EQ(sent[4].props.topic_alias, 2);
+    for (const auto& msg : sent) {
+        EXPECT_EQ(msg.props.message_expiry_s, 600u);
+        EXPECT_STREQ(msg.props.content_type, "application/cbor");
+    }
+
+    // aliases do not survive a reconnect
+    mqtt.simulate_disconnect_for_test(7);
+    mqtt.simulate_connect_v5_for_test(0, 2);
+    sent.clear();
+    ASSERT_TRUE(mqtt.publish(temp, "6", 0));
+    ASSERT_EQ(sent.size(), 1u);
+    EXPECT_TRUE(sent[0].has_topic);
+    EXPECT_EQ(sent[0].props.topic_alias, 1);
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
+
+TEST(Mqtt5Client, failed_publish_does_not_establish_alias) {
+    #ifdef UNIT_TESTS
+    int rc = MOSQ_ERR_NOMEM;
+    std::vector<Sent> sent;
+    Mqtt5Options v5;
+    v5.enabled = true;
+    MqttClient mqtt("host", 1883, "pi-sim-01", 1, {}, v5);
+    mqtt.set_mosq_present_for_test(true);
+    mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+    mqtt.set_publish_fn_for_test([&](int*, const char* topic, int, const void*, int, bool, const MessageProps& props) {
+        sent.push_back(Sent{topic != nullptr, topic ? topic : "", props});
+        return rc;
+    });
+    mqtt.simulate_connect_v5_for_test(0, 4);
+    sent.clear();
+
+    EXPECT_FALSE(mqtt.publish("devices/pi-sim-01/temp", "1", 0));
+    rc = MOSQ_ERR_SUCCESS;
+    EXPECT_TRUE(mqtt.publish("devices/pi-sim-01/temp", "2", 0));
+    ASSERT_EQ(sent.size(), 2u);
+    EXPECT_TRUE(sent[1].has_topic); // still has to carry the topic
+    EXPECT_EQ(sent[1].props.topic_alias, 1);
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
+
+TEST(Mqtt5Client, qos1_messages_carry_the_topic_to_survive_a_resend) {
+    #ifdef UNIT_TESTS
+    std::vector<Sent> sent;
+    Mqtt5Options v5;
+    v5.enabled = true;
+    MqttClient mqtt("host", 1883, "pi-sim-01", 1, {}, v5);
+    mqtt.set_mosq_present_for_test(true);
+    mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+    int next_mid = 1;
+    mqtt.set_publish_fn_for_test([&](int* mid, const char* topic, int, const void*, int, bool, const MessageProps& props) {
+        if (mid) *mid = next_mid++;
+        sent.push_back(Sent{topic != nullptr, topic ? topic : "", props});
+        return MOSQ_ERR_SUCCESS;
+    });
+    mqtt.simulate_connect_v5_for_test(0, 4);
+    sent.clear();
+
+    const std::string temp = "devices/pi-sim-01/temp";
+    ASSERT_TRUE(mqtt.publish(temp, "1", 1));
+    ASSERT_TRUE(mqtt.publish(temp, "2", 1));
+
+    // libmosquitto resends these unacked messages as they were handed to it, on the next
+    // connection; neither may depend on an alias of this one
+    mqtt.simulate_disconnect_for_test(7);
+    EXPECT_EQ(mqtt.unacked(), 2u);
+    ASSERT_EQ(sent.size(), 2u);
+    for (const auto& msg : sent) {
+        EXPECT_TRUE(msg.has_topic);
+        EXPECT_EQ(msg.topic, temp);
+        EXPECT_EQ(msg.props.topic_alias, 0);
+    }
+
+    // QoS 0 on the same topic still uses an alias
+    mqtt.simulate_connect_v5_for_test(0, 4);
+    sent.clear();
+    ASSERT_TRUE(mqtt.publish(temp, "3", 0));
+    ASSERT_TRUE(mqtt.publish(temp, "4", 0));
+    ASSERT_EQ(sent.size(), 2u);
+    EXPECT_TRUE(sent[0].has_topic);  EXPECT_EQ(sent[0].props.topic_alias, 1);
+    EXPECT_FALSE(sent[1].has_topic); EXPECT_EQ(sent[1].props.topic_alias, 1);
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
+
+// Runs against a real broker: TELEMETRY_TEST_BROKER=localhost:1883 (mosquitto 2.x, max_topic_alias > 0).
+// Measures bytes the client sent per message (TCP_INFO bytes acked) with and without aliases.
+TEST(Mqtt5Broker, topic_aliases_save_bytes_on_the_wire) {
+    #ifdef UNIT_TESTS
+    const char* broker = std::getenv("TELEMETRY_TEST_BROKER");
+    if (!broker) GTEST_SKIP() << "Set TELEMETRY_TEST_BROKER=host:port to run against a local mosquitto 2.x";
+
+    std::string host = broker;
+    int port = 1883;
+    if (const auto colon = host.rfind(':'); colon != std::string::npos) {
+        port = std::stoi(host.substr(colon + 1));
+        host.resize(colon);
+    }
+
+    mosquitto_lib_init();
+    const std::string topic = "devices/alias-test/temp";
+    const std::string payload = R"({"device":{"client_id":"alias-test"},"metric":{"name":"temperature","unit":"C","value":21.5},"schema_version":1,"seq":1,"timestamp_s":1771375779})";
+    constexpr int messages = 500;
+
+    auto bytes_acked = [](int fd) -> std::uint64_t {
+        tcp_info info{};
+        socklen_t len = sizeof(info);
+        if (fd < 0 || ::getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &len) != 0) return 0;
+        return info.tcpi_bytes_acked;
+    };
+
+    auto measure = [&](bool aliases) -> double {
+        Mqtt5Options v5;
+        v5.enabled = true;
+        v5.topic_aliases = aliases;
+        v5.content_type = "application/json";
+        MqttClient mqtt(host, port, std::string("alias-test-") + (aliases ? "on" : "off"), 0, {}, v5);
+        if (!mqtt.connect(10)) return -1.0;
+        for (int i = 0; i < 50 && !mqtt.connected(); ++i) std::this_thread::sleep_for(100ms);
+        if (!mqtt.connected()) return -1.0;
+
+        const int fd = mqtt.socket();
+        std::this_thread::sleep_for(200ms);
+        const auto before = bytes_acked(fd);
+        for (int i = 0; i < messages; ++i) mqtt.publish(topic, payload, 0);
+
+        // wait until everything has been acked by the peer's TCP stack
+        auto last = bytes_acked(fd);
+        for (int i = 0; i < 50; ++i) {
+            std::this_thread::sleep_for(100ms);
+            const auto now = bytes_acked(fd);
+            if (now == last && now > before) break;
+            last = now;
+        }
+        const auto sent = static_cast<double>(bytes_acked(fd) - before) / messages;
+        mqtt.stop();
+        return sent;
+    };
+
+    const double with_aliases = measure(true);
+    const double without_aliases = measure(false);
+    mosquitto_lib_cleanup();
+    ASSERT_GT(with_aliases, 0.0) << "could not connect to " << broker;
+    ASSERT_GT(without_aliases, 0.0);
+
+    // expected saving is topic.size() - 3 (the alias property) once the alias is established;
+    // more than the topic itself would mean the measurement picked up other traffic
+    const double saved = without_aliases - with_aliases;
+    EXPECT_GT(saved, static_cast<double>(topic.size()) - 5.0)
+        << without_aliases << " -> " << with_aliases << " bytes/message";
+    EXPECT_LE(saved, static_cast<double>(topic.size()))
+        << without_aliases << " -> " << with_aliases << " bytes/message";
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
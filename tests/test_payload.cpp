@@ -1,10 +1,16 @@
 #include <gtest/gtest.h>
 #include <nlohmann/json.hpp>
+#include <chrono>
 #include <cstdint>
+#include <limits>
+#include <vector>
 
 #include "telemetry_payload.h"
 #include "health_payload.h"
 #include "status_payload.h"
+#include "payload_writer.h"
+#include "batch_payload.h"
+#include "time_utils.h"
 
 TEST(Telemetry_Payload_V1, has_version_and_field) {
     std::string client_id = "pi-sim-01";
@@ -61,4 +67,162 @@ TEST(Health_payload_V1, has_version_and_field) {
     EXPECT_EQ(payload["counters"]["publish_fail"], publish_fail);
     EXPECT_EQ(payload["counters"]["reconnects"], reconnects);
     EXPECT_EQ(payload["timestamp_s"], now_s);
-}
\ No newline at end of file
+}
+
+TEST(Payload_Writer, telemetry_matches_json_dump) {
+    TelemetryPayloadWriter writer("pi-sim-01", "temperature", "C");
+    const double values[] = {0.0, -0.0, 85.0, 382.5, 0.1, -3.25, 1e-7, 1e21, 123456789.125,
+                             -8.481620698703041e+18, 1.3164367751946823e+15, 5e-324};
+
+    std::uint64_t seq = 0;
+    for (double value : values) {
+        const std::int64_t ts = 1771375779 + static_cast<std::int64_t>(seq);
+        const auto expected = make_payload_v1("pi-sim-01", "temperature", "C", value, seq).dump();
+        // make_payload_v1 stamps the current time, so compare with the same timestamp
+        auto expected_json = nlohmann::json::parse(expected);
+        expected_json["timestamp_s"] = ts;
+        EXPECT_EQ(writer.write(value, seq, ts), expected_json.dump()) << "value=" << value;
+        ++seq;
+    }
+}
+
+TEST(Payload_Writer, telemetry_non_finite_is_null) {
+    TelemetryPayloadWriter writer("pi-sim-01", "temperature", "C");
+    auto expected = make_payload_v1("pi-sim-01", "temperature", "C", std::numeric_limits<double>::quiet_NaN(), 1);
+    expected["timestamp_s"] = 10;
+    EXPECT_EQ(writer.write(std::numeric_limits<double>::quiet_NaN(), 1, 10), expected.dump());
+}
+
+TEST(Payload_Writer, telemetry_escapes_constant_fields) {
+    TelemetryPayloadWriter writer("dev\"ice\\01", "t\temp", "\xc2\xb0" "C");
+    auto expected = make_payload_v1("dev\"ice\\01", "t\temp", "\xc2\xb0" "C", 1.5, 2);
+    expected["timestamp_s"] = 3;
+    EXPECT_EQ(writer.write(1.5, 2, 3), expected.dump());
+}
+
+TEST(Payload_Writer, health_matches_json_dump) {
+    HealthPayloadWriter writer("pi-sim-01");
+    HealthCounters counters;
+    counters.publish_ok = 18;
+    counters.publish_fail = 14;
+    counters.reconnects = 7;
+    counters.overruns = 3;
+
+    const auto expected = make_health_payload_v1("pi-sim-01", 15, 15, counters, 1771375777).dump();
+    EXPECT_EQ(writer.write(15, 15, counters, 1771375777), expected);
+}
+
+TEST(Payload_Writer, health_with_latency_matches_json_dump) {
+    HealthPayloadWriter writer("pi-sim-01");
+    HealthCounters counters;
+    counters.publish_ok = 18;
+    LatencyReport latency;
+    latency.sample = LatencySummary{100, 40, 3, 7, 39};
+    latency.ack = LatencySummary{90, 12000, 1800, 9000, 11999};
+
+    const auto expected = make_health_payload_v1("pi-sim-01", 15, 15, counters, 1771375777, &latency);
+    EXPECT_EQ(expected["latency_us"]["ack"]["p99"], 9000);
+    EXPECT_EQ(writer.write(15, 15, counters, 1771375777, &latency), expected.dump());
+}
+
+TEST(Payload_Writer, health_with_process_stats_matches_json_dump) {
+    HealthPayloadWriter writer("pi-sim-01");
+    HealthCounters counters;
+    counters.bytes_sent = 4096;
+    counters.queue_depth = 12;
+    LatencyReport latency;
+    ProcessStatsReader reader;
+    const auto process = reader.read();
+    EXPECT_GT(process.rss_kb, 0u);
+
+    const auto expected = make_health_payload_v1("pi-sim-01", 15, 15, counters, 1771375777, &latency, &process);
+    EXPECT_EQ(expected["process"]["rss_kb"], process.rss_kb);
+    EXPECT_EQ(expected["counters"]["bytes_sent"], 4096);
+    EXPECT_EQ(writer.write(15, 15, counters, 1771375777, &latency, &process), expected.dump());
+}
+
+TEST(Payload_Writer, status_matches_json_dump) {
+    StatusPayloadWriter writer("pi-sim-01");
+    for (const char* state : {"online", "offline"}) {
+        auto expected = make_status_payload_v1("pi-sim-01", state);
+        expected["timestamp_s"] = 1771375762;
+        EXPECT_EQ(writer.write(state, 1771375762), expected.dump());
+    }
+}
+
+TEST(Payload_Writer, status_with_content_type_matches_json_dump) {
+    StatusPayloadWriter writer("pi-sim-01", "application/msgpack");
+    auto expected = make_status_payload_v1("pi-sim-01", "online", "application/msgpack");
+    expected["timestamp_s"] = 1771375762;
+    EXPECT_EQ(writer.write("online", 1771375762), expected.dump());
+}
+
+TEST(Batch_Payload_V1, writer_matches_json_dump) {
+    BatchPayloadWriter writer("pi-sim-01");
+    const auto temp = writer.add_metric("temperature", "C");
+    const auto hum = writer.add_metric("humidity", "%");
+
+    std::vector<BatchReading> readings = {
+        {"temperature", "C", 21.25, 4, 1771375779},
+        {"humidity", "%", 45.5, 4, 1771375779},
+        {"temperature", "C", 21.5, 5, 1771375780},
+    };
+    writer.append(temp, 21.25, 4, 1771375779);
+    writer.append(hum, 45.5, 4, 1771375779);
+    writer.append(temp, 21.5, 5, 1771375780);
+
+    EXPECT_EQ(writer.count(), 3u);
+    const auto expected = make_batch_payload_v1("pi-sim-01", readings).dump();
+    EXPECT_EQ(writer.size_bytes(), expected.size());
+    EXPECT_EQ(writer.finish(), expected);
+}
+
+TEST(Batch_Payload_V1, clear_starts_new_batch) {
+    BatchPayloadWriter writer("pi-sim-01");
+    const auto temp = writer.add_metric("temperature", "C");
+    writer.append(temp, 1.0, 1, 1);
+    (void)writer.finish();
+    writer.clear();
+    EXPECT_TRUE(writer.empty());
+
+    writer.append(temp, 2.0, 2, 2);
+    const std::vector<BatchReading> readings = {{"temperature", "C", 2.0, 2, 2}};
+    EXPECT_EQ(writer.finish(), make_batch_payload_v1("pi-sim-01", readings).dump());
+}
+
+TEST(Batch_Payload_V1, size_bound_covers_reading) {
+    BatchPayloadWriter writer("pi-sim-01");
+    const auto temp = writer.add_metric("temperature", "C");
+    writer.append(temp, 1.0, 1, 1);
+
+    const auto before = writer.size_bytes();
+    writer.append(temp, -1.2345678901234567e-300, UINT64_MAX, INT64_MIN);
+    EXPECT_LE(writer.size_bytes() - before, writer.reading_size_bound(temp));
+}
+
+TEST(Telemetry_Payload_V2, writers_add_timestamp_ms) {
+    TelemetryPayloadWriter writer("pi-sim-01", "temperature", "C", 2);
+    const auto expected = make_payload_v2("pi-sim-01", "temperature", "C", 21.5, 7, 1771375779123);
+    EXPECT_EQ(expected["schema_version"], 2);
+    EXPECT_EQ(expected["timestamp_s"], 1771375779);
+    EXPECT_EQ(writer.write(21.5, 7, 1771375779, 1771375779123), expected.dump());
+
+    BatchPayloadWriter batch("pi-sim-01", 2);
+    const auto temp = batch.add_metric("temperature", "C");
+    batch.append(temp, 21.5, 7, 1771375779, 1771375779123);
+    const std::vector<BatchReading> readings = {{"temperature", "C", 21.5, 7, 1771375779, 1771375779123}};
+    const auto expected_batch = make_batch_payload_v2("pi-sim-01", readings).dump();
+    EXPECT_EQ(batch.size_bytes(), expected_batch.size());
+    EXPECT_EQ(batch.finish(), expected_batch);
+}
+
+TEST(Telemetry_Payload_V2, wall_clock_maps_steady_time_to_unix_ms) {
+    WallClock wall;
+    const auto steady = std::chrono::steady_clock::now();
+    const auto unix_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    EXPECT_NEAR(static_cast<double>(wall.unix_ms(steady)), static_cast<double>(unix_ms), 50.0);
+
+    // a reading taken 1.5 s before the tick keeps its own time
+    EXPECT_EQ(wall.unix_ms(steady) - wall.unix_ms(steady - std::chrono::milliseconds(1500)), 1500);
+}
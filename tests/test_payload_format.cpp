@@ -0,0 +1,75 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <string>
+
+#include "payload_format.h"
+#include "telemetry_payload.h"
+#include "health_payload.h"
+#include "status_payload.h"
+#include "app_config.h"
+
+namespace {
+    nlohmann::json sample_telemetry() {
+        return make_payload_v1("pi-sim-01", "temperature", "C", 21.75, 17, 1771375779);
+    }
+
+    nlohmann::json sample_health() {
+        HealthCounters counters;
+        counters.publish_ok = 18;
+        counters.publish_fail = 14;
+        counters.reconnects = 7;
+        return make_health_payload_v1("pi-sim-01", 15, 15, counters, 1771375777);
+    }
+}
+
+TEST(PayloadFormat, parse_names) {
+    PayloadFormat fmt = PayloadFormat::JsonV1;
+    EXPECT_TRUE(try_parse_payload_format("cbor", fmt));
+    EXPECT_EQ(fmt, PayloadFormat::Cbor);
+    EXPECT_TRUE(try_parse_payload_format("msgpack", fmt));
+    EXPECT_EQ(fmt, PayloadFormat::MsgPack);
+    EXPECT_TRUE(try_parse_payload_format("json_v1", fmt));
+    EXPECT_EQ(fmt, PayloadFormat::JsonV1);
+    EXPECT_FALSE(try_parse_payload_format("protobuf", fmt));
+}
+
+TEST(PayloadFormat, config_rejects_unknown_format) {
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"payload_format", "xml"},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"topic_suffix", "temp"}} })}
+    };
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+
+    jsn["payload_format"] = "cbor";
+    EXPECT_EQ(parse_config_or_throw(jsn).payload_format, PayloadFormat::Cbor);
+}
+
+TEST(PayloadFormat, round_trip_all_payloads) {
+    const nlohmann::json payloads[] = {
+        sample_telemetry(),
+        sample_health(),
+        make_status_payload_v1("pi-sim-01", "online", "application/cbor"),
+    };
+
+    for (const auto& fmt_entry : payload_format_table) {
+        for (const auto& payload : payloads) {
+            const std::string bytes = encode_payload(payload, fmt_entry.fmt);
+            EXPECT_EQ(detect_payload_format(bytes), fmt_entry.fmt) << fmt_entry.name;
+            EXPECT_EQ(decode_payload(bytes), payload) << fmt_entry.name;
+        }
+    }
+}
+
+TEST(PayloadFormat, binary_formats_are_smaller_than_json) {
+    const auto json_size = encode_payload(sample_telemetry(), PayloadFormat::JsonV1).size();
+    const auto cbor_size = encode_payload(sample_telemetry(), PayloadFormat::Cbor).size();
+    const auto msgpack_size = encode_payload(sample_telemetry(), PayloadFormat::MsgPack).size();
+
+    EXPECT_LT(cbor_size, json_size);
+    EXPECT_LT(msgpack_size, json_size);
+    RecordProperty("json_v1_bytes", static_cast<int>(json_size));
+    RecordProperty("cbor_bytes", static_cast<int>(cbor_size));
+    RecordProperty("msgpack_bytes", static_cast<int>(msgpack_size));
+}
@@ -70,4 +70,32 @@ TEST(MqttClientReconnect, on_connect_resets_backoff_and_clears_in_flight) {
     #else
         GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
     #endif
-}
\ No newline at end of file
+}
+
+TEST(MqttClientReconnect, reconnect_due_tracks_backoff_and_in_flight_attempt) {
+    #ifdef UNIT_TESTS
+        MqttClient mqtt("host", 1883, "client_id", 0);
+        mqtt.set_mosq_present_for_test(true);
+
+        TimePoint now = Clock::now();
+        mqtt.set_now_fn_for_test([&]{ return now; });
+        mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_SUCCESS; });
+
+        // never attempted: due now
+        EXPECT_LE(mqtt.reconnect_due(), now);
+
+        // in flight: due when the attempt times out
+        mqtt.tick();
+        EXPECT_EQ(mqtt.reconnect_due(), now + MqttClient::reconnect_in_flight_timeout_for_test());
+
+        // connected: nothing to do
+        mqtt.simulate_connect_for_test(0);
+        EXPECT_EQ(mqtt.reconnect_due(), TimePoint::max());
+
+        // dropped: the next backoff attempt
+        mqtt.simulate_disconnect_for_test(7);
+        EXPECT_EQ(mqtt.reconnect_due(), mqtt.backoff_next_time_for_test());
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include "ring_buffer.h"
+
+TEST(RingBuffer, fifo_order) {
+    RingBuffer<int> ring(4);
+    for (int i = 0; i < 3; ++i) EXPECT_TRUE(ring.push(i));
+
+    EXPECT_EQ(ring.size(), 3u);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(ring.front(), i);
+        ring.pop();
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(RingBuffer, drop_oldest_overwrites_front) {
+    RingBuffer<int> ring(3, OverflowPolicy::DropOldest);
+    for (int i = 0; i < 5; ++i) EXPECT_TRUE(ring.push(i));
+
+    EXPECT_EQ(ring.size(), 3u);
+    EXPECT_EQ(ring.dropped(), 2u);
+    EXPECT_EQ(ring.at(0), 2);
+    EXPECT_EQ(ring.at(1), 3);
+    EXPECT_EQ(ring.at(2), 4);
+}
+
+TEST(RingBuffer, drop_newest_rejects_when_full) {
+    RingBuffer<int> ring(3, OverflowPolicy::DropNewest);
+    for (int i = 0; i < 3; ++i) EXPECT_TRUE(ring.push(i));
+    EXPECT_FALSE(ring.push(3));
+    EXPECT_FALSE(ring.push(4));
+
+    EXPECT_EQ(ring.size(), 3u);
+    EXPECT_EQ(ring.dropped(), 2u);
+    EXPECT_EQ(ring.front(), 0);
+}
+
+TEST(RingBuffer, wraps_around) {
+    RingBuffer<int> ring(3);
+    int next = 0;
+    for (int round = 0; round < 10; ++round) {
+        ring.push(next++);
+        ring.push(next++);
+        ring.pop(2);
+    }
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.dropped(), 0u);
+
+    ring.push(100);
+    EXPECT_EQ(ring.front(), 100);
+}
+
+TEST(RingBuffer, take_front_if_keeps_skipped_elements_in_order) {
+    RingBuffer<int> ring(6);
+    ring.push(0);
+    ring.pop(); // start off the first slot so the elements wrap
+    for (int i = 1; i <= 6; ++i) ring.push(i);
+
+    // odd ones stay; stops before 5
+    const auto taken = ring.take_front_if([](int value) {
+        if (value == 5) return RingVisit::Stop;
+        return value % 2 == 0 ? RingVisit::Take : RingVisit::Skip;
+    });
+    EXPECT_EQ(taken, 2u);
+    ASSERT_EQ(ring.size(), 4u);
+    EXPECT_EQ(ring.at(0), 1);
+    EXPECT_EQ(ring.at(1), 3);
+    EXPECT_EQ(ring.at(2), 5);
+    EXPECT_EQ(ring.at(3), 6);
+
+    EXPECT_EQ(ring.take_front_if([](int) { return RingVisit::Take; }), 4u);
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.dropped(), 0u);
+}
+
+TEST(RingBuffer, zero_capacity_drops_everything) {
+    RingBuffer<int> ring(0);
+    EXPECT_FALSE(ring.push(1));
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.dropped(), 1u);
+}
+
+TEST(RingBuffer, parse_policy) {
+    OverflowPolicy policy = OverflowPolicy::DropOldest;
+    EXPECT_TRUE(try_parse_overflow_policy("drop_newest", policy));
+    EXPECT_EQ(policy, OverflowPolicy::DropNewest);
+    EXPECT_FALSE(try_parse_overflow_policy("drop_random", policy));
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <vector>
+
+#include "scheduler.h"
+
+using namespace std::chrono_literals;
+
+TEST(DeadlineScheduler, first_deadline_is_due_immediately) {
+    DeadlineScheduler scheduler;
+    const auto start = DeadlineScheduler::Clock::now();
+    scheduler.add(100ms, start);
+
+    std::vector<std::size_t> due;
+    scheduler.collect_due(start, due);
+    ASSERT_EQ(due.size(), 1u);
+    EXPECT_EQ(due[0], 0u);
+    EXPECT_EQ(scheduler.next_deadline(), start + 100ms);
+}
+
+TEST(DeadlineScheduler, late_tick_does_not_drift) {
+    DeadlineScheduler scheduler;
+    const auto start = DeadlineScheduler::Clock::now();
+    scheduler.add(100ms, start);
+
+    std::vector<std::size_t> due;
+    scheduler.collect_due(start + 30ms, due);
+    // next deadline stays on the 100ms grid, not 30ms + 100ms
+    EXPECT_EQ(scheduler.next_deadline(), start + 100ms);
+    EXPECT_EQ(scheduler.overruns(), 0u);
+}
+
+TEST(DeadlineScheduler, independent_periods) {
+    DeadlineScheduler scheduler;
+    const auto start = DeadlineScheduler::Clock::now();
+    const auto fast = scheduler.add(100ms, start);   // 10 Hz
+    const auto slow = scheduler.add(10s, start);     // 0.1 Hz
+
+    int fast_count = 0;
+    int slow_count = 0;
+    std::vector<std::size_t> due;
+    for (auto now = start; now < start + 10s; now += 100ms) {
+        due.clear();
+        scheduler.collect_due(now, due);
+        for (auto id : due) {
+            if (id == fast) ++fast_count;
+            if (id == slow) ++slow_count;
+        }
+    }
+    EXPECT_EQ(fast_count, 100);
+    EXPECT_EQ(slow_count, 1);
+}
+
+TEST(DeadlineScheduler, missed_deadlines_count_overruns_and_skip_ahead) {
+    DeadlineScheduler scheduler;
+    const auto start = DeadlineScheduler::Clock::now();
+    scheduler.add(100ms, start);
+
+    std::vector<std::size_t> due;
+    scheduler.collect_due(start, due);
+
+    // stalled for 350ms: deadlines at 100, 200, 300 were due, only one tick fires
+    due.clear();
+    scheduler.collect_due(start + 350ms, due);
+    EXPECT_EQ(due.size(), 1u);
+    EXPECT_EQ(scheduler.overruns(), 2u);
+    EXPECT_EQ(scheduler.next_deadline(), start + 400ms);
+}
+
+TEST(DeadlineScheduler, due_ids_in_ascending_order) {
+    DeadlineScheduler scheduler;
+    const auto start = DeadlineScheduler::Clock::now();
+    for (int i = 0; i < 5; ++i) scheduler.add(100ms, start);
+
+    std::vector<std::size_t> due;
+    scheduler.collect_due(start, due);
+    ASSERT_EQ(due.size(), 5u);
+    for (std::size_t i = 0; i < due.size(); ++i) EXPECT_EQ(due[i], i);
+}
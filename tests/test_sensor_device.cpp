@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "app_config.h"
+#include "sensor_device.h"
+#include "sensor_factory.h"
+#include "simulated_sensor.h"
+
+namespace {
+    class CountingSensor final : public ISensor {
+        public:
+            bool init() override { return true; }
+            std::optional<Reading> sample() override {
+                ++calls;
+                if (calls % 2 == 0) return std::nullopt;
+                return Reading{"legacy", "u", static_cast<double>(calls)};
+            }
+            std::string_view name() const override { return "legacy"; }
+            int calls = 0;
+    };
+
+    MetricConfig metric(std::string name, std::string type) {
+        MetricConfig out;
+        out.name = std::move(name);
+        out.type = std::move(type);
+        out.unit = "u";
+        out.start = 1.0;
+        out.step = 1.0;
+        out.topic_suffix = out.name;
+        return out;
+    }
+}
+
+TEST(SensorDevice, group_fills_records_by_metric_id) {
+    SensorGroup<SimulatedSensor> group("simulated");
+    group.add(3, std::make_unique<SimulatedSensor>("a", "u", 1.0, 1.0));
+    group.add(7, std::make_unique<SimulatedSensor>("b", "u", 1.0, 10.0));
+    ASSERT_TRUE(group.init());
+
+    std::vector<SampleRecord> records{SampleRecord{.metric = 7}, SampleRecord{.metric = 3}};
+    group.sample(records);
+    group.sample(records);
+    EXPECT_EQ(records[0].status, SampleStatus::Ok);
+    EXPECT_DOUBLE_EQ(records[0].value, 10.0); // second sample of b
+    EXPECT_DOUBLE_EQ(records[1].value, 1.0);  // second sample of a
+    EXPECT_NE(records[0].timestamp_ns, 0);
+}
+
+TEST(SensorDevice, adapter_wraps_legacy_sensors) {
+    SensorAdapter adapter("legacy");
+    auto sensor = std::make_unique<CountingSensor>();
+    auto* raw = sensor.get();
+    adapter.add(0, std::move(sensor));
+    ASSERT_TRUE(adapter.init());
+
+    std::vector<SampleRecord> records{SampleRecord{.metric = 0}};
+    adapter.sample(records);
+    EXPECT_EQ(records[0].status, SampleStatus::Ok);
+    EXPECT_DOUBLE_EQ(records[0].value, 1.0);
+    adapter.sample(records);
+    EXPECT_EQ(records[0].status, SampleStatus::NoData);
+    EXPECT_EQ(raw->calls, 2);
+}
+
+TEST(SensorDevice, factory_groups_metrics_by_type) {
+    const std::vector<MetricConfig> metrics{
+        metric("a", "simulated"), metric("b", "meminfo"), metric("c", "simulated"), metric("d", "no_such_type")
+    };
+    const auto set = make_sensor_devices(metrics);
+    ASSERT_EQ(set.devices.size(), 3u); // simulated, meminfo, legacy adapter for the unknown type
+    EXPECT_EQ(set.device_of[0], set.device_of[2]);
+    EXPECT_NE(set.device_of[0], set.device_of[1]);
+    EXPECT_EQ(set.devices[set.device_of[0]]->name(), "simulated");
+    EXPECT_EQ(set.devices[set.device_of[3]]->name(), "legacy");
+}
+
+TEST(SensorDevice, one_device_call_samples_every_metric_of_its_type) {
+    std::vector<MetricConfig> metrics;
+    for (int i = 0; i < 300; ++i) metrics.push_back(metric("metric_" + std::to_string(i), "simulated"));
+    auto set = make_sensor_devices(metrics);
+    ASSERT_EQ(set.devices.size(), 1u);
+    ASSERT_TRUE(set.devices[0]->init());
+
+    std::vector<SampleRecord> records;
+    for (std::uint32_t id = 0; id < metrics.size(); ++id) records.push_back(SampleRecord{.metric = id});
+    set.devices[0]->sample(records);
+    set.devices[0]->sample(records);
+    for (const auto& record : records) {
+        EXPECT_EQ(record.status, SampleStatus::Ok);
+        EXPECT_DOUBLE_EQ(record.value, 1.0);
+    }
+}
+
+TEST(SensorDevice, rebuild_keeps_running_sensors_of_kept_metrics) {
+    auto running = make_sensor_devices({metric("a", "simulated"), metric("b", "simulated")});
+    ASSERT_TRUE(running.devices[0]->init());
+    std::vector<SampleRecord> records{SampleRecord{.metric = 0}, SampleRecord{.metric = 1}};
+    running.devices[0]->sample(records);
+    running.devices[0]->sample(records);
+
+    // reload: "b" is kept (now first), "a" is gone, "c" is new
+    const std::vector<MetricConfig> metrics{metric("b", "simulated"), metric("c", "simulated")};
+    auto set = rebuild_sensor_devices(running, metrics, {1, -1});
+    ASSERT_EQ(set.devices.size(), 2u);
+    EXPECT_NE(set.device_of[0], set.device_of[1]);
+    EXPECT_EQ(set.channel_of[0], 1u);
+
+    std::vector<SampleRecord> kept{SampleRecord{.metric = set.channel_of[0]}};
+    set.devices[set.device_of[0]]->sample(kept);
+    EXPECT_DOUBLE_EQ(kept[0].value, 2.0); // carries on counting
+
+    std::vector<SampleRecord> fresh{SampleRecord{.metric = set.channel_of[1]}};
+    set.devices[set.device_of[1]]->sample(fresh);
+    EXPECT_DOUBLE_EQ(fresh[0].value, 0.0);
+}
+
+TEST(SensorDevice, rebuild_closes_sensors_of_removed_metrics_in_a_kept_device) {
+    auto c = metric("c", "simulated");
+    c.start = 20.0;
+    auto running = make_sensor_devices({metric("a", "simulated"), metric("b", "simulated"), c});
+    ASSERT_TRUE(running.devices[0]->init());
+    std::vector<SampleRecord> records{SampleRecord{.metric = 0}, SampleRecord{.metric = 1}, SampleRecord{.metric = 2}};
+    running.devices[0]->sample(records);
+
+    // reload: "b" is gone, "a" and "c" stay on the same device
+    const std::vector<MetricConfig> metrics{metric("a", "simulated"), c};
+    auto set = rebuild_sensor_devices(running, metrics, {0, 2});
+    ASSERT_EQ(set.devices.size(), 1u);
+    auto* group = dynamic_cast<SensorGroup<SimulatedSensor>*>(set.devices[0].get());
+    ASSERT_NE(group, nullptr);
+    EXPECT_EQ(group->size(), 2u);
+
+    std::vector<SampleRecord> kept{SampleRecord{.metric = set.channel_of[0]}, SampleRecord{.metric = set.channel_of[1]}};
+    set.devices[0]->sample(kept);
+    EXPECT_DOUBLE_EQ(kept[0].value, 1.0);
+    EXPECT_DOUBLE_EQ(kept[1].value, 20.0);
+}
@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "app_config.h"
+#include "mqtt_client.h"
+#include "telemetry_publisher.h"
+#include "topic_builder.h"
+
+namespace {
+    nlohmann::json sharded_config(int connections) {
+        auto metrics = nlohmann::json::array();
+        for (int i = 0; i < 16; ++i) {
+            metrics.push_back({{"name", "m" + std::to_string(i)}, {"topic_suffix", "m" + std::to_string(i)}});
+        }
+        return {
+            {"client_id", "gw-01"},
+            {"broker", {{"connections", connections}}},
+            {"metrics", metrics}
+        };
+    }
+}
+
+TEST(Shards, topics_map_to_stable_sessions) {
+    EXPECT_EQ(make_shard_client_id("gw-01", 3), "gw-01-s3");
+    EXPECT_EQ(topic_shard("devices/gw-01/temp", 1), 0u);
+
+    std::set<std::size_t> used;
+    for (int i = 0; i < 64; ++i) {
+        const auto topic = make_topic("gw-01", "m" + std::to_string(i));
+        const auto shard = topic_shard(topic, 4);
+        EXPECT_LT(shard, 4u);
+        EXPECT_EQ(topic_shard(topic, 4), shard);
+        used.insert(shard);
+    }
+    EXPECT_EQ(used.size(), 4u);
+}
+
+TEST(Shards, config_is_validated) {
+    EXPECT_EQ(parse_config_or_throw(sharded_config(4)).connections, 4);
+    EXPECT_EQ(parse_config_or_throw(sharded_config(1)).connections, 1);
+    EXPECT_THROW(parse_config_or_throw(sharded_config(0)), std::runtime_error);
+
+    auto jsn = sharded_config(2);
+    jsn["event_loop"] = "epoll";
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+}
+
+TEST(Shards, publisher_routes_topics_and_keeps_status_on_the_primary) {
+    #ifdef UNIT_TESTS
+        const AppConfig cfg = parse_config_or_throw(sharded_config(2));
+        std::vector<std::string> primary_topics; // outlive the clients, whose destructors publish offline status
+        std::vector<std::string> shard_topics;
+
+        MqttClient primary("host", 1883, cfg.client_id, 1);
+        MqttClient shard("host", 1883, make_shard_client_id(cfg.client_id, 1), 1);
+        shard.disable_status();
+        for (auto* client : {&primary, &shard}) {
+            auto& topics = client == &primary ? primary_topics : shard_topics;
+            client->set_mosq_present_for_test(true);
+            client->set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+            client->set_publish_fn_for_test([&topics](int*, const char* topic, int, const void*, int, bool, const MessageProps&) {
+                topics.emplace_back(topic);
+                return MOSQ_ERR_SUCCESS;
+            });
+            client->simulate_connect_for_test(0);
+        }
+        EXPECT_EQ(primary_topics, std::vector<std::string>{"devices/gw-01/status"});
+        EXPECT_TRUE(shard_topics.empty());
+        primary_topics.clear();
+
+        TelemetryPublisher publisher(primary, cfg);
+        publisher.set_shards({&shard});
+        for (std::uint32_t metric = 0; metric < 16; ++metric) publisher.publish_reading(PendingReading{metric, 1.0, metric, 100});
+
+        EXPECT_EQ(primary_topics.size() + shard_topics.size(), 16u);
+        EXPECT_FALSE(primary_topics.empty());
+        EXPECT_FALSE(shard_topics.empty());
+        for (const auto& topic : primary_topics) EXPECT_EQ(topic_shard(topic, 2), 0u);
+        for (const auto& topic : shard_topics) EXPECT_EQ(topic_shard(topic, 2), 1u);
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
+
+TEST(Shards, replay_goes_on_while_a_shard_is_down) {
+    #ifdef UNIT_TESTS
+        const AppConfig cfg = parse_config_or_throw(sharded_config(2));
+        std::vector<std::string> primary_topics; // outlive the clients, whose destructors publish offline status
+        std::vector<std::string> shard_topics;
+
+        MqttClient primary("host", 1883, cfg.client_id, 1);
+        MqttClient shard("host", 1883, make_shard_client_id(cfg.client_id, 1), 1);
+        shard.disable_status();
+        for (auto* client : {&primary, &shard}) {
+            auto& topics = client == &primary ? primary_topics : shard_topics;
+            client->set_mosq_present_for_test(true);
+            client->set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+            client->set_publish_fn_for_test([&topics](int*, const char* topic, int, const void*, int, bool, const MessageProps&) {
+                topics.emplace_back(topic);
+                return MOSQ_ERR_SUCCESS;
+            });
+        }
+
+        TelemetryPublisher publisher(primary, cfg);
+        publisher.set_shards({&shard});
+        // two rounds while both sessions are down
+        for (std::uint64_t seq = 0; seq < 32; ++seq) {
+            publisher.publish_reading(PendingReading{static_cast<std::uint32_t>(seq % 16), 1.0, seq, 100});
+        }
+        EXPECT_EQ(publisher.counters().buffered, 32u);
+
+        primary.simulate_connect_for_test(0);
+        primary_topics.clear(); // online status
+        const auto start = TelemetryPublisher::Clock::now();
+        publisher.service(start);
+        publisher.service(start + std::chrono::seconds(1));
+
+        // the primary's readings went out in order; the shard's keep waiting
+        const auto held = publisher.counters().buffered;
+        EXPECT_EQ(primary_topics.size() + held, 32u);
+        EXPECT_FALSE(primary_topics.empty());
+        EXPECT_GT(held, 0u);
+        EXPECT_TRUE(shard_topics.empty());
+        for (std::size_t i = 0; i < primary_topics.size() / 2; ++i) EXPECT_EQ(primary_topics[i], primary_topics[i + primary_topics.size() / 2]);
+
+        shard.simulate_connect_for_test(0);
+        publisher.service(start + std::chrono::seconds(2));
+        EXPECT_EQ(shard_topics.size(), held);
+        EXPECT_EQ(publisher.counters().buffered, 0u);
+        for (const auto& topic : shard_topics) EXPECT_EQ(topic_shard(topic, 2), 1u);
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.h"
+
+TEST(SpscQueue, capacity_rounds_up_to_power_of_two) {
+    SpscQueue<int> queue(100);
+    EXPECT_EQ(queue.capacity(), 128u);
+}
+
+TEST(SpscQueue, fifo_order_and_full_rejects) {
+    SpscQueue<int> queue(4);
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(queue.try_push(i));
+    EXPECT_FALSE(queue.try_push(99));
+    EXPECT_EQ(queue.size_approx(), 4u);
+
+    int out[8] = {};
+    ASSERT_EQ(queue.pop_bulk(out, 8), 4u);
+    for (int i = 0; i < 4; ++i) EXPECT_EQ(out[i], i);
+    EXPECT_EQ(queue.pop_bulk(out, 8), 0u);
+}
+
+TEST(SpscQueue, wraps_around) {
+    SpscQueue<int> queue(4);
+    int next_in = 0;
+    int next_out = 0;
+    for (int round = 0; round < 10; ++round) {
+        for (int i = 0; i < 3; ++i) ASSERT_TRUE(queue.try_push(next_in++));
+        int value = -1;
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_TRUE(queue.try_pop(value));
+            EXPECT_EQ(value, next_out++);
+        }
+    }
+}
+
+TEST(SpscQueue, producer_and_consumer_threads_see_every_record_in_order) {
+    struct Record {
+        std::uint64_t seq;
+        double value;
+    };
+    constexpr std::uint64_t total = 200000;
+    SpscQueue<Record> queue(64);
+
+    std::thread producer([&] {
+        for (std::uint64_t seq = 0; seq < total; ++seq) {
+            while (!queue.try_push(Record{seq, static_cast<double>(seq) * 0.5})) std::this_thread::yield();
+        }
+    });
+
+    std::vector<Record> batch(16);
+    std::uint64_t expected = 0;
+    bool in_order = true;
+    while (expected < total) {
+        const std::size_t count = queue.pop_bulk(batch.data(), batch.size());
+        if (count == 0) { std::this_thread::yield(); continue; }
+        for (std::size_t i = 0; i < count; ++i) {
+            in_order &= batch[i].seq == expected && batch[i].value == static_cast<double>(expected) * 0.5;
+            ++expected;
+        }
+    }
+    producer.join();
+
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(queue.size_approx(), 0u);
+}
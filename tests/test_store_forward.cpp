@@ -0,0 +1,216 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "app_config.h"
+#include "mqtt_client.h"
+#include "telemetry_publisher.h"
+#include "time_utils.h"
+
+#include <unistd.h>
+
+using namespace std::chrono_literals;
+
+namespace {
+    AppConfig make_config(int capacity, int replay_per_s, bool batch) {
+        nlohmann::json jsn = {
+            {"client_id", "pi-sim-01"},
+            {"store_forward", {{"capacity", capacity}, {"replay_per_s", replay_per_s}}},
+            {"batch", {{"enabled", batch}, {"max_ticks", 1}}},
+            {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"unit", "C"}, {"topic_suffix", "temp"}} })}
+        };
+        return parse_config_or_throw(jsn);
+    }
+
+    struct Sent {
+        std::string topic;
+        std::string payload;
+    };
+}
+
+TEST(StoreForward, buffers_while_offline_and_replays_rate_limited) {
+    #ifdef UNIT_TESTS
+    const auto cfg = make_config(8, 2, false);
+    std::vector<Sent> sent; // outlives mqtt, whose destructor publishes offline status
+    MqttClient mqtt("host", 1883, "pi-sim-01", 1);
+    mqtt.set_mosq_present_for_test(true);
+    mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+
+    mqtt.set_publish_fn_for_test([&](int*, const char* topic, int len, const void* payload, int, bool, const MessageProps&) {
+        sent.push_back(Sent{topic, std::string(static_cast<const char*>(payload), static_cast<std::size_t>(len))});
+        return MOSQ_ERR_SUCCESS;
+    });
+
+    TelemetryPublisher publisher(mqtt, cfg);
+    for (std::uint64_t seq = 0; seq < 5; ++seq) publisher.publish_reading(PendingReading{0, 1.0, seq, 100});
+
+    EXPECT_TRUE(sent.empty());
+    EXPECT_EQ(publisher.counters().buffered, 5u);
+    EXPECT_EQ(publisher.counters().publish_fail, 5u);
+
+    mqtt.simulate_connect_for_test(0);
+    sent.clear(); // online status
+
+    const auto start = TelemetryPublisher::Clock::now();
+    publisher.service(start);
+    publisher.service(start + 1s); // 2 tokens
+    EXPECT_EQ(sent.size(), 2u);
+    EXPECT_EQ(publisher.counters().replayed, 2u);
+    EXPECT_EQ(nlohmann::json::parse(sent[0].payload)["seq"], 0);
+    EXPECT_EQ(nlohmann::json::parse(sent[1].payload)["seq"], 1);
+
+    publisher.service(start + 10s); // burst is capped at one second of tokens
+    EXPECT_EQ(sent.size(), 4u);
+    publisher.service(start + 11s);
+    EXPECT_EQ(sent.size(), 5u);
+    EXPECT_EQ(publisher.counters().buffered, 0u);
+    EXPECT_EQ(publisher.counters().replayed, 5u);
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
+
+TEST(StoreForward, overflow_counts_drops) {
+    #ifdef UNIT_TESTS
+    const auto cfg = make_config(3, 10, false);
+    MqttClient mqtt("host", 1883, "pi-sim-01", 1);
+    mqtt.set_mosq_present_for_test(true);
+    mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+
+    TelemetryPublisher publisher(mqtt, cfg);
+    for (std::uint64_t seq = 0; seq < 10; ++seq) publisher.publish_reading(PendingReading{0, 1.0, seq, 100});
+
+    EXPECT_EQ(publisher.counters().buffered, 3u);
+    EXPECT_EQ(publisher.counters().dropped, 7u);
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
+
+TEST(StoreForward, summaries_are_dropped_without_the_spool) {
+    #ifdef UNIT_TESTS
+    const auto cfg = make_config(8, 10, false);
+    std::vector<Sent> sent;
+    MqttClient mqtt("host", 1883, "pi-sim-01", 1);
+    mqtt.set_mosq_present_for_test(true);
+    mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+    mqtt.set_publish_fn_for_test([&](int*, const char* topic, int len, const void* payload, int, bool, const MessageProps&) {
+        sent.push_back(Sent{topic, std::string(static_cast<const char*>(payload), static_cast<std::size_t>(len))});
+        return MOSQ_ERR_SUCCESS;
+    });
+
+    TelemetryPublisher publisher(mqtt, cfg);
+    WindowSummary summary;
+    summary.count = 10;
+    summary.min = 1.0;
+    summary.max = 3.0;
+    summary.mean = 2.0;
+    publisher.publish_summary(PendingReading{0, summary.mean, 0, 100}, summary);
+
+    // a plain reading of the mean would replay without the window statistics
+    EXPECT_EQ(publisher.counters().buffered, 0u);
+    EXPECT_EQ(publisher.counters().dropped, 1u);
+
+    mqtt.simulate_connect_for_test(0);
+    sent.clear(); // online status
+    const auto start = TelemetryPublisher::Clock::now();
+    publisher.service(start);
+    publisher.service(start + 1s);
+    EXPECT_TRUE(sent.empty());
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
+
+TEST(StoreForward, batch_mode_replays_as_batches) {
+    #ifdef UNIT_TESTS
+    const auto cfg = make_config(16, 100, true);
+    std::vector<Sent> sent; // outlives mqtt, whose destructor publishes offline status
+    MqttClient mqtt("host", 1883, "pi-sim-01", 1);
+    mqtt.set_mosq_present_for_test(true);
+    mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+
+    mqtt.set_publish_fn_for_test([&](int*, const char* topic, int len, const void* payload, int, bool, const MessageProps&) {
+        sent.push_back(Sent{topic, std::string(static_cast<const char*>(payload), static_cast<std::size_t>(len))});
+        return MOSQ_ERR_SUCCESS;
+    });
+
+    TelemetryPublisher publisher(mqtt, cfg);
+    for (std::uint64_t seq = 0; seq < 4; ++seq) {
+        publisher.publish_reading(PendingReading{0, 1.0, seq, 100});
+        publisher.end_tick();
+    }
+    EXPECT_EQ(publisher.counters().buffered, 4u);
+
+    mqtt.simulate_connect_for_test(0);
+    sent.clear();
+
+    const auto start = TelemetryPublisher::Clock::now();
+    publisher.service(start);
+    publisher.service(start + 1s);
+    ASSERT_EQ(sent.size(), 1u);
+    EXPECT_EQ(sent[0].topic, "devices/pi-sim-01/batch");
+    EXPECT_EQ(nlohmann::json::parse(sent[0].payload)["readings"].size(), 4u);
+    EXPECT_EQ(publisher.counters().replayed, 4u);
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
+
+TEST(StoreForward, spool_survives_restart_and_replays) {
+    #ifdef UNIT_TESTS
+    char tmpl[] = "/tmp/spool_sf_XXXXXX";
+    const std::string dir = ::mkdtemp(tmpl);
+
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"spool", {{"enabled", true}, {"dir", dir}}},
+        {"store_forward", {{"replay_per_s", 100}}},
+        {"metrics", nlohmann::json::array({ {{"name", "temperature"}, {"unit", "C"}, {"topic_suffix", "temp"}} })}
+    };
+    const auto cfg = parse_config_or_throw(jsn);
+    const auto now = unix_time_s();
+
+    std::vector<Sent> sent;
+    MqttClient mqtt("host", 1883, "pi-sim-01", 1);
+    mqtt.set_mosq_present_for_test(true);
+    mqtt.set_reconnect_fn_for_test([] { return MOSQ_ERR_NO_CONN; });
+    mqtt.set_publish_fn_for_test([&](int*, const char* topic, int len, const void* payload, int, bool, const MessageProps&) {
+        sent.push_back(Sent{topic, std::string(static_cast<const char*>(payload), static_cast<std::size_t>(len))});
+        return MOSQ_ERR_SUCCESS;
+    });
+
+    {
+        TelemetryPublisher publisher(mqtt, cfg);
+        for (std::uint64_t seq = 0; seq < 3; ++seq) publisher.publish_reading(PendingReading{0, 1.0, seq, now * 1000});
+        EXPECT_EQ(publisher.counters().buffered, 3u);
+        publisher.flush();
+    } // "restart"
+
+    {
+        TelemetryPublisher publisher(mqtt, cfg);
+        EXPECT_EQ(publisher.counters().buffered, 3u);
+
+        mqtt.simulate_connect_for_test(0);
+        sent.clear(); // online status
+
+        const auto start = TelemetryPublisher::Clock::now();
+        publisher.service(start);
+        publisher.service(start + 1s);
+        ASSERT_EQ(sent.size(), 3u);
+        EXPECT_EQ(sent[0].topic, "devices/pi-sim-01/temp");
+        for (std::size_t i = 0; i < sent.size(); ++i) {
+            EXPECT_EQ(nlohmann::json::parse(sent[i].payload)["seq"], i);
+        }
+        EXPECT_EQ(publisher.counters().buffered, 0u);
+        EXPECT_EQ(publisher.counters().replayed, 3u);
+    }
+
+    std::filesystem::remove_all(dir);
+    #else
+        GTEST_SKIP() << "Compile with -DUNIT_TESTS to enable test hooks.";
+    #endif
+}
@@ -0,0 +1,150 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include "app_config.h"
+#include "proc_file.h"
+#include "sensor_factory.h"
+#include "system_sensors.h"
+
+using namespace std::chrono_literals;
+
+namespace fs = std::filesystem;
+
+namespace {
+    struct TempDir {
+        TempDir() {
+            char tmpl[] = "/tmp/sysfs_test_XXXXXX";
+            path = ::mkdtemp(tmpl);
+        }
+        ~TempDir() { fs::remove_all(path); }
+        fs::path path;
+    };
+
+    // rewrites in place (same inode), like procfs/sysfs regenerating the file behind an open fd
+    void write_file(const fs::path& path, const std::string& contents) {
+        std::ofstream out(path, std::ios::trunc);
+        out << contents;
+    }
+
+    constexpr const char* k_net_dev =
+        "Inter-|   Receive                                                |  Transmit\n"
+        " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n"
+        "    lo:    1000      10    0    0    0     0          0         0     1000      10    0    0    0     0       0          0\n";
+}
+
+TEST(ProcParse, find_line_matches_whole_keys) {
+    const std::string text = "cpu  10 20\ncpu0 1 2\ncpu1 3 4\n  eth0: 5 6\nMemFree:  42 kB\n";
+    EXPECT_EQ(proc_parse::find_line(text, "cpu").value(), " 10 20");
+    EXPECT_EQ(proc_parse::find_line(text, "cpu1").value(), "3 4");
+    EXPECT_EQ(proc_parse::find_line(text, "eth0").value(), " 5 6");
+    EXPECT_FALSE(proc_parse::find_line(text, "cpu2"));
+    EXPECT_FALSE(proc_parse::find_line(text, "Mem"));
+
+    std::uint64_t values[4] = {};
+    EXPECT_EQ(proc_parse::parse_u64s(*proc_parse::find_line(text, "MemFree"), values, 4), 1u);
+    EXPECT_EQ(values[0], 42u);
+    EXPECT_EQ(proc_parse::parse_i64(" -1500\n").value(), -1500);
+}
+
+TEST(ProcParse, counter_rate_skips_first_sample_and_resets) {
+    CounterRate rate;
+    const CounterRate::TimePoint t0{};
+    EXPECT_FALSE(rate.update(100, t0));
+    EXPECT_DOUBLE_EQ(rate.update(300, t0 + 2s).value(), 100.0);
+    EXPECT_FALSE(rate.update(50, t0 + 3s)); // counter went backwards
+    EXPECT_DOUBLE_EQ(rate.update(150, t0 + 4s).value(), 100.0);
+}
+
+TEST(SystemSensors, cpu_usage_from_stat_deltas) {
+    TempDir dir;
+    const auto stat = dir.path / "stat";
+    write_file(stat, "cpu  100 0 100 800 0 0 0 0 0 0\ncpu0 50 0 50 400 0 0 0 0 0 0\nintr 12345 0 0\n");
+
+    CpuUsageSensor sensor("cpu", "%", "cpu", stat.string());
+    ASSERT_TRUE(sensor.init());
+    EXPECT_FALSE(sensor.sample()); // no jiffies elapsed yet
+
+    // +60 busy, +40 idle/iowait
+    write_file(stat, "cpu  150 0 110 820 20 0 0 0 0 0\ncpu0 75 0 55 410 10 0 0 0 0 0\nintr 12346 0 0\n");
+    const auto reading = sensor.sample();
+    ASSERT_TRUE(reading);
+    EXPECT_DOUBLE_EQ(reading->value, 60.0);
+
+    CpuUsageSensor missing("cpu", "%", "cpu7", stat.string());
+    EXPECT_FALSE(missing.init());
+}
+
+TEST(SystemSensors, meminfo_entry) {
+    TempDir dir;
+    const auto meminfo = dir.path / "meminfo";
+    write_file(meminfo, "MemTotal:        3884096 kB\nMemFree:          214000 kB\nMemAvailable:    2048000 kB\n");
+
+    MemInfoSensor sensor("mem_available", "MiB", "MemAvailable", 1.0 / 1024, meminfo.string());
+    ASSERT_TRUE(sensor.init());
+    EXPECT_DOUBLE_EQ(sensor.sample()->value, 2000.0);
+
+    MemInfoSensor missing("swap", "kB", "SwapFree", 1.0, meminfo.string());
+    EXPECT_FALSE(missing.init());
+}
+
+TEST(SystemSensors, netdev_rate) {
+    TempDir dir;
+    const auto dev = dir.path / "dev";
+    write_file(dev, std::string(k_net_dev) +
+               "  eth0: 5000 40 0 0 0 0 0 0 7000 50 0 0 0 0 0 0\n");
+
+    NetDevSensor sensor("eth0_tx", "B/s", "eth0", "tx_bytes", dev.string());
+    ASSERT_TRUE(sensor.init());
+    write_file(dev, std::string(k_net_dev) +
+               "  eth0: 5000 40 0 0 0 0 0 0 9000 60 0 0 0 0 0 0\n");
+    const auto reading = sensor.sample();
+    ASSERT_TRUE(reading);
+    EXPECT_GT(reading->value, 0.0);
+
+    EXPECT_EQ(NetDevSensor::field_index("rx_bytes"), 0);
+    EXPECT_EQ(NetDevSensor::field_index("tx_bytes"), 8);
+    EXPECT_EQ(NetDevSensor::field_index("collisions"), -1);
+    NetDevSensor unknown_field("x", "", "eth0", "collisions", dev.string());
+    EXPECT_FALSE(unknown_field.init());
+    NetDevSensor unknown_iface("x", "", "wlan0", "rx_bytes", dev.string());
+    EXPECT_FALSE(unknown_iface.init());
+}
+
+TEST(SystemSensors, sysfs_value_is_rescanned_without_reopen) {
+    TempDir dir;
+    const auto temp = dir.path / "temp";
+    write_file(temp, "48312\n");
+
+    SysfsValueSensor sensor("soc_temp", "C", temp.string(), 0.001);
+    ASSERT_TRUE(sensor.init());
+    EXPECT_DOUBLE_EQ(sensor.sample()->value, 48.312);
+    write_file(temp, "51000\n");
+    EXPECT_DOUBLE_EQ(sensor.sample()->value, 51.0);
+
+    write_file(temp, "garbage\n");
+    EXPECT_FALSE(sensor.sample());
+}
+
+TEST(SystemSensors, factory_maps_types_and_defaults) {
+    TempDir dir;
+    const auto temp = dir.path / "temp1_input";
+    write_file(temp, "1500\n");
+
+    MetricConfig metric;
+    metric.name = "board_temp";
+    metric.type = "thermal";
+    metric.source = temp.string(); // absolute paths are used as-is
+    auto sensor = make_sensor(metric);
+    ASSERT_TRUE(sensor->init());
+    EXPECT_DOUBLE_EQ(sensor->sample()->value, 1.5);
+
+    metric.type = "hwmon";
+    metric.scale = 1.0;
+    sensor = make_sensor(metric);
+    ASSERT_TRUE(sensor->init());
+    EXPECT_DOUBLE_EQ(sensor->sample()->value, 1500.0);
+}
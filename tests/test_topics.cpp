@@ -23,4 +23,11 @@ TEST(Topics, health_topic_layout) {
 
     auto topic = make_health_topic(client_id);
     EXPECT_EQ(topic, "devices/pi-sim-01/health");
-}
\ No newline at end of file
+}
+
+TEST(Topics, batch_topic_layout) {
+    std::string client_id = "pi-sim-01";
+
+    auto topic = make_batch_topic(client_id);
+    EXPECT_EQ(topic, "devices/pi-sim-01/batch");
+}
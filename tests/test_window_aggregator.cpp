@@ -0,0 +1,161 @@
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+#include <cmath>
+
+#include "app_config.h"
+#include "telemetry_payload.h"
+#include "window_aggregator.h"
+
+namespace {
+    WindowAggregator::Spec spec(std::uint32_t window_ms, std::uint32_t slide_ms, std::uint32_t interval_ms,
+                                bool percentiles = false, std::uint32_t max_samples = 1024) {
+        WindowAggregator::Spec out;
+        out.window_ms = window_ms;
+        out.slide_ms = slide_ms;
+        out.interval_ms = interval_ms;
+        out.percentiles = percentiles;
+        out.max_samples = max_samples;
+        return out;
+    }
+}
+
+TEST(WindowAggregator, tumbling_window_statistics) {
+    WindowAggregator agg;
+    const auto slot = agg.add_metric(spec(1000, 1000, 250));
+    for (double v : {2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0}) agg.add(slot, v);
+
+    const auto s = agg.close_pane(slot);
+    EXPECT_EQ(s.count, 8u);
+    EXPECT_DOUBLE_EQ(s.min, 2.0);
+    EXPECT_DOUBLE_EQ(s.max, 9.0);
+    EXPECT_DOUBLE_EQ(s.mean, 5.0);
+    EXPECT_DOUBLE_EQ(s.stddev, 2.0);
+    EXPECT_EQ(s.window_ms, 1000u);
+    EXPECT_FALSE(s.has_percentiles);
+
+    // the next window starts empty
+    EXPECT_EQ(agg.close_pane(slot).count, 0u);
+    agg.add(slot, 1.0);
+    const auto next = agg.close_pane(slot);
+    EXPECT_EQ(next.count, 1u);
+    EXPECT_DOUBLE_EQ(next.mean, 1.0);
+    EXPECT_DOUBLE_EQ(next.stddev, 0.0);
+}
+
+TEST(WindowAggregator, sliding_window_covers_the_last_panes) {
+    WindowAggregator agg;
+    const auto slot = agg.add_metric(spec(3000, 1000, 1000));
+
+    agg.add(slot, 1.0);
+    EXPECT_EQ(agg.close_pane(slot).count, 1u);
+    agg.add(slot, 2.0);
+    EXPECT_DOUBLE_EQ(agg.close_pane(slot).mean, 1.5);
+    agg.add(slot, 3.0);
+    auto s = agg.close_pane(slot);
+    EXPECT_EQ(s.count, 3u);
+    EXPECT_DOUBLE_EQ(s.min, 1.0);
+    EXPECT_DOUBLE_EQ(s.max, 3.0);
+
+    agg.add(slot, 10.0); // the pane holding 1.0 slides out
+    s = agg.close_pane(slot);
+    EXPECT_EQ(s.count, 3u);
+    EXPECT_DOUBLE_EQ(s.min, 2.0);
+    EXPECT_DOUBLE_EQ(s.max, 10.0);
+    EXPECT_DOUBLE_EQ(s.mean, 5.0);
+}
+
+TEST(WindowAggregator, metrics_are_independent_and_large_offsets_stay_precise) {
+    WindowAggregator agg;
+    const auto a = agg.add_metric(spec(1000, 1000, 1));
+    const auto b = agg.add_metric(spec(1000, 1000, 1));
+    for (int i = 0; i < 1000; ++i) {
+        agg.add(a, 101325.0 + (i % 2 ? 0.5 : -0.5));
+        agg.add(b, static_cast<double>(i));
+    }
+    agg.add(a, std::nan(""));
+
+    const auto sa = agg.close_pane(a);
+    EXPECT_EQ(sa.count, 1000u);
+    EXPECT_DOUBLE_EQ(sa.mean, 101325.0);
+    EXPECT_NEAR(sa.stddev, 0.5, 1e-9);
+
+    const auto sb = agg.close_pane(b);
+    EXPECT_DOUBLE_EQ(sb.min, 0.0);
+    EXPECT_DOUBLE_EQ(sb.max, 999.0);
+    EXPECT_DOUBLE_EQ(sb.mean, 499.5);
+}
+
+TEST(WindowAggregator, percentiles_exact_below_the_sample_cap) {
+    WindowAggregator agg;
+    const auto slot = agg.add_metric(spec(1000, 1000, 10, true));
+    for (int i = 100; i >= 1; --i) agg.add(slot, static_cast<double>(i));
+
+    const auto s = agg.close_pane(slot);
+    ASSERT_TRUE(s.has_percentiles);
+    EXPECT_DOUBLE_EQ(s.p50, 50.0);
+    EXPECT_DOUBLE_EQ(s.p90, 90.0);
+    EXPECT_DOUBLE_EQ(s.p99, 99.0);
+}
+
+TEST(WindowAggregator, percentiles_decimated_at_high_rates) {
+    // 1 kHz over 1 s with room for 100 samples keeps every 11th
+    WindowAggregator agg;
+    const auto slot = agg.add_metric(spec(1000, 1000, 1, true, 100));
+    for (int i = 0; i < 1000; ++i) agg.add(slot, static_cast<double>(i));
+
+    const auto s = agg.close_pane(slot);
+    EXPECT_EQ(s.count, 1000u);
+    EXPECT_NEAR(s.p50, 500.0, 15.0);
+    EXPECT_NEAR(s.p90, 900.0, 15.0);
+    EXPECT_NEAR(s.p99, 990.0, 15.0);
+}
+
+TEST(WindowAggregator, sliding_percentiles_forget_old_panes) {
+    WindowAggregator agg;
+    const auto slot = agg.add_metric(spec(2000, 1000, 100, true));
+    for (int i = 0; i < 10; ++i) agg.add(slot, 1000.0);
+    (void)agg.close_pane(slot);
+    for (int i = 0; i < 10; ++i) agg.add(slot, 1.0);
+    EXPECT_DOUBLE_EQ(agg.close_pane(slot).p99, 1000.0);
+    for (int i = 0; i < 10; ++i) agg.add(slot, 2.0);
+    EXPECT_DOUBLE_EQ(agg.close_pane(slot).p99, 2.0);
+}
+
+TEST(WindowAggregator, summary_payload_keeps_mean_as_value) {
+    WindowSummary summary;
+    summary.count = 4;
+    summary.min = 1.0;
+    summary.max = 4.0;
+    summary.mean = 2.5;
+    summary.stddev = 1.25;
+    summary.window_ms = 1000;
+
+    auto payload = make_summary_payload_v1("pi-sim-01", "vibration", "g", summary, 7, 1771375777);
+    EXPECT_EQ(payload["metric"]["value"], 2.5);
+    EXPECT_EQ(payload["window"]["count"], 4);
+    EXPECT_FALSE(payload["window"].contains("p50"));
+
+    summary.has_percentiles = true;
+    summary.p99 = 4.0;
+    payload = make_summary_payload_v1("pi-sim-01", "vibration", "g", summary, 7, 1771375777);
+    EXPECT_EQ(payload["window"]["p99"], 4.0);
+}
+
+TEST(WindowAggregator, config_validation) {
+    nlohmann::json jsn = {
+        {"client_id", "pi-sim-01"},
+        {"interval_ms", 1000},
+        {"metrics", nlohmann::json::array({ {{"name", "vibration"}, {"topic_suffix", "vib"}, {"interval_ms", 1},
+                                             {"aggregate", {{"window_ms", 1000}, {"percentiles", true}}}} })}
+    };
+    const auto cfg = parse_config_or_throw(jsn);
+    EXPECT_EQ(cfg.metrics[0].aggregate.slide_ms, 1000); // tumbling by default
+    EXPECT_TRUE(cfg.metrics[0].aggregate.percentiles);
+
+    jsn["metrics"][0]["aggregate"]["slide_ms"] = 300;   // does not divide the window
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+
+    jsn["metrics"][0]["aggregate"]["slide_ms"] = 250;
+    jsn["metrics"][0]["deadband_abs"] = 0.1;
+    EXPECT_THROW(parse_config_or_throw(jsn), std::runtime_error);
+}